@@ -12,22 +12,44 @@
 #include <stdio.h>  // Para funcoes de entrada/saida.
 #include <stdlib.h> // Para funcoes como atof (converter string para float).
 #include <string.h> // Para manipulacao de strings.
-#include <math.h>   // Para funcoes matematicas (ex: pow para calculo de altitude).
+#include <strings.h> // Para strncasecmp (cabecalhos HTTP nao diferenciam maiusculas).
+#include <math.h>   // Para funcoes matematicas (ex: lroundf nas amostras do WebSocket).
+#include <stdarg.h> // Para http_tx_printf.
 
 #include "pico/stdlib.h"     // Funcoes essenciais do Pico SDK.
 #include "pico/cyw43_arch.h" // Biblioteca para arquitetura Wi-Fi da Pico com CYW43.
+#include "pico/multicore.h"  // Nucleo 1, dedicado a leitura dos sensores.
+#include "pico/flash.h"      // flash_safe_execute_core_init, para o nucleo 1 pausar enquanto a flash eh gravada.
 #include "hardware/i2c.h"    // Funcoes para controle do periferico I2C, usado para comunicacao com os sensores.
 #include "hardware/gpio.h"   // Funcoes para controle dos pinos de entrada/saida (GPIO), usado para LEDs, buzzer e botoes, incluindo interrupcoes.
 #include "hardware/clocks.h" // Clocks para o arquivo blink.pio.
 #include "hardware/pio.h"    // PIO para a matriz de LEDs.
+#include "hardware/flash.h"  // FLASH_SECTOR_SIZE, para posicionar o arquivo de medicoes na flash.
 
 #include "lib/matriz.h" // Arquivo da pasta lib/ que contem o alerta que aparecera na matriz de LEDs.
 #include "blink.pio.h"  // Arquivo em assembly para comunicacao com a matriz.
+#include "web_pages.h"  // Paginas HTML comprimidas, geradas a partir de web/ durante a compilacao.
 
 #include "lwip/tcp.h" // Funcoes para a pilha de rede TCP/IP, essencial para criar o servidor web.
-
-#include "aht20.h"  // Arquivo para o sensor de temperatura e umidade AHT20.
-#include "bmp280.h" // Arquivo para o sensor de pressao BMP280.
+#include "lwip/stats.h" // Uso do heap e dos pools do lwIP (MEM_STATS e MEMP_STATS), exposto em /metrics.
+
+#include "mbedtls/sha1.h"   // SHA-1 para o handshake do WebSocket.
+#include "mbedtls/base64.h" // Base64 para o cabecalho Sec-WebSocket-Accept.
+
+#include "aht20.h"       // Arquivo para o sensor de temperatura e umidade AHT20.
+#include "bmp280.h"      // Arquivo para o sensor de pressao BMP280.
+#include "i2c_dma.h"     // Transacoes I2C por DMA, usadas para ler os dois sensores sem ocupar a CPU.
+#include "sensor_ring.h" // Fila sem trava que leva as amostras do nucleo 1 ao nucleo 0.
+#include "seqlock.h"     // Copias consistentes da configuracao e da ultima amostra.
+#include "history.h"     // Historico das ultimas amostras, servido por /history.
+#include "rollup.h"      // Minimo, maximo e media por minuto, hora e dia, servidos por /history?res=.
+#include "flash_log.h"   // Medias por minuto compactadas na flash, servidas por /archive.
+#include "config_store.h" // Configuracao gravada na flash, recarregada a cada boot.
+#include "sensor_pipeline.h" // Compensacao, offsets, altitude e alertas de cada amostra (estacao_config_t).
+#include "sensor_trace.h"    // Trace das leituras brutas, enviado pela USB para repetir no computador.
+#include "perf_trace.h"      // Spans com tempo e ciclos de cada trecho, exportados em /trace e pela USB.
+#include "histogram.h"       // Histogramas de baldes fixos das latencias e do jitter, servidos por /metrics.
+#include "heap.h"            // Heap livre, servido por /metrics.
 
 //-------------------------------------------Definicoes-------------------------------------------
 
@@ -52,11 +74,274 @@
 #define I2C_SCL_AHT 3
 
 // Constantes fisicas
-#define SEA_LEVEL_PRESSURE 101325.0 // Pressao ao nivel do mar em Pascal, para calculo de altitude.
-#define MAX_CHART_POINTS 20         // Numero maximo de pontos a serem exibidos nos graficos.
 
 #define DEBOUNCE_MS 500 // 500 ms para debounce dos botoes.
 
+#define SENSOR_READ_INTERVAL_MS 1000                  // Intervalo, em ms, entre leituras dos sensores.
+#define AHT20_TIMEOUT_MS 200                          // Tempo maximo, em ms, esperando o AHT20 concluir uma medicao.
+#define BMP280_SENSOR_PROFILE BMP280_PROFILE_STANDARD // Perfil de oversampling/filtro do BMP280 (lib/bmp280.h).
+
+// Conteudo estatico gerado em web_pages.h
+#define HTML_CONTENT_TYPE "text/html; charset=utf-8"                 // Content-Type das paginas.
+#define PAGE_CACHE_CONTROL "no-cache"                             // Paginas sao revalidadas a cada acesso (304 se nao mudaram).
+#define ASSET_CACHE_CONTROL "public, max-age=31536000, immutable" // Cache-Control dos arquivos de /assets.
+
+// Configuracao do servidor HTTP
+#define HTTP_MAX_CONNECTIONS 10       // Numero maximo de conexoes simultaneas (pool fixo de contextos).
+#define HTTP_REQUEST_BUFFER_SIZE 1024 // Tamanho maximo de uma requisicao (linha, cabecalhos e corpo).
+#define HTTP_METHOD_SIZE 8            // Tamanho maximo do metodo (GET, POST...).
+#define HTTP_PATH_SIZE 64             // Tamanho maximo do caminho requisitado.
+#define HTTP_QUERY_SIZE 64            // Tamanho maximo da query string.
+#define HTTP_ETAG_LIST_SIZE 80        // Tamanho maximo guardado do cabecalho If-None-Match.
+#define HTTP_POLL_INTERVAL 2          // Intervalo do tcp_poll, em unidades de 500 ms (1 s).
+#define HTTP_KEEPALIVE_TIMEOUT_S 15   // Tempo maximo, em segundos, que uma conexao persistente fica ociosa.
+#define HTTP_KEEPALIVE_MAX 100        // Numero maximo de requisicoes atendidas por conexao persistente.
+#define HTTP_EVENTS_PING_S 15         // Intervalo, em segundos, dos comentarios que mantem os streams SSE ativos.
+#define HTTP_TX_MAX_SEGMENTS 8        // Numero maximo de trechos em uma resposta.
+#define HTTP_TX_BUFFER_SIZE 768       // Espaco por conexao para as partes dinamicas (cabecalho, JSON).
+#define HTTP_HISTORY_LIMIT 100        // Pontos devolvidos por /history quando 'limit' nao eh informado.
+#define HTTP_ARCHIVE_LIMIT 1440       // Pontos devolvidos por /archive quando 'limit' nao eh informado (1 dia).
+
+// Trace de desempenho (lib/perf_trace.h)
+#define PERF_LOOP_MIN_US 500 // Voltas do loop principal (e chamadas de cyw43_arch_poll) mais curtas que isso nao entram no trace.
+
+// Loop principal e metricas (/metrics)
+#define MAIN_LOOP_SLEEP_MS 10        // Pausa ao fim de cada volta do loop principal; o que passar disso entre duas voltas eh jitter.
+#define WIFI_RSSI_INTERVAL_MS 5000   // Intervalo entre consultas do RSSI ao CYW43, feitas pelo loop principal.
+#define METRICS_PIECE_SIZE 320       // Maior trecho de /metrics formatado de uma vez (algumas linhas).
+
+// Intervalos agregados guardados em cada resolucao de /history?res=
+#define ROLLUP_1M_CAPACITY 240 // 4 horas em intervalos de 1 minuto.
+#define ROLLUP_1H_CAPACITY 168 // 1 semana em intervalos de 1 hora.
+#define ROLLUP_1D_CAPACITY 31  // 1 mes em intervalos de 1 dia.
+
+// Configuracao na flash (lib/config_store.h): os dois ultimos setores da flash de 2 MB.
+#define CONFIG_STORE_OFFSET (PICO_FLASH_SIZE_BYTES - CONFIG_STORE_SECTORS * FLASH_SECTOR_SIZE)
+#define CONFIG_KEY_ESTACAO 1     // Chave de estacao_config_t no armazenamento.
+#define CONFIG_SAVE_DELAY_MS 5000 // Espera, apos o ultimo POST /config, antes de gravar (varios envios seguidos viram uma gravacao).
+
+// Arquivo de medicoes na flash (lib/flash_log.h): as medias de cada minuto, cerca de 6 bytes cada, ocupam
+// uns 9 KB por dia, entao 96 setores (384 KB) guardam mais de 40 dias. A regiao fica logo abaixo da
+// configuracao, no fim da flash, longe do firmware.
+#define FLASH_LOG_SECTORS 96
+#define FLASH_LOG_REGION_OFFSET (CONFIG_STORE_OFFSET - FLASH_LOG_SECTORS * FLASH_SECTOR_SIZE)
+
+// Configuracao do WebSocket (/ws)
+#define WS_KEY_SIZE 32             // Tamanho maximo do cabecalho Sec-WebSocket-Key (24 caracteres em base64).
+#define WS_MAX_QUEUED_FRAMES 8     // Amostras enfileiradas por cliente; as mais antigas sao descartadas.
+#define WS_MAX_CONTROL_PAYLOAD 125 // Maior payload de um frame de controle (ping/close), pela RFC 6455.
+#define WS_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+// Opcodes de frames WebSocket usados pelo servidor
+#define WS_OPCODE_BINARY 0x2
+#define WS_OPCODE_CLOSE 0x8
+#define WS_OPCODE_PING 0x9
+#define WS_OPCODE_PONG 0xA
+
+//-------------------------------------------Tipos-------------------------------------------
+
+// Etapas do processamento incremental de uma requisicao HTTP.
+typedef enum
+{
+    HTTP_STATE_REQUEST_LINE, // Aguardando a linha de requisicao (ex: "GET /estado HTTP/1.1").
+    HTTP_STATE_HEADERS,      // Lendo os cabecalhos ate a linha em branco.
+    HTTP_STATE_BODY,         // Aguardando os bytes do corpo indicados por Content-Length.
+    HTTP_STATE_COMPLETE,     // Requisicao completa, pronta para ser despachada.
+    HTTP_STATE_ERROR         // Requisicao invalida ou grande demais.
+} http_parse_state_t;
+
+// Modo de operacao de uma conexao HTTP.
+typedef enum
+{
+    HTTP_MODE_REQUEST,  // Requisicao/resposta convencional.
+    HTTP_MODE_EVENTS,   // Stream de Server-Sent Events (/events), mantido aberto para envio de eventos.
+    HTTP_MODE_WEBSOCKET // WebSocket (/ws) que recebe cada amostra como um frame binario.
+} http_mode_t;
+
+/*
+ * Amostra enviada pelo WebSocket como payload de um frame binario de 20 bytes. Todos os campos sao
+ * inteiros little-endian em ponto fixo, lidos no navegador com DataView.
+ */
+typedef struct __attribute__((packed))
+{
+    uint32_t timestamp_ms; // Instante da leitura, em ms desde o boot.
+    int32_t temperatura;   // Centesimos de grau Celsius.
+    int32_t umidade;       // Centesimos de ponto percentual.
+    int32_t pressao;       // Pascal (milesimos de kPa).
+    int32_t altitude;      // Centimetros.
+} ws_sample_t;
+
+// Tipos de trecho de uma resposta.
+typedef enum
+{
+    HTTP_SEGMENT_STATIC,   // Constante em flash, entregue ao lwIP sem copia.
+    HTTP_SEGMENT_DYNAMIC,  // Texto formatado em tx_buffer, copiado pelo lwIP (TCP_WRITE_FLAG_COPY).
+    HTTP_SEGMENT_GENERATOR // Corpo produzido sob demanda, em pedacos, com Transfer-Encoding: chunked.
+} http_segment_type_t;
+
+/*
+ * Gera o proximo pedaco de um corpo produzido sob demanda. Escreve ate 'size' bytes em 'buffer' e
+ * retorna quantos foram escritos; retornar 0 encerra o corpo. 'cursor' guarda a posicao entre chamadas.
+ */
+typedef uint16_t (*http_generator_t)(char *buffer, uint16_t size, uint32_t *cursor, void *arg);
+
+// Trecho de uma resposta.
+typedef struct
+{
+    http_segment_type_t type;  // Tipo do trecho.
+    const char *data;          // Inicio do trecho (estatico ou dinamico).
+    uint16_t length;           // Tamanho do trecho, em bytes (estatico ou dinamico).
+    http_generator_t generate; // Funcao que produz o corpo (gerador).
+    void *arg;                 // Argumento repassado ao gerador.
+    uint32_t cursor;           // Posicao do gerador.
+    bool finished;             // O gerador ja produziu o ultimo pedaco.
+} http_tx_segment_t;
+
+// Trechos medidos pelo trace de desempenho; nome e categoria de cada um ficam em PERF_SPANS.
+typedef enum
+{
+    PERF_SPAN_SENSOR_CYCLE, // Ciclo completo do nucleo 1, do disparo das medicoes a matriz de LEDs (arg: amostra).
+    PERF_SPAN_SENSOR_READ,  // Leitura dos dois sensores por DMA (arg: tentativa).
+    PERF_SPAN_COMPENSATION, // Decodificacao e compensacao das leituras brutas (arg: tentativa).
+    PERF_SPAN_SAMPLE,       // Offsets, altitude e alertas.
+    PERF_SPAN_LED_UPDATE,   // Matriz de LEDs, incluindo a espera de 500 ms do alerta (arg: 1 em alerta).
+    PERF_SPAN_LOOP,         // Volta do loop principal, sem o sleep_ms final.
+    PERF_SPAN_WIFI_POLL,    // cyw43_arch_poll.
+    PERF_SPAN_PUBLISH,      // Publicacao das amostras do nucleo 1 (arg: amostras publicadas).
+    PERF_SPAN_CONFIG_SAVE,  // Gravacao da configuracao na flash.
+    PERF_SPAN_FLASH_FLUSH,  // Gravacao de um setor do arquivo na flash.
+    PERF_SPAN_TCP_RECV,     // tcp_server_recv (arg: bytes recebidos).
+    PERF_SPAN_HTTP_ROUTE,   // Funcao da rota (arg: indice em HTTP_ROUTES, HTTP_ROUTE_ASSETS ou HTTP_ROUTE_UNMATCHED).
+    PERF_SPAN_TCP_WRITE,    // tcp_write (arg: bytes).
+    PERF_SPAN_TCP_OUTPUT,   // tcp_output.
+    PERF_SPAN_COUNT
+} perf_span_id_t;
+
+// Contadores de falhas dos sensores, incrementados apenas pelo nucleo 1.
+typedef struct
+{
+    uint32_t aht20_i2c_errors;  // Transacoes I2C com o AHT20 que falharam (disparo ou leitura por DMA).
+    uint32_t aht20_retries;     // Leituras repetidas porque o AHT20 ainda estava convertendo.
+    uint32_t aht20_crc_errors;  // Leituras do AHT20 recusadas pelo CRC.
+    uint32_t aht20_failures;    // Ciclos em que a leitura anterior do AHT20 foi mantida.
+    uint32_t bmp280_i2c_errors; // Transacoes I2C com o BMP280 que falharam (disparo ou leitura por DMA).
+    uint32_t bmp280_failures;   // Ciclos em que a leitura anterior do BMP280 foi mantida.
+} sensor_counters_t;
+
+// Requisicoes e latencias de uma rota, servidas por /metrics.
+typedef struct
+{
+    uint32_t requests;   // Requisicoes despachadas para a rota.
+    histogram_t latency; // Do despacho ate a resposta inteira entregue ao lwIP.
+} http_route_metrics_t;
+
+// Nome e categoria de um trecho no JSON do trace de desempenho.
+typedef struct
+{
+    const char *name;     // Nome mostrado no visualizador (rotas usam metodo e caminho).
+    const char *category; // Categoria, para filtrar no visualizador.
+} perf_span_info_t;
+
+// Posicao de uma exportacao do trace de desempenho (/trace ou comando 'p' na USB).
+typedef struct
+{
+    uint64_t now_us;                // Instante da exportacao, para reconstruir os 64 bits do timer.
+    uint32_t end[PERF_TRACE_CORES]; // Ultimo span de cada nucleo incluido; os mais novos ficam de fora.
+    uint32_t next;                  // Proximo span a exportar do nucleo 'core'.
+    uint8_t core;                   // Nucleo sendo exportado.
+} perf_export_t;
+
+// Contexto de uma conexao HTTP, associado ao PCB via tcp_arg.
+typedef struct
+{
+    bool in_use;                                         // Indica se o contexto esta alocado para uma conexao.
+    struct tcp_pcb *pcb;                                 // PCB da conexao.
+    http_parse_state_t state;                            // Etapa atual do processamento.
+    char buffer[HTTP_REQUEST_BUFFER_SIZE];               // Bytes acumulados da requisicao.
+    uint16_t length;                                     // Quantidade de bytes acumulados no buffer.
+    uint16_t line_start;                                 // Inicio da linha que esta sendo processada.
+    uint16_t scan_pos;                                   // Posicao a partir da qual o fim da linha eh procurado.
+    uint16_t body_start;                                 // Inicio do corpo dentro do buffer.
+    uint16_t content_length;                             // Tamanho do corpo informado no cabecalho Content-Length.
+    char method[HTTP_METHOD_SIZE];                       // Metodo da requisicao.
+    char path[HTTP_PATH_SIZE];                           // Caminho da requisicao, sem a query string.
+    char query[HTTP_QUERY_SIZE];                         // Query string (o que vem depois de '?'), sem o '?'.
+    bool keep_alive;                                     // Mantem a conexao aberta apos a resposta (HTTP/1.1 ou "Connection: keep-alive").
+    uint16_t requests_served;                            // Quantidade de requisicoes ja respondidas nesta conexao.
+    uint16_t idle_seconds;                               // Tempo, em segundos, desde o ultimo byte recebido.
+    http_mode_t mode;                                    // Modo de operacao da conexao.
+    const char *pending_navigate;                        // Evento de navegacao que nao coube no buffer de envio (apenas SSE).
+    bool upgrade_websocket;                              // A requisicao pediu "Upgrade: websocket".
+    char ws_key[WS_KEY_SIZE];                            // Valor de Sec-WebSocket-Key recebido no handshake.
+    char if_none_match[HTTP_ETAG_LIST_SIZE];             // ETags que o navegador ja tem em cache (If-None-Match).
+    ws_sample_t ws_queue[WS_MAX_QUEUED_FRAMES];          // Amostras aguardando espaco no buffer de envio.
+    uint8_t ws_queue_head;                               // Indice da amostra mais antiga na fila.
+    uint8_t ws_queue_count;                              // Quantidade de amostras na fila.
+    struct pbuf *rx_pending;                             // Dados recebidos que ainda nao couberam no buffer.
+    uint16_t rx_offset;                                  // Quantos bytes de rx_pending ja foram copiados.
+    http_tx_segment_t tx_segments[HTTP_TX_MAX_SEGMENTS]; // Trechos da resposta em andamento.
+    uint8_t tx_count;                                    // Quantidade de trechos da resposta.
+    uint8_t tx_index;                                    // Trecho que esta sendo entregue ao lwIP.
+    uint16_t tx_offset;                                  // Bytes do trecho (ou pedaco gerado) atual ja entregues ao lwIP.
+    char tx_buffer[HTTP_TX_BUFFER_SIZE];                 // Partes dinamicas da resposta; o espaco livre recebe os pedacos gerados.
+    uint16_t tx_buffer_used;                             // Bytes ocupados pelas partes dinamicas em tx_buffer.
+    uint16_t tx_generated;                               // Tamanho do pedaco gerado que esta sendo entregue.
+    uint32_t tx_unacked;                                 // Bytes entregues ao lwIP e ainda nao confirmados pelo cliente.
+    const struct history_resolution *history_res;        // Resolucao agregada pedida em /history (NULL: amostras).
+    uint32_t history_next;                               // Proxima amostra (ou intervalo) a enviar em /history.
+    uint32_t history_end;                                // Ultima amostra (ou intervalo) a enviar em /history.
+    flash_log_reader_t archive_reader;                   // Posicao de /archive no arquivo da flash.
+    uint32_t archive_remaining;                          // Pontos que ainda faltam enviar em /archive.
+    perf_export_t trace_export;                          // Posicao de /trace no trace de desempenho.
+    uint16_t metrics_route;                              // Rota da resposta em andamento (indice de http_dispatch).
+    uint32_t metrics_start_us;                           // Inicio do despacho da resposta em andamento.
+    bool metrics_pending;                                // A latencia da resposta em andamento ainda nao foi registrada.
+    histogram_t metrics_histogram;                       // Copia do histograma que /metrics esta enviando.
+    bool close_after_tx;                                 // Fecha a conexao assim que a resposta for confirmada.
+} http_connection_t;
+
+// Funcao que atende uma rota; monta a resposta com as funcoes send_* / http_tx_*.
+typedef void (*http_route_handler_t)(http_connection_t *conn);
+
+// Resolucao agregada do historico, escolhida em /history pelo parametro res.
+typedef struct history_resolution
+{
+    const char *name;          // Valor de res (ex.: "1h").
+    uint32_t period_ms;        // Duracao de cada intervalo.
+    rollup_bucket_t *buckets;  // Memoria dos intervalos fechados.
+    uint16_t capacity;         // Quantidade de intervalos guardados.
+    bool archive;              // As medias dos intervalos fechados vao tambem para o arquivo na flash.
+    rollup_t rollup;           // Agregados mantidos a cada amostra.
+} history_resolution_t;
+
+// Etapas do gerador do corpo de /history, guardadas no cursor do trecho.
+typedef enum
+{
+    HISTORY_STEP_OPEN,        // Falta a abertura do objeto JSON.
+    HISTORY_STEP_FIRST_POINT, // Proximo ponto eh o primeiro (sem virgula antes).
+    HISTORY_STEP_POINTS,      // Proximo ponto vem depois de outro.
+    HISTORY_STEP_DONE         // Objeto fechado.
+} history_step_t;
+
+// Secoes do corpo de /metrics. O cursor do gerador guarda a secao nos 8 bits altos e a linha dentro dela
+// nos demais.
+typedef enum
+{
+    METRICS_SECTION_GAUGES,      // Leituras, falhas dos sensores, heap, pools do lwIP, Wi-Fi e conexoes.
+    METRICS_SECTION_LOOP_JITTER, // Histograma do jitter do loop principal.
+    METRICS_SECTION_REQUESTS,    // Requisicoes por rota.
+    METRICS_SECTION_LATENCY,     // Histograma da latencia por rota.
+    METRICS_SECTION_COUNT
+} metrics_section_t;
+
+// Rota do servidor HTTP: metodo e caminho exato.
+typedef struct
+{
+    const char *path;             // Caminho exato, sem query string.
+    const char *method;           // Metodo aceito (GET, POST...).
+    http_route_handler_t handler; // Funcao que monta a resposta.
+} http_route_t;
+
 //-------------------------------------------Variaveis Globais-------------------------------------------
 
 // Variaveis para navegacao pelos botoes
@@ -65,18 +350,87 @@ const int G_NUM_PAGES = sizeof(G_PAGES);
 volatile int g_current_page_index = 0;                                                         // indice da pagina atual na lista G_PAGES.
 volatile const char *g_target_page = NULL;                                                     // Ponteiro para a URL que o navegador deve carregar. Eh setado pela interrupcao do botao.
 volatile uint32_t g_last_press_time = 0;                                                       // Armazena o tempo do ultimo clique para o debounce.
-
-// Variaveis de configuracao (offsets, maximos e minimos)
-volatile float g_temp_offset = 0.0f, g_temp_min = 10.0f, g_temp_max = 40.0f;
-volatile float g_umid_offset = 0.0f, g_umid_min = 60.0f, g_umid_max = 85.0f;
-volatile float g_press_offset = 0.0f, g_press_min = 85.0f, g_press_max = 105.0f;
-volatile float g_alt_offset = 0.0f, g_alt_min = 800.0f, g_alt_max = 900.0f;
-
-// Variaveis globais dos sensores
-volatile float g_temperatura = 0.0f;
-volatile float g_umidade = 0.0f;
-volatile float g_pressao = 0.0f;
-volatile float g_altitude = 0.0f;
+volatile bool g_navigate_event = false;                                                        // Avisa o loop principal que deve enviar o evento de navegacao aos streams SSE.
+
+// Configuracao (offsets, maximos e minimos). Escrita pelo servidor HTTP e lida pelo nucleo 1; sempre
+// acessada inteira por seqlock_write/seqlock_read, para nunca misturar valores de dois POSTs.
+static estacao_config_t g_config = {
+    .temp_offset = 0.0f, .temp_min = 10.0f, .temp_max = 40.0f,
+    .umid_offset = 0.0f, .umid_min = 60.0f, .umid_max = 85.0f,
+    .press_offset = 0.0f, .press_min = 85.0f, .press_max = 105.0f,
+    .alt_offset = 0.0f, .alt_min = 800.0f, .alt_max = 900.0f,
+};
+static seqlock_t g_config_lock;
+
+// Copia de g_config na flash. A gravacao eh feita pelo loop principal CONFIG_SAVE_DELAY_MS depois do ultimo
+// POST /config, que so marca g_config_dirty e adia g_config_save_at_ms.
+static config_store_t g_config_store;
+static volatile bool g_config_dirty = false;
+static volatile uint32_t g_config_save_at_ms = 0;
+
+// Ultima amostra publicada, lida por /estado. Escrita pelo loop principal dentro de
+// cyw43_arch_lwip_begin/end, para que um handler HTTP nunca interrompa a escrita.
+static sensor_sample_t g_estado;
+static seqlock_t g_estado_lock;
+
+// Amostras produzidas pelo nucleo 1 e consumidas pelo nucleo 0
+static sensor_ring_t g_sensor_ring;
+
+// Captura do trace das leituras brutas: ligada e desligada pelo comando 't' na USB (nucleo 0), lida pelo nucleo 1.
+static volatile bool g_trace_capture = false;
+
+// Falhas dos sensores, servidas por /metrics. So o nucleo 1 escreve, e cada campo tem 32 bits alinhados,
+// entao o nucleo 0 le sem trava.
+static volatile sensor_counters_t g_sensor_counters;
+
+// Atraso de cada volta do loop principal alem de MAIN_LOOP_SLEEP_MS. Escrito pelo loop principal dentro de
+// cyw43_arch_lwip_begin/end e lido por /metrics, como g_estado.
+static histogram_t g_loop_jitter;
+
+// Ultimo RSSI do Wi-Fi, consultado pelo loop principal a cada WIFI_RSSI_INTERVAL_MS.
+static volatile int32_t g_wifi_rssi = 0;
+static volatile bool g_wifi_rssi_ok = false;
+
+// Ultimas amostras, servidas por /history. Alterado e lido apenas no contexto do lwIP, assim como os agregados.
+static history_t g_history;
+
+// Agregados de /history?res=
+static rollup_bucket_t g_rollup_1m[ROLLUP_1M_CAPACITY];
+static rollup_bucket_t g_rollup_1h[ROLLUP_1H_CAPACITY];
+static rollup_bucket_t g_rollup_1d[ROLLUP_1D_CAPACITY];
+static history_resolution_t g_history_resolutions[] = {
+    {.name = "1m", .period_ms = 60 * 1000, .buckets = g_rollup_1m, .capacity = ROLLUP_1M_CAPACITY, .archive = true},
+    {.name = "1h", .period_ms = 60 * 60 * 1000, .buckets = g_rollup_1h, .capacity = ROLLUP_1H_CAPACITY},
+    {.name = "1d", .period_ms = 24 * 60 * 60 * 1000, .buckets = g_rollup_1d, .capacity = ROLLUP_1D_CAPACITY},
+};
+#define HISTORY_RESOLUTION_COUNT (sizeof(g_history_resolutions) / sizeof(g_history_resolutions[0]))
+
+// Medias por minuto guardadas na flash, que sobrevivem a reinicializacoes. Alterado e lido apenas no
+// contexto do lwIP; os setores cheios sao gravados pelo loop principal, depois de publicar as amostras.
+static flash_log_t g_flash_log;
+
+// Pool de contextos das conexoes HTTP
+static http_connection_t g_http_connections[HTTP_MAX_CONNECTIONS];
+
+// Spans dos dois nucleos (lib/perf_trace.h), exportados em /trace e pelo comando 'p' na USB. Cada nucleo
+// registra so no seu anel, sem trava.
+static perf_trace_t g_perf_trace;
+static const perf_span_info_t PERF_SPANS[PERF_SPAN_COUNT] = {
+    [PERF_SPAN_SENSOR_CYCLE] = {"sensor_cycle", "sensor"},
+    [PERF_SPAN_SENSOR_READ] = {"sensor_read", "sensor"},
+    [PERF_SPAN_COMPENSATION] = {"compensation", "sensor"},
+    [PERF_SPAN_SAMPLE] = {"sample", "sensor"},
+    [PERF_SPAN_LED_UPDATE] = {"led_update", "sensor"},
+    [PERF_SPAN_LOOP] = {"loop", "main"},
+    [PERF_SPAN_WIFI_POLL] = {"cyw43_arch_poll", "main"},
+    [PERF_SPAN_PUBLISH] = {"publish", "main"},
+    [PERF_SPAN_CONFIG_SAVE] = {"config_save", "flash"},
+    [PERF_SPAN_FLASH_FLUSH] = {"flash_flush", "flash"},
+    [PERF_SPAN_TCP_RECV] = {"tcp_recv", "tcp"},
+    [PERF_SPAN_HTTP_ROUTE] = {"route", "http"},
+    [PERF_SPAN_TCP_WRITE] = {"tcp_write", "tcp"},
+    [PERF_SPAN_TCP_OUTPUT] = {"tcp_output", "tcp"},
+};
 
 // Definicao global do PIO
 PIO pio;
@@ -85,185 +439,85 @@ uint sm;
 //----------------------------------------Prototipos de funcoes---------------------------------------
 
 void setup();
+void sensor_core_main();
 uint32_t matrix_rgb(double r, double g, double b);
 void desenho_pio(double *desenho, PIO pio, uint sm, float r, float g, float b);
 void gpio_callback(uint gpio, uint32_t events);
 static void start_http_server();
-float calculate_altitude(float pressure_pa);
 static err_t send_chunk(struct tcp_pcb *tpcb, const char *data);
-void send_full_response(struct tcp_pcb *tpcb, const char *content_template);
-void send_json_response(struct tcp_pcb *tpcb, const char *payload);
-void parse_post_data(const char *data);
+static err_t http_tcp_write(struct tcp_pcb *tpcb, const void *data, u16_t length, u8_t flags);
+static err_t http_tcp_output(struct tcp_pcb *tpcb);
+static bool http_tx_add_static(http_connection_t *conn, const char *data, uint16_t length);
+static bool http_tx_add_copy(http_connection_t *conn, const char *data, uint16_t length);
+static int http_tx_printf(http_connection_t *conn, const char *format, ...);
+static bool http_tx_add_generator(http_connection_t *conn, http_generator_t generate, void *arg);
+static bool http_tx_busy(const http_connection_t *conn);
+static err_t http_tx_finish(http_connection_t *conn);
+static err_t http_tx_pump(http_connection_t *conn);
+static int format_http_header(http_connection_t *conn, char *buffer, size_t size, const char *status,
+                              const char *content_type, const char *extra_headers, int content_len);
+void send_gzip_response(http_connection_t *conn, const char *content_type, const char *cache_control,
+                        const char *etag, const uint8_t *body, uint16_t body_len);
+static bool http_etag_matches(const http_connection_t *conn, const char *etag);
+static const web_asset_t *web_asset_find(const char *path);
+void send_json_response(http_connection_t *conn, const char *payload);
+void send_empty_response(http_connection_t *conn, const char *status);
+void send_empty_response_with(http_connection_t *conn, const char *status, const char *extra_headers);
+static int format_estado_json(char *buffer, size_t size, const sensor_sample_t *amostra);
+static void http_start_event_stream(http_connection_t *conn);
+static bool sse_send(http_connection_t *conn, const char *event, const char *data);
+void sse_broadcast(const char *event, const char *data);
+static void http_start_websocket(http_connection_t *conn);
+static void ws_send_frame(struct tcp_pcb *tpcb, uint8_t opcode, const void *payload, uint8_t len);
+static void ws_flush_queue(http_connection_t *conn);
+void ws_broadcast_sample(const ws_sample_t *sample);
+static bool ws_process_frames(http_connection_t *conn);
+static bool http_query_param(const http_connection_t *conn, const char *key, char *value, size_t size);
+static bool http_query_uint(const http_connection_t *conn, const char *key, uint32_t *value);
+static void history_add(const sensor_sample_t *amostra);
+static void trace_emit(uint8_t type, const void *payload, uint8_t length);
+static void perf_export_start(perf_export_t *export);
+static uint16_t perf_export_generate(char *buffer, uint16_t size, uint32_t *cursor, void *arg);
+static void perf_export_usb();
+static uint16_t metrics_generate(char *buffer, uint16_t size, uint32_t *cursor, void *arg);
+void parse_post_data(const char *data, size_t length);
+static http_connection_t *http_connection_alloc(struct tcp_pcb *pcb);
+static void http_connection_free(http_connection_t *conn);
+static bool http_connection_reclaim_idle();
+static err_t http_connection_close(http_connection_t *conn);
+static void http_parse(http_connection_t *conn);
+static uint16_t http_dispatch(http_connection_t *conn);
+static void http_metrics_response_done(http_connection_t *conn);
+static void http_consume_request(http_connection_t *conn);
+static err_t http_connection_process(http_connection_t *conn);
 static err_t tcp_server_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err);
+static void tcp_server_err(void *arg, err_t err);
+static err_t tcp_server_poll(void *arg, struct tcp_pcb *tpcb);
+static err_t tcp_server_sent(void *arg, struct tcp_pcb *tpcb, u16_t len);
 void tocar_buzzer(uint freq, uint duracao);
 
-//-------------------------------------------HTML-------------------------------------------
-
-// Contem o cabecalho HTML, CSS para estilizacao e o script de navegacao por botao.
-const char HTML_HEADER[] =
-    "<!DOCTYPE html><html lang='pt-BR'><head><meta charset='UTF-8'>"
-    "<meta name='viewport' content='width=device-width, initial-scale=1'>"
-    "<title>Web Display</title>"
-    "<link href='https://cdn.jsdelivr.net/npm/bootstrap@5.3.3/dist/css/bootstrap.min.css' rel='stylesheet'>"
-    "<script src='https://cdn.jsdelivr.net/npm/chart.js'></script>"
-    "<script src='https://cdn.jsdelivr.net/npm/chartjs-plugin-annotation@3.0.1/dist/chartjs-plugin-annotation.min.js'></script>"
-    "<style>"
-        "body { background-color: #f0f2f5; }"
-        ".card p { font-size: 2.5rem; font-weight: 300; margin-bottom: 0; }"
-        ".card .card-footer { font-size: 0.85rem; color: #6c757d; }"
-        ".form-grid-item { display: flex; flex-direction: column; text-align: left; }"
-    "</style>"
-    "<script>"
-        "function checkNavigation(){"
-        "fetch('/navigate').then(r=>r.json()).then(d=>{"
-        "if(d&&d.goto&&window.location.pathname!==d.goto){window.location.href=d.goto;}"
-        "}).catch(e=>{});"
-        "}"
-        "setInterval(checkNavigation,1200);"
-    "</script>"
-    "</head><body class='text-center'>";
-
-// Contem a barra de navegacao comum a todas as paginas.
-const char HTML_NAV[] =
-    "<nav class='navbar navbar-expand-lg navbar-light bg-white shadow-sm mb-4'>"
-        "<div class='container-fluid'>"
-            "<a class='navbar-brand' href='/'>Web Display</a>"
-            "<button class='navbar-toggler' type='button' data-bs-toggle='collapse' data-bs-target='#navbarNav'>"
-                "<span class='navbar-toggler-icon'></span>"
-            "</button>"
-            "<div class='collapse navbar-collapse' id='navbarNav'>"
-                "<ul class='navbar-nav me-auto mb-2 mb-lg-0'>"
-                    "<li class='nav-item'><a class='nav-link' href='/'>Início</a></li>"
-                    "<li class='nav-item'><a class='nav-link' href='/config'>Configurações</a></li>"
-                    "<li class='nav-item'><a class='nav-link' href='/temperatura'>Temperatura</a></li>"
-                    "<li class='nav-item'><a class='nav-link' href='/umidade'>Umidade</a></li>"
-                    "<li class='nav-item'><a class='nav-link' href='/pressao'>Pressão</a></li>"
-                    "<li class='nav-item'><a class='nav-link' href='/altitude'>Altitude</a></li>"
-                "</ul>"
-            "</div>"
-        "</div>"
-    "</nav>";
-
-// Contem o corpo da pagina inicial.
-const char HTML_CONTENT_INICIO[] =
-    "<main class='container'>"
-        "<h1>Painel de Controle</h1>"
-        "<div class='row g-4 justify-content-center mt-3' id='cards-container'>"
-            "<div class='col-12 col-md-6 col-lg-3'><div class='card shadow-sm'><div class='card-body'><h2>Temperatura</h2><p><span id='temp_valor'>--</span> °C</p></div></div></div>"
-            "<div class='col-12 col-md-6 col-lg-3'><div class='card shadow-sm'><div class='card-body'><h2>Umidade</h2><p><span id='umidade_valor'>--</span> %</p></div></div></div>"
-            "<div class='col-12 col-md-6 col-lg-3'><div class='card shadow-sm'><div class='card-body'><h2>Pressão</h2><p><span id='pressao_valor'>--</span> kPa</p></div></div></div>"
-            "<div class='col-12 col-md-6 col-lg-3'><div class='card shadow-sm'><div class='card-body'><h2>Altitude</h2><p><span id='alt_valor'>--</span> m</p></div></div></div>"
-        "</div>"
-    "</main>"
-    "<script>"
-    "function atualizarValores(){fetch('/estado').then(r=>r.json()).then(d=>{document.getElementById('temp_valor').innerText=d.temperatura.toFixed(2);document.getElementById('umidade_valor').innerText=d.umidade.toFixed(2);document.getElementById('pressao_valor').innerText=d.pressao.toFixed(3);document.getElementById('alt_valor').innerText=d.altitude.toFixed(2);}).catch(e=>console.error(e));}"
-    "setInterval(atualizarValores,2000);window.onload=atualizarValores;"
-    "</script>";
-
-// Contem o formulario da pagina de configuracoes.
-const char HTML_CONTENT_CONFIG[] =
-    "<main class='container d-flex justify-content-center'>"
-        "<div class='card shadow-sm' style='max-width: 800px; flex-grow: 1;'>"
-            "<div class='card-body'>"
-                "<h2 class='card-title'>Limites e Calibração</h2>"
-                "<form id='configForm' class='mt-4'>"
-                    "<h4>Temperatura (°C)</h4>"
-                    "<div class='row g-3 align-items-center mb-3'>"
-                        "<div class='col-md-4 form-grid-item'><label for='temp_min' class='form-label'>Mínimo:</label><input type='number' step='any' id='temp_min' name='temp_min' class='form-control'></div>"
-                        "<div class='col-md-4 form-grid-item'><label for='temp_max' class='form-label'>Máximo:</label><input type='number' step='any' id='temp_max' name='temp_max' class='form-control'></div>"
-                        "<div class='col-md-4 form-grid-item'><label for='temp_offset' class='form-label'>Offset:</label><input type='number' step='any' id='temp_offset' name='temp_offset' class='form-control'></div>"
-                    "</div><hr>"
-                    "<h4>Umidade (%)</h4>"
-                    "<div class='row g-3 align-items-center mb-3'>"
-                        "<div class='col-md-4 form-grid-item'><label for='umid_min' class='form-label'>Mínimo:</label><input type='number' step='any' id='umid_min' name='umid_min' class='form-control'></div>"
-                        "<div class='col-md-4 form-grid-item'><label for='umid_max' class='form-label'>Máximo:</label><input type='number' step='any' id='umid_max' name='umid_max' class='form-control'></div>"
-                        "<div class='col-md-4 form-grid-item'><label for='umid_offset' class='form-label'>Offset:</label><input type='number' step='any' id='umid_offset' name='umid_offset' class='form-control'></div>"
-                    "</div><hr>"
-                    "<h4>Pressão (kPa)</h4>"
-                    "<div class='row g-3 align-items-center mb-3'>"
-                        "<div class='col-md-4 form-grid-item'><label for='press_min' class='form-label'>Mínimo:</label><input type='number' step='any' id='press_min' name='press_min' class='form-control'></div>"
-                        "<div class='col-md-4 form-grid-item'><label for='press_max' class='form-label'>Máximo:</label><input type='number' step='any' id='press_max' name='press_max' class='form-control'></div>"
-                        "<div class='col-md-4 form-grid-item'><label for='press_offset' class='form-label'>Offset:</label><input type='number' step='any' id='press_offset' name='press_offset' class='form-control'></div>"
-                    "</div><hr>"
-                    "<h4>Altitude (m)</h4>"
-                    "<div class='row g-3 align-items-center mb-3'>"
-                        "<div class='col-md-4 form-grid-item'><label for='alt_min' class='form-label'>Mínimo:</label><input type='number' step='any' id='alt_min' name='alt_min' class='form-control'></div>"
-                        "<div class='col-md-4 form-grid-item'><label for='alt_max' class='form-label'>Máximo:</label><input type='number' step='any' id='alt_max' name='alt_max' class='form-control'></div>"
-                        "<div class='col-md-4 form-grid-item'><label for='alt_offset' class='form-label'>Offset:</label><input type='number' step='any' id='alt_offset' name='alt_offset' class='form-control'></div>"
-                    "</div>"
-                    "<button type='submit' class='btn btn-primary mt-3'>Salvar Configurações</button>"
-                    "<p id='saveStatus' class='mt-2' style='color:green; font-weight:bold;'></p>"
-                "</form>"
-            "</div></div>"
-    "</main>"
-    "<script>"
-    "window.onload=()=>{fetch('/getconfig').then(r=>r.json()).then(d=>{for(const key in d){let el=document.getElementById(key);if(el)el.value=d[key];}}).catch(e=>console.error('Erro:',e));};"
-    "document.getElementById('configForm').addEventListener('submit',e=>{"
-        "e.preventDefault();const formData=new FormData(e.target);const status=document.getElementById('saveStatus');"
-        "status.textContent='Salvando...';"
-        "fetch('/config',{method:'POST',body:new URLSearchParams(formData)})"
-        ".then(res=>{if(res.ok)status.textContent='Configurações salvas!';else status.textContent='Falha ao salvar.';setTimeout(()=>status.textContent='',3000);})"
-        ".catch(e=>{console.error(e);status.textContent='Erro de comunicação.';});"
-    "});"
-    "</script>";
-
-// Template generico para as paginas de grafico.
-const char HTML_CONTENT_CHART_PAGE[] =
-    "<h1 id='page-title'>Gráfico</h1>"
-    "<div class='container'><div class='card chart-card'><canvas id='chart'></canvas></div></div>"
-    "<script>"
-    "const page_configs={"
-    "'/temperatura':{key:'temperatura',sufix:'temp',title:'Temperatura',label:'Temperatura (°C)',color:'rgb(255,99,132)',alpha:'rgba(255,99,132,0.2)'},"
-    "'/umidade':{key:'umidade',sufix:'umid',title:'Umidade',label:'Umidade (%)',color:'rgb(54,162,235)',alpha:'rgba(54,162,235,0.2)'},"
-    "'/pressao':{key:'pressao',sufix:'press',title:'Pressão',label:'Pressão (kPa)',color:'rgb(75,192,192)',alpha:'rgba(75,192,192,0.2)'},"
-    "'/altitude':{key:'altitude',sufix:'alt',title:'Altitude',label:'Altitude (m)',color:'rgb(153,102,255)',alpha:'rgba(153,102,255,0.2)'}"
-    "};"
-    "const config=page_configs[window.location.pathname];"
-    "document.getElementById('page-title').textContent='Gráfico de '+config.title;"
-    "let chart;"
-    "function createChart(limits){"
-    "const min_val=limits[config.sufix+'_min'];const max_val=limits[config.sufix+'_max'];"
-    "const ctx=document.getElementById('chart').getContext('2d');"
-    "chart=new Chart(ctx,{type:'line',data:{labels:[],datasets:[{label:config.label,data:[],borderColor:config.color,backgroundColor:config.alpha,borderWidth:2,fill:true,tension:0.1}]},"
-    "options:{plugins:{annotation:{annotations:{"
-    "line_min:{type:'line',yMin:min_val,yMax:min_val,borderColor:'red',borderWidth:2,borderDash:[6,6],label:{content:'Mín: '+min_val,enabled:true,position:'start'}},"
-    "line_max:{type:'line',yMin:max_val,yMax:max_val,borderColor:'green',borderWidth:2,borderDash:[6,6],label:{content:'Máx: '+max_val,enabled:true,position:'start'}}"
-    "}}}}});"
-    "}"
-    "function addData(d){if(!chart)return;const t=new Date().toLocaleTimeString('pt-BR',{hour:'2-digit',minute:'2-digit',second:'2-digit'});chart.data.labels.push(t);chart.data.datasets[0].data.push(d);if(chart.data.labels.length>%d) {chart.data.labels.shift();chart.data.datasets[0].data.shift();}chart.update('none');}"
-    "function atualizarGrafico(){fetch('/estado').then(r=>r.json()).then(d=>addData(d[config.key])).catch(e=>console.error('Erro:',e));}"
-    "window.onload=()=>{fetch('/getconfig').then(r=>r.json()).then(limits=>{createChart(limits);atualizarGrafico();setInterval(atualizarGrafico,2000);}).catch(e=>console.error('Erro:',e));};"
-    "</script>";
-
-// Tag de fechamento comum a todas as paginas.
-const char HTML_FOOTER[] = 
-    "<script src='https://cdn.jsdelivr.net/npm/bootstrap@5.3.3/dist/js/bootstrap.bundle.min.js'></script>"
-    "</body></html>";
-
 //------------------------------------------------Main------------------------------------------------
 
 /*
- * Inicializa todo os sensores, conecta-se ao Wi-Fi, inicia o servidor web e entra no loop para
- * ler os sensores e manter a conexao.
+ * Conecta-se ao Wi-Fi, inicia o servidor web e coloca o nucleo 1 para ler os sensores. O nucleo 0
+ * fica so com a rede: repassa aos navegadores as amostras que chegam pela fila g_sensor_ring.
  */
 int main()
 {
     stdio_init_all();
+    perf_trace_init_core();
 
     setup();
 
-    // Inicializacao dos sensores I2C.
-    i2c_init(I2C_PORT_AHT20, 400 * 1000);
-    gpio_set_function(I2C_SDA_AHT, GPIO_FUNC_I2C);
-    gpio_set_function(I2C_SCL_AHT, GPIO_FUNC_I2C);
-    aht20_init(I2C_PORT_AHT20);
-
-    i2c_init(I2C_PORT_BMP280, 400 * 1000);
-    gpio_set_function(I2C_SDA_BMP, GPIO_FUNC_I2C);
-    gpio_set_function(I2C_SCL_BMP, GPIO_FUNC_I2C);
-    bmp280_init(I2C_PORT_BMP280);
-    struct bmp280_calib_param params;
-    bmp280_get_calib_params(I2C_PORT_BMP280, &params);
+    // Recupera a configuracao gravada antes que o nucleo 1 comece a usa-la.
+    config_store_init(&g_config_store, CONFIG_STORE_OFFSET);
+    estacao_config_t config_salva;
+    if (config_store_get(&g_config_store, CONFIG_KEY_ESTACAO, &config_salva, sizeof(config_salva)) ==
+        sizeof(config_salva))
+    {
+        seqlock_write(&g_config_lock, &g_config, &config_salva, sizeof(config_salva));
+        printf("Configuracao carregada da flash.\n");
+    }
 
     // Inicializacao e conexao Wi-Fi
     cyw43_arch_init();
@@ -290,60 +544,326 @@ int main()
     // Inicia o servidor web apos a conexao bem-sucedida.
     start_http_server();
 
-    uint32_t last_sensor_read_ms = 0;
+    for (size_t i = 0; i < HISTORY_RESOLUTION_COUNT; i++)
+    {
+        history_resolution_t *res = &g_history_resolutions[i];
+        rollup_init(&res->rollup, res->period_ms, res->buckets, res->capacity);
+    }
+
+    flash_log_init(&g_flash_log, FLASH_LOG_REGION_OFFSET, FLASH_LOG_SECTORS);
+    printf("Arquivo na flash: boot %u, proximo setor %lu.\n", g_flash_log.boot,
+           (unsigned long)g_flash_log.next_sequence);
+
+    // A partir daqui os sensores sao lidos pelo nucleo 1.
+    multicore_launch_core1(sensor_core_main);
+
+    uint32_t volta_anterior_us = time_us_32();
+    uint32_t proxima_consulta_rssi_ms = 0;
     while (true)
     {
+        perf_span_t volta = perf_span_begin();
 
+        // Jitter: quanto esta volta comecou depois da anterior alem do MAIN_LOOP_SLEEP_MS.
+        uint32_t intervalo_us = volta.start_us - volta_anterior_us;
+        volta_anterior_us = volta.start_us;
+        cyw43_arch_lwip_begin();
+        histogram_observe(&g_loop_jitter, intervalo_us > MAIN_LOOP_SLEEP_MS * 1000 ? intervalo_us - MAIN_LOOP_SLEEP_MS * 1000 : 0);
+        cyw43_arch_lwip_end();
+
+        perf_span_t poll = perf_span_begin();
         cyw43_arch_poll();
-        uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+        perf_trace_end_min(&g_perf_trace, poll, PERF_SPAN_WIFI_POLL, 0, PERF_LOOP_MIN_US);
 
-        // Leitura dos sensores, feita a cada 2 segundos.
-        if (now_ms - last_sensor_read_ms >= 2000)
+        // 't' recebido pela USB liga ou desliga a captura das leituras brutas (lib/sensor_trace.h);
+        // 'p' envia o trace de desempenho em JSON.
+        int comando = getchar_timeout_us(0);
+        if (comando == 't')
+        {
+            g_trace_capture = !g_trace_capture;
+            printf("Captura do trace %s.\n", g_trace_capture ? "ligada" : "desligada");
+        }
+        else if (comando == 'p')
         {
-            last_sensor_read_ms = now_ms;
+            perf_export_usb();
+        }
 
-            // Leitura dos dados
-            int32_t raw_temp_bmp, raw_pressure;
-            AHT20_Data data_aht;
-            bmp280_read_raw(I2C_PORT_BMP280, &raw_temp_bmp, &raw_pressure);
-            float pressure_pa = bmp280_convert_pressure(raw_pressure, raw_temp_bmp, &params);
-            aht20_read(I2C_PORT_AHT20, &data_aht);
+        // Repassa aos streams SSE a pagina escolhida pelos botoes.
+        if (g_navigate_event)
+        {
+            g_navigate_event = false;
+            char json_payload[128];
+            snprintf(json_payload, sizeof(json_payload), "{\"goto\":\"%s\"}", g_target_page);
+            cyw43_arch_lwip_begin();
+            sse_broadcast("navigate", json_payload);
+            cyw43_arch_lwip_end();
+        }
 
-            // Aplica os offsets de definidos na pagina pelo usuario
-            g_temperatura = data_aht.temperature + g_temp_offset;
-            g_umidade = data_aht.humidity + g_umid_offset;
-            g_pressao = (pressure_pa / 1000.0) + g_press_offset;
-            g_altitude = calculate_altitude(pressure_pa) + g_alt_offset;
+        // Publica as amostras produzidas pelo nucleo 1 desde a ultima volta do loop.
+        perf_span_t publicacao = perf_span_begin();
+        uint16_t publicadas = 0;
+        sensor_sample_t amostra;
+        while (sensor_ring_pop(&g_sensor_ring, &amostra))
+        {
+            publicadas++;
+            // Envia a nova leitura para todos os navegadores conectados em /events e /ws.
+            char json_payload[128];
+            format_estado_json(json_payload, sizeof(json_payload), &amostra);
+            ws_sample_t sample = {
+                .timestamp_ms = amostra.timestamp_ms,
+                .temperatura = (int32_t)lroundf(amostra.temperatura * 100.0f),
+                .umidade = (int32_t)lroundf(amostra.umidade * 100.0f),
+                .pressao = (int32_t)lroundf(amostra.pressao * 1000.0f),
+                .altitude = (int32_t)lroundf(amostra.altitude * 100.0f),
+            };
+            cyw43_arch_lwip_begin();
+            seqlock_write(&g_estado_lock, &g_estado, &amostra, sizeof(amostra));
+            history_add(&amostra);
+            sse_broadcast("reading", json_payload);
+            ws_broadcast_sample(&sample);
+            cyw43_arch_lwip_end();
+        }
+        if (publicadas > 0)
+        {
+            perf_trace_end(&g_perf_trace, publicacao, PERF_SPAN_PUBLISH, publicadas);
+        }
 
-            // Se os valores atuais passarem dos maximos ou dos minimos, aciona a matriz de LEDs
-            bool em_alerta = false;
+        // Grava a configuracao quando os POSTs param de chegar.
+        if (g_config_dirty && (int32_t)(to_ms_since_boot(get_absolute_time()) - g_config_save_at_ms) >= 0)
+        {
+            g_config_dirty = false;
+            perf_span_t gravacao = perf_span_begin();
+            estacao_config_t config;
+            seqlock_read(&g_config_lock, &g_config, &config, sizeof(config));
+            if (!config_store_set(&g_config_store, CONFIG_KEY_ESTACAO, &config, sizeof(config)))
+            {
+                printf("Falha ao gravar a configuracao na flash.\n");
+            }
+            perf_trace_end(&g_perf_trace, gravacao, PERF_SPAN_CONFIG_SAVE, 0);
+        }
 
-            if (g_temperatura > g_temp_max || g_temperatura < g_temp_min)
+        // Grava na flash o setor do arquivo que encheu. Apagar e gravar um setor leva dezenas de ms e para
+        // os dois nucleos, por isso so acontece a cada poucas horas e logo depois de uma amostra publicada,
+        // bem antes da proxima leitura.
+        if (flash_log_pending(&g_flash_log))
+        {
+            perf_span_t gravacao = perf_span_begin();
+            cyw43_arch_lwip_begin();
+            if (!flash_log_flush(&g_flash_log))
             {
-                em_alerta = true;
+                printf("Falha ao gravar o arquivo na flash, tentando de novo.\n");
             }
-            if (g_umidade > g_umid_max || g_umidade < g_umid_min)
+            cyw43_arch_lwip_end();
+            perf_trace_end(&g_perf_trace, gravacao, PERF_SPAN_FLASH_FLUSH, 0);
+        }
+        // Consulta o RSSI de tempos em tempos; /metrics so le o ultimo valor.
+        uint32_t agora_ms = to_ms_since_boot(get_absolute_time());
+        if ((int32_t)(agora_ms - proxima_consulta_rssi_ms) >= 0)
+        {
+            proxima_consulta_rssi_ms = agora_ms + WIFI_RSSI_INTERVAL_MS;
+            int32_t rssi;
+            cyw43_arch_lwip_begin();
+            bool rssi_ok = cyw43_wifi_get_rssi(&cyw43_state, &rssi) == 0;
+            cyw43_arch_lwip_end();
+            if (rssi_ok)
             {
-                em_alerta = true;
+                g_wifi_rssi = rssi;
             }
+            g_wifi_rssi_ok = rssi_ok;
+        }
+
+        perf_trace_end_min(&g_perf_trace, volta, PERF_SPAN_LOOP, 0, PERF_LOOP_MIN_US);
+        sleep_ms(MAIN_LOOP_SLEEP_MS);
+    }
+}
+
+/*
+ * Laco do nucleo 1: inicializa os sensores, le os dois a cada SENSOR_READ_INTERVAL_MS, aplica os offsets,
+ * avalia os alertas na matriz de LEDs e entrega a amostra ao nucleo 0 por g_sensor_ring. Como nada aqui
+ * depende da rede, o intervalo entre leituras nao sofre com o trafego HTTP, e vice-versa.
+ */
+void sensor_core_main()
+{
+    // Permite ao nucleo 0 pausar este nucleo enquanto grava a flash (flash_safe_execute).
+    flash_safe_execute_core_init();
+    perf_trace_init_core(); // O SysTick eh de cada nucleo.
+
+    // Inicializacao dos sensores I2C. Fica neste nucleo porque as interrupcoes do I2C (lib/i2c_dma.c)
+    // sao atendidas pelo nucleo que as habilita.
+    i2c_init(I2C_PORT_AHT20, 400 * 1000);
+    gpio_set_function(I2C_SDA_AHT, GPIO_FUNC_I2C);
+    gpio_set_function(I2C_SCL_AHT, GPIO_FUNC_I2C);
+    aht20_init(I2C_PORT_AHT20);
+
+    i2c_init(I2C_PORT_BMP280, 400 * 1000);
+    gpio_set_function(I2C_SDA_BMP, GPIO_FUNC_I2C);
+    gpio_set_function(I2C_SCL_BMP, GPIO_FUNC_I2C);
+    bmp280_init(I2C_PORT_BMP280);
+    uint8_t calibracao[BMP280_CALIB_SIZE]; // Registradores de calibracao, tambem enviados no trace.
+    bmp280_read_calib(I2C_PORT_BMP280, calibracao);
+    struct bmp280_calib_param params;
+    bmp280_decode_calib(calibracao, &params);
+    bmp280_set_profile(I2C_PORT_BMP280, BMP280_SENSOR_PROFILE, BMP280_MODE_FORCED);
+
+    // Ultimas leituras validas e contagem das amostras; o mesmo codigo roda no replay (host/replay.c).
+    sensor_pipeline_t pipeline;
+    sensor_pipeline_init(&pipeline, &params);
+
+    bool capturando = false;           // Ciclo anterior foi capturado (o trace ja tem a calibracao).
+    bool config_capturada = false;     // O trace ja tem a configuracao em ultima_config.
+    estacao_config_t ultima_config;
+    absolute_time_t proxima_leitura = get_absolute_time();
+    while (true)
+    {
+        // Ao ligar a captura, o trace comeca pela calibracao; a configuracao vai antes da primeira amostra.
+        bool capturar = g_trace_capture;
+        if (capturar && !capturando)
+        {
+            trace_emit(SENSOR_TRACE_CALIB, calibracao, sizeof(calibracao));
+            config_capturada = false;
+        }
+        capturando = capturar;
+
+        // Dispara as duas medicoes; o BMP280 converte em modo forcado bem antes dos ~80 ms do AHT20.
+        perf_span_t ciclo = perf_span_begin();
+        uint32_t inicio_ms = to_ms_since_boot(get_absolute_time());
+        if (!aht20_start_measurement(I2C_PORT_AHT20))
+        {
+            g_sensor_counters.aht20_i2c_errors++;
+            printf("Falha ao disparar a medicao do AHT20.\n");
+        }
+        if (!bmp280_start_forced(I2C_PORT_BMP280))
+        {
+            g_sensor_counters.bmp280_i2c_errors++;
+        }
+        sleep_ms(AHT20_MEASUREMENT_TIME_MS);
 
-            if (em_alerta)
+        // Le os dois sensores ao mesmo tempo por DMA, cada um no seu barramento. Se o AHT20 ainda estiver
+        // convertendo, tenta de novo ate AHT20_TIMEOUT_MS.
+        aht20_result_t result;
+        uint16_t tentativa = 0;
+        while (true)
+        {
+            tentativa++;
+            perf_span_t leitura_dma = perf_span_begin();
+            aht20_request_result(I2C_PORT_AHT20);
+            bmp280_request_raw(I2C_PORT_BMP280);
+            i2c_dma_wait(I2C_PORT_AHT20);
+            i2c_dma_wait(I2C_PORT_BMP280);
+            perf_trace_end(&g_perf_trace, leitura_dma, PERF_SPAN_SENSOR_READ, tentativa);
+
+            sensor_trace_read_t leitura = {.time_us = time_us_32()};
+            if (i2c_dma_status(I2C_PORT_AHT20) == I2C_DMA_DONE)
+            {
+                leitura.flags |= SENSOR_TRACE_AHT20_DONE;
+            }
+            else
+            {
+                g_sensor_counters.aht20_i2c_errors++;
+            }
+            if (i2c_dma_status(I2C_PORT_BMP280) == I2C_DMA_DONE)
             {
-                desenho_pio(alerta1, pio, sm, 1.0, 1.0, 0.0);
-                sleep_ms(500);
-                desenho_pio(alerta1, pio, sm, 1.0, 1.0, 0.0);
+                leitura.flags |= SENSOR_TRACE_BMP280_DONE;
             }
             else
             {
-                desenho_pio(matrizVazia, pio, sm, 1.0, 1.0, 0.0);
+                g_sensor_counters.bmp280_i2c_errors++;
+            }
+            memcpy(leitura.aht20, aht20_result_bytes(), sizeof(leitura.aht20));
+            memcpy(leitura.bmp280, bmp280_raw_bytes(), sizeof(leitura.bmp280));
+            perf_span_t compensacao = perf_span_begin();
+            result = sensor_pipeline_read(&pipeline, leitura.flags & SENSOR_TRACE_AHT20_DONE, leitura.aht20,
+                                          leitura.flags & SENSOR_TRACE_BMP280_DONE, leitura.bmp280);
+            perf_trace_end(&g_perf_trace, compensacao, PERF_SPAN_COMPENSATION, tentativa);
+            if (capturar)
+            {
+                trace_emit(SENSOR_TRACE_READ, &leitura, sizeof(leitura));
+            }
+
+            if (result == AHT20_RESULT_CRC_ERROR)
+            {
+                g_sensor_counters.aht20_crc_errors++;
+            }
+            if (result != AHT20_RESULT_BUSY ||
+                to_ms_since_boot(get_absolute_time()) - inicio_ms >= AHT20_TIMEOUT_MS)
+            {
+                break;
             }
+            g_sensor_counters.aht20_retries++;
+            sleep_ms(10);
+        }
+
+        if (result != AHT20_RESULT_READY)
+        {
+            g_sensor_counters.aht20_failures++;
+            printf("Falha na leitura do AHT20 (%d), mantendo a leitura anterior.\n", result);
+        }
+        if (!pipeline.bmp280_ok)
+        {
+            g_sensor_counters.bmp280_failures++;
+            printf("Falha na leitura do BMP280, mantendo a leitura anterior.\n");
         }
-        sleep_ms(10);
+
+        // Aplica os offsets definidos na pagina pelo usuario e confere os limites.
+        estacao_config_t config;
+        seqlock_read(&g_config_lock, &g_config, &config, sizeof(config));
+        if (capturar && (!config_capturada || memcmp(&config, &ultima_config, sizeof(config)) != 0))
+        {
+            trace_emit(SENSOR_TRACE_CONFIG, &config, sizeof(config));
+            ultima_config = config;
+            config_capturada = true;
+        }
+        sensor_sample_t amostra;
+        perf_span_t processamento = perf_span_begin();
+        bool em_alerta = sensor_pipeline_sample(&pipeline, inicio_ms, &config, &amostra);
+        perf_trace_end(&g_perf_trace, processamento, PERF_SPAN_SAMPLE, 0);
+        sensor_ring_push(&g_sensor_ring, &amostra);
+
+        if (capturar)
+        {
+            sensor_trace_sample_t registro = {
+                .timestamp_ms = amostra.timestamp_ms,
+                .temperatura = amostra.temperatura,
+                .umidade = amostra.umidade,
+                .pressao = amostra.pressao,
+                .altitude = amostra.altitude,
+                .alerta = em_alerta,
+            };
+            trace_emit(SENSOR_TRACE_SAMPLE, &registro, sizeof(registro));
+        }
+
+        // Se os valores atuais passarem dos maximos ou dos minimos, aciona a matriz de LEDs
+        perf_span_t matriz = perf_span_begin();
+        if (em_alerta)
+        {
+            desenho_pio(alerta1, pio, sm, 1.0, 1.0, 0.0);
+            sleep_ms(500);
+            desenho_pio(alerta1, pio, sm, 1.0, 1.0, 0.0);
+        }
+        else
+        {
+            desenho_pio(matrizVazia, pio, sm, 1.0, 1.0, 0.0);
+        }
+        perf_trace_end(&g_perf_trace, matriz, PERF_SPAN_LED_UPDATE, em_alerta);
+        perf_trace_end(&g_perf_trace, ciclo, PERF_SPAN_SENSOR_CYCLE, (uint16_t)amostra.sequence);
+
+        // Periodo fixo, contado a partir do inicio da leitura anterior.
+        proxima_leitura = delayed_by_ms(proxima_leitura, SENSOR_READ_INTERVAL_MS);
+        sleep_until(proxima_leitura);
     }
 }
 
 //----------------------------------------------Funcoes------------------------------------------------
 
+// Envia um registro do trace pela USB, como uma linha "TRC <hex>" no meio do log (lib/sensor_trace.h).
+static void trace_emit(uint8_t type, const void *payload, uint8_t length)
+{
+    char line[SENSOR_TRACE_LINE_SIZE];
+    if (sensor_trace_format_line(line, sizeof(line), type, payload, length))
+    {
+        fputs(line, stdout);
+    }
+}
+
 // Funcao para inicializar os LEDs, buzzer, PIO, botoes e as interrupcoes.
 void setup()
 {
@@ -434,196 +954,2197 @@ void gpio_callback(uint gpio, uint32_t events)
     }
     // Sinaliza qual eh a proxima pagina.
     g_target_page = G_PAGES[g_current_page_index];
+    g_navigate_event = true;
     printf("Botao pressionado, proxima pagina: %s\n", g_target_page);
 }
 
-// Calcula a altitude com base na pressao atmosferica.
-float calculate_altitude(float pressure_pa)
+// Envia um pedaco de dados via TCP.
+static err_t send_chunk(struct tcp_pcb *tpcb, const char *data)
 {
-    return 44330.0 * (1.0 - pow(pressure_pa / SEA_LEVEL_PRESSURE, 0.1903));
+    return http_tcp_write(tpcb, data, strlen(data), TCP_WRITE_FLAG_COPY);
 }
 
-// Envia um pedaco de dados via TCP.
-static err_t send_chunk(struct tcp_pcb *tpcb, const char *data)
+// tcp_write com um span no trace de desempenho; todo envio do servidor passa por aqui.
+static err_t http_tcp_write(struct tcp_pcb *tpcb, const void *data, u16_t length, u8_t flags)
 {
-    return tcp_write(tpcb, data, strlen(data), TCP_WRITE_FLAG_COPY);
+    perf_span_t span = perf_span_begin();
+    err_t result = tcp_write(tpcb, data, length, flags);
+    perf_trace_end(&g_perf_trace, span, PERF_SPAN_TCP_WRITE, length);
+    return result;
 }
 
-// Monta e envia uma pagina HTML completa.
-void send_full_response(struct tcp_pcb *tpcb, const char *content_template)
+// tcp_output com um span no trace de desempenho.
+static err_t http_tcp_output(struct tcp_pcb *tpcb)
 {
-    char final_content[4096];
+    perf_span_t span = perf_span_begin();
+    err_t result = tcp_output(tpcb);
+    perf_trace_end(&g_perf_trace, span, PERF_SPAN_TCP_OUTPUT, 0);
+    return result;
+}
 
-    if (strstr(content_template, "%d"))
+/*
+ * Monta o cabecalho de uma resposta. Em conexoes persistentes informa ao navegador o tempo ocioso
+ * e quantas requisicoes ainda podem ser feitas; caso contrario avisa que a conexao sera fechada.
+ * extra_headers, se informado, contem linhas de cabecalho adicionais ja terminadas em CRLF.
+ */
+static int format_http_header(http_connection_t *conn, char *buffer, size_t size, const char *status,
+                              const char *content_type, const char *extra_headers, int content_len)
+{
+    int len = snprintf(buffer, size, "HTTP/1.1 %s\r\n", status);
+    if (content_type)
+    {
+        len += snprintf(buffer + len, size - len, "Content-Type: %s\r\n", content_type);
+    }
+    if (extra_headers)
+    {
+        len += snprintf(buffer + len, size - len, "%s", extra_headers);
+    }
+    if (content_len < 0)
+    {
+        len += snprintf(buffer + len, size - len, "Transfer-Encoding: chunked\r\n"); // Corpo gerado sob demanda.
+    }
+    else if (strncmp(status, "304", 3) != 0) // Um 304 nunca tem corpo nem tamanho proprio.
     {
-        snprintf(final_content, sizeof(final_content), content_template, MAX_CHART_POINTS);
+        len += snprintf(buffer + len, size - len, "Content-Length: %d\r\n", content_len);
+    }
+    if (conn->keep_alive)
+    {
+        len += snprintf(buffer + len, size - len, "Connection: keep-alive\r\nKeep-Alive: timeout=%d, max=%d\r\n\r\n",
+                        HTTP_KEEPALIVE_TIMEOUT_S, HTTP_KEEPALIVE_MAX - conn->requests_served);
     }
     else
     {
-        strncpy(final_content, content_template, sizeof(final_content));
+        len += snprintf(buffer + len, size - len, "Connection: close\r\n\r\n");
     }
-    final_content[sizeof(final_content) - 1] = '\0';
+    return len;
+}
 
-    char http_header[128];
-    int content_len = strlen(HTML_HEADER) + strlen(HTML_NAV) + strlen(final_content) + strlen(HTML_FOOTER);
-    snprintf(http_header, sizeof(http_header),
-             "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: %d\r\nConnection: close\r\n\r\n", content_len);
+// Reserva o proximo trecho da resposta; retorna NULL se a resposta ja tiver HTTP_TX_MAX_SEGMENTS trechos.
+static http_tx_segment_t *http_tx_new_segment(http_connection_t *conn, http_segment_type_t type)
+{
+    if (conn->tx_count == HTTP_TX_MAX_SEGMENTS)
+    {
+        return NULL;
+    }
+    http_tx_segment_t *segment = &conn->tx_segments[conn->tx_count++];
+    memset(segment, 0, sizeof(*segment));
+    segment->type = type;
+    return segment;
+}
 
-    send_chunk(tpcb, http_header);
-    send_chunk(tpcb, HTML_HEADER);
-    send_chunk(tpcb, HTML_NAV);
-    send_chunk(tpcb, final_content);
-    send_chunk(tpcb, HTML_FOOTER);
-    tcp_output(tpcb);
+/*
+ * Acrescenta a resposta um trecho constante, entregue ao lwIP sem copia. Deve permanecer valido ate
+ * ser confirmado pelo cliente, como as paginas HTML em flash.
+ */
+static bool http_tx_add_static(http_connection_t *conn, const char *data, uint16_t length)
+{
+    http_tx_segment_t *segment = http_tx_new_segment(conn, HTTP_SEGMENT_STATIC);
+    if (!segment)
+    {
+        return false;
+    }
+    segment->data = data;
+    segment->length = length;
+    return true;
 }
 
-// Monta e envia uma resposta JSON.
-void send_json_response(struct tcp_pcb *tpcb, const char *payload)
+// Acrescenta a resposta uma copia de dados em RAM (cabecalho, JSON), guardada em tx_buffer.
+static bool http_tx_add_copy(http_connection_t *conn, const char *data, uint16_t length)
 {
-    char http_header[128];
-    snprintf(http_header, sizeof(http_header),
-             "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: %d\r\nConnection: close\r\n\r\n",
-             (int)strlen(payload));
-    send_chunk(tpcb, http_header);
-    send_chunk(tpcb, payload);
-    tcp_output(tpcb);
+    if (conn->tx_buffer_used + length > HTTP_TX_BUFFER_SIZE)
+    {
+        return false;
+    }
+    http_tx_segment_t *segment = http_tx_new_segment(conn, HTTP_SEGMENT_DYNAMIC);
+    if (!segment)
+    {
+        return false;
+    }
+    segment->data = conn->tx_buffer + conn->tx_buffer_used;
+    segment->length = length;
+    memcpy(conn->tx_buffer + conn->tx_buffer_used, data, length);
+    conn->tx_buffer_used += length;
+    return true;
 }
 
-// Processa os dados recebidos de um formulario.
-void parse_post_data(const char *data)
+// Formata um trecho diretamente em tx_buffer. Retorna o tamanho do trecho ou -1 se nao houver espaco.
+static int http_tx_printf(http_connection_t *conn, const char *format, ...)
 {
-    char buffer[512];
-    strncpy(buffer, data, sizeof(buffer) - 1);
-    buffer[sizeof(buffer) - 1] = '\0';
+    uint16_t space = HTTP_TX_BUFFER_SIZE - conn->tx_buffer_used;
+    char *buffer = conn->tx_buffer + conn->tx_buffer_used;
 
-    char *token = strtok(buffer, "&");
-    while (token != NULL)
-    {
-        char *key = token;
-        char *value_str = strchr(token, '=');
-        if (value_str)
-        {
-            *value_str = '\0';
-            value_str++;
-            float value = atof(value_str);
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, space, format, args);
+    va_end(args);
 
-            if (strcmp(key, "temp_offset") == 0)
-                g_temp_offset = value;
-            else if (strcmp(key, "temp_min") == 0)
-                g_temp_min = value;
-            else if (strcmp(key, "temp_max") == 0)
-                g_temp_max = value;
-            else if (strcmp(key, "umid_offset") == 0)
-                g_umid_offset = value;
-            else if (strcmp(key, "umid_min") == 0)
-                g_umid_min = value;
-            else if (strcmp(key, "umid_max") == 0)
-                g_umid_max = value;
-            else if (strcmp(key, "press_offset") == 0)
-                g_press_offset = value;
-            else if (strcmp(key, "press_min") == 0)
-                g_press_min = value;
-            else if (strcmp(key, "press_max") == 0)
-                g_press_max = value;
-            else if (strcmp(key, "alt_offset") == 0)
-                g_alt_offset = value;
-            else if (strcmp(key, "alt_min") == 0)
-                g_alt_min = value;
-            else if (strcmp(key, "alt_max") == 0)
-                g_alt_max = value;
-        }
-        token = strtok(NULL, "&");
+    if (length < 0 || length >= space)
+    {
+        return -1;
+    }
+    http_tx_segment_t *segment = http_tx_new_segment(conn, HTTP_SEGMENT_DYNAMIC);
+    if (!segment)
+    {
+        return -1;
     }
+    segment->data = buffer;
+    segment->length = length;
+    conn->tx_buffer_used += length;
+    return length;
 }
 
-// Funcao principal de callback para receber dados do servidor TCP.
-static err_t tcp_server_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err)
+/*
+ * Acrescenta a resposta um corpo produzido sob demanda (cabecalho com content_len = -1). O gerador
+ * eh chamado apenas quando o pedaco anterior ja foi entregue ao lwIP, usando o espaco livre de
+ * tx_buffer, de modo que respostas de qualquer tamanho nao ocupam mais memoria.
+ */
+static bool http_tx_add_generator(http_connection_t *conn, http_generator_t generate, void *arg)
 {
-    if (!p)
+    http_tx_segment_t *segment = http_tx_new_segment(conn, HTTP_SEGMENT_GENERATOR);
+    if (!segment)
     {
-        tcp_close(tpcb);
-        return ERR_OK;
+        return false;
     }
+    segment->generate = generate;
+    segment->arg = arg;
+    return true;
+}
+
+// Indica se ainda ha trechos da resposta atual a serem entregues ao lwIP.
+static bool http_tx_busy(const http_connection_t *conn)
+{
+    return conn->tx_index < conn->tx_count;
+}
 
-    char request_buffer[1024];
-    pbuf_copy_partial(p, request_buffer, sizeof(request_buffer) - 1, 0);
-    request_buffer[sizeof(request_buffer) - 1] = '\0';
-    tcp_recved(tpcb, p->tot_len);
+/*
+ * Produz o proximo pedaco de um trecho gerado no espaco livre de tx_buffer, ja no formato chunked:
+ * tamanho em hexadecimal, dados e CRLF. Quando o gerador termina, produz o pedaco final vazio.
+ */
+static void http_tx_generate(http_connection_t *conn, http_tx_segment_t *segment)
+{
+    char *chunk = conn->tx_buffer + conn->tx_buffer_used;
+    uint16_t space = HTTP_TX_BUFFER_SIZE - conn->tx_buffer_used;
+    uint16_t length = 0;
 
-    if (strstr(request_buffer, "GET /navigate "))
+    // Reserva 5 bytes para o tamanho ("XXX\r\n") e 2 para o CRLF final.
+    if (space > 7)
     {
-        char json_payload[128];
-        if (g_target_page != NULL)
-        {
-            snprintf(json_payload, sizeof(json_payload), "{\"goto\":\"%s\"}", g_target_page);
-            g_target_page = NULL;
-        }
-        else
-        {
-            snprintf(json_payload, sizeof(json_payload), "{\"goto\":null}");
-        }
-        send_json_response(tpcb, json_payload);
+        length = segment->generate(chunk + 5, space - 7, &segment->cursor, segment->arg);
     }
-    else if (strstr(request_buffer, "POST /config "))
+    if (length == 0)
     {
-        char *body = strstr(request_buffer, "\r\n\r\n");
-        if (body)
-        {
-            body += 4;
-            parse_post_data(body);
-        }
-        char http_header[] = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
-        send_chunk(tpcb, http_header);
-        tcp_output(tpcb);
+        memcpy(chunk, "0\r\n\r\n", 5);
+        conn->tx_generated = 5;
+        segment->finished = true;
     }
-    else if (strstr(request_buffer, "GET /getconfig "))
+    else
+    {
+        char size_line[8];
+        snprintf(size_line, sizeof(size_line), "%03X\r\n", length);
+        memcpy(chunk, size_line, 5);
+        memcpy(chunk + 5 + length, "\r\n", 2);
+        conn->tx_generated = length + 7;
+    }
+    conn->tx_offset = 0;
+}
+
+/*
+ * Encerra a resposta atual quando todos os trechos foram entregues. Se a conexao deve ser fechada,
+ * o fechamento so acontece depois que o cliente confirmar todos os bytes (tx_unacked == 0).
+ */
+static err_t http_tx_finish(http_connection_t *conn)
+{
+    if (http_tx_busy(conn))
     {
-        char json_payload[512];
-        snprintf(json_payload, sizeof(json_payload),
-                 "{\"temp_offset\":%.2f,\"temp_min\":%.2f,\"temp_max\":%.2f,"
-                 "\"umid_offset\":%.2f,\"umid_min\":%.2f,\"umid_max\":%.2f,"
-                 "\"press_offset\":%.2f,\"press_min\":%.2f,\"press_max\":%.2f,"
-                 "\"alt_offset\":%.2f,\"alt_min\":%.2f,\"alt_max\":%.2f}",
-                 g_temp_offset, g_temp_min, g_temp_max, g_umid_offset, g_umid_min, g_umid_max,
-                 g_press_offset, g_press_min, g_press_max, g_alt_offset, g_alt_min, g_alt_max);
-        send_json_response(tpcb, json_payload);
+        return ERR_OK;
     }
-    else if (strstr(request_buffer, "GET /estado "))
+
+    conn->tx_count = 0;
+    conn->tx_index = 0;
+    conn->tx_offset = 0;
+    conn->tx_buffer_used = 0;
+    conn->tx_generated = 0;
+    if (conn->metrics_pending)
     {
-        char json_payload[128];
-        snprintf(json_payload, sizeof(json_payload),
-                 "{\"temperatura\":%.2f,\"umidade\":%.2f,\"pressao\":%.3f,\"altitude\":%.2f}",
-                 g_temperatura, g_umidade, g_pressao, g_altitude);
-        send_json_response(tpcb, json_payload);
+        http_metrics_response_done(conn);
     }
-    else
+    if (conn->close_after_tx && conn->tx_unacked == 0)
     {
-        const char *content_to_send = NULL;
-        if (strstr(request_buffer, "GET /config "))
+        return http_connection_close(conn);
+    }
+    return ERR_OK;
+}
+
+/*
+ * Entrega ao lwIP o quanto couber da resposta atual, respeitando tcp_sndbuf. O envio continua a
+ * partir de tcp_sent/tcp_poll quando o cliente confirmar os dados ja enviados.
+ */
+static err_t http_tx_pump(http_connection_t *conn)
+{
+    struct tcp_pcb *tpcb = conn->pcb;
+    bool written = false;
+
+    while (http_tx_busy(conn))
+    {
+        http_tx_segment_t *segment = &conn->tx_segments[conn->tx_index];
+        const char *data = segment->data;
+        uint16_t length = segment->length;
+
+        if (segment->type == HTTP_SEGMENT_GENERATOR)
         {
-            content_to_send = HTML_CONTENT_CONFIG;
+            if (conn->tx_offset == conn->tx_generated)
+            {
+                if (segment->finished)
+                {
+                    conn->tx_index++;
+                    conn->tx_offset = 0;
+                    conn->tx_generated = 0;
+                    continue;
+                }
+                if (tcp_sndbuf(tpcb) == 0)
+                {
+                    break; // Gera o proximo pedaco so quando ele puder ser enviado.
+                }
+                http_tx_generate(conn, segment);
+            }
+            data = conn->tx_buffer + conn->tx_buffer_used;
+            length = conn->tx_generated;
         }
-        else if (strstr(request_buffer, "GET /temperatura ") || strstr(request_buffer, "GET /umidade ") ||
-                 strstr(request_buffer, "GET /pressao ") || strstr(request_buffer, "GET /altitude "))
+
+        uint16_t remaining = length - conn->tx_offset;
+        uint16_t space = tcp_sndbuf(tpcb);
+        if (space == 0)
         {
-            content_to_send = HTML_CONTENT_CHART_PAGE;
+            break;
         }
-        else
+
+        uint16_t chunk = remaining < space ? remaining : space;
+        uint8_t flags = segment->type == HTTP_SEGMENT_STATIC ? 0 : TCP_WRITE_FLAG_COPY;
+        if (chunk < remaining || conn->tx_index + 1 < conn->tx_count || segment->type == HTTP_SEGMENT_GENERATOR)
+        {
+            flags |= TCP_WRITE_FLAG_MORE;
+        }
+        if (http_tcp_write(tpcb, data + conn->tx_offset, chunk, flags) != ERR_OK)
+        {
+            break; // Fila de segmentos do lwIP cheia (ERR_MEM): tenta de novo no proximo tcp_sent.
+        }
+        written = true;
+        conn->tx_unacked += chunk;
+
+        conn->tx_offset += chunk;
+        if (conn->tx_offset == length && segment->type != HTTP_SEGMENT_GENERATOR)
         {
-            content_to_send = HTML_CONTENT_INICIO;
+            conn->tx_index++;
+            conn->tx_offset = 0;
         }
-        send_full_response(tpcb, content_to_send);
     }
 
-    pbuf_free(p);
-    tcp_close(tpcb);
-    return ERR_OK;
+    if (written)
+    {
+        http_tcp_output(tpcb);
+    }
+    return http_tx_finish(conn);
 }
 
-// Callback chamado quando uma nova conexao TCP eh aceita.
-static err_t tcp_server_accept(void *arg, struct tcp_pcb *newpcb, err_t err)
+// Verifica se a ETag informada esta entre as enviadas pelo navegador em If-None-Match.
+static bool http_etag_matches(const http_connection_t *conn, const char *etag)
+{
+    const char *list = conn->if_none_match;
+    while (*list == ' ')
+    {
+        list++;
+    }
+    return (list[0] == '*' && list[1] == '\0') || strstr(list, etag) != NULL;
+}
+
+/*
+ * Envia uma pagina ou arquivo gerado em web_pages.h. O conteudo ja esta montado e comprimido em flash,
+ * entao so o cabecalho HTTP eh formatado; o corpo eh entregue ao lwIP sem copia. Se o navegador ja
+ * tiver essa versao em cache (If-None-Match), responde apenas 304 Not Modified, sem corpo.
+ */
+void send_gzip_response(http_connection_t *conn, const char *content_type, const char *cache_control,
+                        const char *etag, const uint8_t *body, uint16_t body_len)
 {
+    bool not_modified = http_etag_matches(conn, etag);
+
+    char extra_headers[160];
+    int extra_len = snprintf(extra_headers, sizeof(extra_headers), "ETag: %s\r\nCache-Control: %s\r\n", etag,
+                             cache_control);
+    if (!not_modified)
+    {
+        snprintf(extra_headers + extra_len, sizeof(extra_headers) - extra_len, "Content-Encoding: gzip\r\n");
+    }
+
+    char http_header[320];
+    int header_len = format_http_header(conn, http_header, sizeof(http_header),
+                                        not_modified ? "304 Not Modified" : "200 OK",
+                                        not_modified ? NULL : content_type, extra_headers, body_len);
+    http_tx_add_copy(conn, http_header, header_len);
+    if (!not_modified)
+    {
+        http_tx_add_static(conn, (const char *)body, body_len);
+    }
+}
+
+// Procura um arquivo de /assets pelo caminho completo (com o hash do conteudo).
+static const web_asset_t *web_asset_find(const char *path)
+{
+    for (size_t i = 0; i < WEB_ASSET_COUNT; i++)
+    {
+        if (strcmp(path, WEB_ASSETS[i].path) == 0)
+        {
+            return &WEB_ASSETS[i];
+        }
+    }
+    return NULL;
+}
+
+// Monta uma resposta JSON. Leituras e configuracoes mudam a todo momento, entao nunca vao para o cache.
+void send_json_response(http_connection_t *conn, const char *payload)
+{
+    char http_header[192];
+    int payload_len = strlen(payload);
+    int header_len = format_http_header(conn, http_header, sizeof(http_header), "200 OK", "application/json",
+                                        "Cache-Control: no-store\r\n", payload_len);
+    http_tx_add_copy(conn, http_header, header_len);
+    http_tx_add_copy(conn, payload, payload_len);
+}
+
+// Monta uma resposta sem corpo, apenas com o status informado.
+void send_empty_response(http_connection_t *conn, const char *status)
+{
+    send_empty_response_with(conn, status, NULL);
+}
+
+// Monta uma resposta sem corpo com cabecalhos adicionais (ex.: Allow em um 405).
+void send_empty_response_with(http_connection_t *conn, const char *status, const char *extra_headers)
+{
+    char http_header[192];
+    int header_len = format_http_header(conn, http_header, sizeof(http_header), status, NULL, extra_headers, 0);
+    http_tx_add_copy(conn, http_header, header_len);
+}
+
+// Formata uma amostra no JSON usado por /estado e pelo evento SSE "reading".
+static int format_estado_json(char *buffer, size_t size, const sensor_sample_t *amostra)
+{
+    return snprintf(buffer, size,
+                    "{\"temperatura\":%.2f,\"umidade\":%.2f,\"pressao\":%.3f,\"altitude\":%.2f}",
+                    amostra->temperatura, amostra->umidade, amostra->pressao, amostra->altitude);
+}
+
+/*
+ * Transforma a conexao em um stream de Server-Sent Events. A conexao fica aberta e passa a receber
+ * os eventos "reading" e "navigate" enviados por sse_broadcast.
+ */
+static void http_start_event_stream(http_connection_t *conn)
+{
+    conn->mode = HTTP_MODE_EVENTS;
+    conn->keep_alive = true;
+    conn->idle_seconds = 0;
+    send_chunk(conn->pcb, "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\n"
+                          "Connection: keep-alive\r\n\r\nretry: 3000\n\n");
+    http_tcp_output(conn->pcb);
+}
+
+// Envia um evento SSE sem bloquear; retorna false se o buffer de envio da conexao estiver cheio.
+static bool sse_send(http_connection_t *conn, const char *event, const char *data)
+{
+    char message[192];
+    int len = snprintf(message, sizeof(message), "event: %s\ndata: %s\n\n", event, data);
+    if (len >= (int)sizeof(message) || tcp_sndbuf(conn->pcb) < len)
+    {
+        return false;
+    }
+    if (http_tcp_write(conn->pcb, message, len, TCP_WRITE_FLAG_COPY) != ERR_OK)
+    {
+        return false;
+    }
+    http_tcp_output(conn->pcb);
+    return true;
+}
+
+/*
+ * Envia um evento a todos os streams SSE abertos. Um cliente lento (sem espaco em tcp_sndbuf) perde
+ * a leitura atual, que sera substituida pela proxima; eventos de navegacao ficam pendentes e sao
+ * reenviados no callback tcp_sent. Deve ser chamada com o lwIP protegido (cyw43_arch_lwip_begin).
+ */
+void sse_broadcast(const char *event, const char *data)
+{
+    bool is_navigate = strcmp(event, "navigate") == 0;
+    for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++)
+    {
+        http_connection_t *conn = &g_http_connections[i];
+        if (!conn->in_use || conn->mode != HTTP_MODE_EVENTS)
+        {
+            continue;
+        }
+        if (is_navigate)
+        {
+            conn->pending_navigate = NULL;
+        }
+        if (!sse_send(conn, event, data) && is_navigate)
+        {
+            conn->pending_navigate = (const char *)g_target_page;
+        }
+    }
+}
+
+/*
+ * Conclui o handshake do WebSocket (RFC 6455): Sec-WebSocket-Accept eh o base64 do SHA-1 da chave
+ * enviada pelo navegador concatenada ao GUID fixo do protocolo.
+ */
+static void http_start_websocket(http_connection_t *conn)
+{
+    char key[WS_KEY_SIZE + sizeof(WS_GUID)];
+    unsigned char digest[20];
+    unsigned char accept[32];
+    size_t accept_len = 0;
+
+    snprintf(key, sizeof(key), "%s%s", conn->ws_key, WS_GUID);
+    mbedtls_sha1((const unsigned char *)key, strlen(key), digest);
+    mbedtls_base64_encode(accept, sizeof(accept), &accept_len, digest, sizeof(digest));
+
+    char http_header[160];
+    snprintf(http_header, sizeof(http_header),
+             "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+             "Sec-WebSocket-Accept: %s\r\n\r\n", accept);
+    send_chunk(conn->pcb, http_header);
+    http_tcp_output(conn->pcb);
+
+    conn->mode = HTTP_MODE_WEBSOCKET;
+    conn->keep_alive = true;
+    conn->ws_queue_head = 0;
+    conn->ws_queue_count = 0;
+}
+
+// Envia um frame WebSocket curto (payload de ate 125 bytes), sem mascara, como exige o lado servidor.
+static void ws_send_frame(struct tcp_pcb *tpcb, uint8_t opcode, const void *payload, uint8_t len)
+{
+    uint8_t frame[2 + WS_MAX_CONTROL_PAYLOAD];
+    frame[0] = 0x80 | opcode; // FIN + opcode.
+    frame[1] = len;
+    memcpy(frame + 2, payload, len);
+    http_tcp_write(tpcb, frame, 2 + len, TCP_WRITE_FLAG_COPY);
+}
+
+// Envia as amostras enfileiradas enquanto houver espaco no buffer de envio da conexao.
+static void ws_flush_queue(http_connection_t *conn)
+{
+    bool sent = false;
+    while (conn->ws_queue_count > 0 && tcp_sndbuf(conn->pcb) >= 2 + sizeof(ws_sample_t))
+    {
+        ws_send_frame(conn->pcb, WS_OPCODE_BINARY, &conn->ws_queue[conn->ws_queue_head], sizeof(ws_sample_t));
+        conn->ws_queue_head = (conn->ws_queue_head + 1) % WS_MAX_QUEUED_FRAMES;
+        conn->ws_queue_count--;
+        sent = true;
+    }
+    if (sent)
+    {
+        http_tcp_output(conn->pcb);
+    }
+}
+
+/*
+ * Enfileira a amostra em todos os WebSockets abertos e envia o que couber. Cada cliente tem sua
+ * propria fila limitada a WS_MAX_QUEUED_FRAMES: um cliente lento perde as amostras mais antigas em
+ * vez de atrasar os demais. Deve ser chamada com o lwIP protegido (cyw43_arch_lwip_begin).
+ */
+void ws_broadcast_sample(const ws_sample_t *sample)
+{
+    for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++)
+    {
+        http_connection_t *conn = &g_http_connections[i];
+        if (!conn->in_use || conn->mode != HTTP_MODE_WEBSOCKET)
+        {
+            continue;
+        }
+        if (conn->ws_queue_count == WS_MAX_QUEUED_FRAMES)
+        {
+            conn->ws_queue_head = (conn->ws_queue_head + 1) % WS_MAX_QUEUED_FRAMES;
+            conn->ws_queue_count--;
+        }
+        uint8_t tail = (conn->ws_queue_head + conn->ws_queue_count) % WS_MAX_QUEUED_FRAMES;
+        conn->ws_queue[tail] = *sample;
+        conn->ws_queue_count++;
+        ws_flush_queue(conn);
+    }
+}
+
+/*
+ * Trata os frames completos recebidos do navegador (sempre mascarados). Responde a pings e ao
+ * pedido de fechamento; frames de dados sao ignorados. Retorna false se a conexao deve ser fechada.
+ */
+static bool ws_process_frames(http_connection_t *conn)
+{
+    while (conn->length >= 2)
+    {
+        uint8_t *frame = (uint8_t *)conn->buffer;
+        uint8_t opcode = frame[0] & 0x0F;
+        bool masked = frame[1] & 0x80;
+        uint32_t payload_len = frame[1] & 0x7F;
+        uint16_t header_len = 2;
+
+        if (payload_len == 126)
+        {
+            if (conn->length < 4)
+            {
+                break;
+            }
+            payload_len = ((uint32_t)frame[2] << 8) | frame[3];
+            header_len = 4;
+        }
+        else if (payload_len == 127)
+        {
+            return false; // Payloads de 64 bits nunca cabem no buffer.
+        }
+        if (!masked)
+        {
+            return false; // A RFC 6455 exige mascara em frames do cliente.
+        }
+        header_len += 4;
+
+        if (header_len + payload_len > HTTP_REQUEST_BUFFER_SIZE)
+        {
+            return false;
+        }
+        if (conn->length < header_len + payload_len)
+        {
+            break; // Frame incompleto; aguarda os proximos segmentos.
+        }
+
+        uint8_t *mask = frame + header_len - 4;
+        uint8_t *payload = frame + header_len;
+        for (uint32_t i = 0; i < payload_len; i++)
+        {
+            payload[i] ^= mask[i % 4];
+        }
+
+        if (opcode == WS_OPCODE_CLOSE)
+        {
+            ws_send_frame(conn->pcb, WS_OPCODE_CLOSE, payload, payload_len > 2 ? 2 : payload_len);
+            http_tcp_output(conn->pcb);
+            return false;
+        }
+        if (opcode == WS_OPCODE_PING && payload_len <= WS_MAX_CONTROL_PAYLOAD)
+        {
+            ws_send_frame(conn->pcb, WS_OPCODE_PONG, payload, payload_len);
+            http_tcp_output(conn->pcb);
+        }
+
+        uint16_t frame_len = header_len + payload_len;
+        memmove(conn->buffer, conn->buffer + frame_len, conn->length - frame_len);
+        conn->length -= frame_len;
+    }
+    return conn->length < HTTP_REQUEST_BUFFER_SIZE;
+}
+
+// Copia para 'value' o valor de 'key' na query string da requisicao; retorna false se ausente ou grande demais.
+static bool http_query_param(const http_connection_t *conn, const char *key, char *value, size_t size)
+{
+    size_t key_len = strlen(key);
+    const char *param = conn->query;
+    while (*param)
+    {
+        const char *end = strchr(param, '&');
+        if (!end)
+        {
+            end = param + strlen(param);
+        }
+        if (strncmp(param, key, key_len) == 0 && param[key_len] == '=')
+        {
+            size_t value_len = end - (param + key_len + 1);
+            if (value_len >= size)
+            {
+                return false;
+            }
+            memcpy(value, param + key_len + 1, value_len);
+            value[value_len] = '\0';
+            return true;
+        }
+        param = *end ? end + 1 : end;
+    }
+    return false;
+}
+
+// Le o valor de 'key' na query string como inteiro sem sinal; retorna false se ausente ou invalido.
+static bool http_query_uint(const http_connection_t *conn, const char *key, uint32_t *value)
+{
+    char text[12];
+    if (!http_query_param(conn, key, text, sizeof(text)))
+    {
+        return false;
+    }
+    char *number_end;
+    unsigned long parsed = strtoul(text, &number_end, 10);
+    if (number_end == text || *number_end != '\0')
+    {
+        return false; // Valor vazio ou invalido.
+    }
+    *value = parsed;
+    return true;
+}
+
+// Processa os dados recebidos de um formulario.
+void parse_post_data(const char *data, size_t length)
+{
+    char buffer[512];
+    if (length > sizeof(buffer) - 1)
+    {
+        length = sizeof(buffer) - 1;
+    }
+    memcpy(buffer, data, length);
+    buffer[length] = '\0';
+
+    // Os campos do POST sao aplicados a uma copia, publicada de uma vez no final.
+    estacao_config_t config;
+    seqlock_read(&g_config_lock, &g_config, &config, sizeof(config));
+
+    char *token = strtok(buffer, "&");
+    while (token != NULL)
+    {
+        char *key = token;
+        char *value_str = strchr(token, '=');
+        if (value_str)
+        {
+            *value_str = '\0';
+            value_str++;
+            float value = atof(value_str);
+
+            // Campos desconhecidos sao ignorados.
+            if (strcmp(key, "temp_offset") == 0)
+                config.temp_offset = value;
+            else if (strcmp(key, "temp_min") == 0)
+                config.temp_min = value;
+            else if (strcmp(key, "temp_max") == 0)
+                config.temp_max = value;
+            else if (strcmp(key, "umid_offset") == 0)
+                config.umid_offset = value;
+            else if (strcmp(key, "umid_min") == 0)
+                config.umid_min = value;
+            else if (strcmp(key, "umid_max") == 0)
+                config.umid_max = value;
+            else if (strcmp(key, "press_offset") == 0)
+                config.press_offset = value;
+            else if (strcmp(key, "press_min") == 0)
+                config.press_min = value;
+            else if (strcmp(key, "press_max") == 0)
+                config.press_max = value;
+            else if (strcmp(key, "alt_offset") == 0)
+                config.alt_offset = value;
+            else if (strcmp(key, "alt_min") == 0)
+                config.alt_min = value;
+            else if (strcmp(key, "alt_max") == 0)
+                config.alt_max = value;
+        }
+        token = strtok(NULL, "&");
+    }
+    seqlock_write(&g_config_lock, &g_config, &config, sizeof(config));
+}
+
+// Reserva um contexto livre do pool para uma nova conexao.
+static http_connection_t *http_connection_alloc(struct tcp_pcb *pcb)
+{
+    for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++)
+    {
+        http_connection_t *conn = &g_http_connections[i];
+        if (!conn->in_use)
+        {
+            memset(conn, 0, sizeof(*conn));
+            conn->in_use = true;
+            conn->pcb = pcb;
+            conn->state = HTTP_STATE_REQUEST_LINE;
+            return conn;
+        }
+    }
+    return NULL;
+}
+
+// Devolve o contexto ao pool.
+static void http_connection_free(http_connection_t *conn)
+{
+    if (conn->rx_pending)
+    {
+        pbuf_free(conn->rx_pending);
+        conn->rx_pending = NULL;
+    }
+    conn->in_use = false;
+    conn->pcb = NULL;
+}
+
+// Fecha a conexao persistente ociosa ha mais tempo, liberando seu contexto para uma nova conexao.
+static bool http_connection_reclaim_idle()
+{
+    http_connection_t *oldest = NULL;
+    for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++)
+    {
+        http_connection_t *conn = &g_http_connections[i];
+        if (conn->in_use && conn->mode == HTTP_MODE_REQUEST && conn->requests_served > 0 && conn->length == 0 &&
+            (!oldest || conn->idle_seconds > oldest->idle_seconds))
+        {
+            oldest = conn;
+        }
+    }
+    if (!oldest)
+    {
+        return false;
+    }
+    http_connection_close(oldest);
+    return true;
+}
+
+// Desassocia o contexto do PCB, libera o contexto e fecha a conexao.
+static err_t http_connection_close(http_connection_t *conn)
+{
+    struct tcp_pcb *tpcb = conn->pcb;
+    http_connection_free(conn);
+
+    tcp_arg(tpcb, NULL);
+    tcp_recv(tpcb, NULL);
+    tcp_err(tpcb, NULL);
+    tcp_sent(tpcb, NULL);
+    tcp_poll(tpcb, NULL, 0);
+    if (tcp_close(tpcb) != ERR_OK)
+    {
+        tcp_abort(tpcb);
+        return ERR_ABRT;
+    }
+    return ERR_OK;
+}
+
+// Le a linha de requisicao ("METODO /caminho?query HTTP/1.1"), separando metodo, caminho e query string.
+static bool http_parse_request_line(http_connection_t *conn, char *line)
+{
+    char *path = strchr(line, ' ');
+    if (!path || path == line || path - line >= HTTP_METHOD_SIZE)
+    {
+        return false;
+    }
+    *path++ = '\0';
+
+    char *version = strchr(path, ' ');
+    if (!version || path[0] != '/')
+    {
+        return false;
+    }
+    *version = '\0';
+
+    char *query = strchr(path, '?');
+    if (query)
+    {
+        *query++ = '\0';
+    }
+    if (strlen(path) >= HTTP_PATH_SIZE || (query && strlen(query) >= HTTP_QUERY_SIZE))
+    {
+        return false;
+    }
+
+    strcpy(conn->method, line);
+    strcpy(conn->path, path);
+    strcpy(conn->query, query ? query : "");
+
+    // HTTP/1.1 mantem a conexao aberta por padrao; HTTP/1.0 so se o cliente pedir.
+    conn->keep_alive = strcmp(version + 1, "HTTP/1.1") == 0;
+    return true;
+}
+
+// Trata um cabecalho, guardando apenas o que interessa ao servidor.
+static void http_parse_header(http_connection_t *conn, const char *line)
+{
+    if (strncasecmp(line, "Content-Length:", 15) == 0)
+    {
+        long value = strtol(line + 15, NULL, 10);
+        if (value < 0 || value > HTTP_REQUEST_BUFFER_SIZE)
+        {
+            conn->state = HTTP_STATE_ERROR;
+            return;
+        }
+        conn->content_length = (uint16_t)value;
+    }
+    else if (strncasecmp(line, "Upgrade:", 8) == 0)
+    {
+        const char *value = line + 8;
+        while (*value == ' ')
+        {
+            value++;
+        }
+        conn->upgrade_websocket = strncasecmp(value, "websocket", 9) == 0;
+    }
+    else if (strncasecmp(line, "Sec-WebSocket-Key:", 18) == 0)
+    {
+        const char *value = line + 18;
+        while (*value == ' ')
+        {
+            value++;
+        }
+        snprintf(conn->ws_key, sizeof(conn->ws_key), "%s", value);
+    }
+    else if (strncasecmp(line, "If-None-Match:", 14) == 0)
+    {
+        const char *value = line + 14;
+        while (*value == ' ')
+        {
+            value++;
+        }
+        // Uma lista maior que o buffer seria cortada e poderia casar pela metade: ignora.
+        if (strlen(value) < sizeof(conn->if_none_match))
+        {
+            strcpy(conn->if_none_match, value);
+        }
+    }
+    else if (strncasecmp(line, "Connection:", 11) == 0)
+    {
+        const char *value = line + 11;
+        while (*value == ' ')
+        {
+            value++;
+        }
+        if (strncasecmp(value, "close", 5) == 0)
+        {
+            conn->keep_alive = false;
+        }
+        else if (strncasecmp(value, "keep-alive", 10) == 0)
+        {
+            conn->keep_alive = true;
+        }
+    }
+}
+
+/*
+ * Avanca a maquina de estados com os bytes acumulados no buffer. Cada linha eh examinada uma unica
+ * vez: scan_pos guarda ate onde o buffer ja foi percorrido entre chamadas de tcp_server_recv.
+ */
+static void http_parse(http_connection_t *conn)
+{
+    while (conn->state == HTTP_STATE_REQUEST_LINE || conn->state == HTTP_STATE_HEADERS)
+    {
+        char *eol = memchr(conn->buffer + conn->scan_pos, '\n', conn->length - conn->scan_pos);
+        if (!eol)
+        {
+            conn->scan_pos = conn->length;
+            return;
+        }
+
+        char *line = conn->buffer + conn->line_start;
+        uint16_t next_line = (uint16_t)(eol - conn->buffer) + 1;
+        *eol = '\0';
+        if (eol > line && eol[-1] == '\r')
+        {
+            eol[-1] = '\0';
+        }
+        conn->line_start = next_line;
+        conn->scan_pos = next_line;
+
+        if (conn->state == HTTP_STATE_REQUEST_LINE)
+        {
+            if (line[0] == '\0')
+            {
+                continue; // Ignora linhas em branco antes da requisicao.
+            }
+            conn->state = http_parse_request_line(conn, line) ? HTTP_STATE_HEADERS : HTTP_STATE_ERROR;
+        }
+        else if (line[0] != '\0')
+        {
+            http_parse_header(conn, line);
+        }
+        else
+        {
+            conn->body_start = next_line;
+            conn->state = HTTP_STATE_BODY;
+        }
+    }
+
+    if (conn->state == HTTP_STATE_BODY)
+    {
+        if (conn->body_start + conn->content_length > HTTP_REQUEST_BUFFER_SIZE)
+        {
+            conn->state = HTTP_STATE_ERROR;
+        }
+        else if (conn->length - conn->body_start >= conn->content_length)
+        {
+            conn->state = HTTP_STATE_COMPLETE;
+        }
+    }
+}
+
+// GET /events: transforma a conexao em um stream SSE.
+static void handle_events(http_connection_t *conn)
+{
+    http_start_event_stream(conn);
+}
+
+// GET /ws: handshake do WebSocket de amostras.
+static void handle_websocket(http_connection_t *conn)
+{
+    if (conn->upgrade_websocket && conn->ws_key[0] != '\0')
+    {
+        http_start_websocket(conn);
+    }
+    else
+    {
+        conn->keep_alive = false;
+        send_empty_response(conn, "400 Bad Request");
+    }
+}
+
+// GET /navigate: pagina pedida pelos botoes, para navegadores sem suporte a SSE.
+static void handle_navigate(http_connection_t *conn)
+{
+    char json_payload[128];
+    if (g_target_page != NULL)
+    {
+        snprintf(json_payload, sizeof(json_payload), "{\"goto\":\"%s\"}", g_target_page);
+        g_target_page = NULL;
+    }
+    else
+    {
+        snprintf(json_payload, sizeof(json_payload), "{\"goto\":null}");
+    }
+    send_json_response(conn, json_payload);
+}
+
+// POST /config: aplica os limites e offsets enviados pelo formulario e agenda a gravacao na flash.
+static void handle_config_post(http_connection_t *conn)
+{
+    parse_post_data(conn->buffer + conn->body_start, conn->content_length);
+    g_config_save_at_ms = to_ms_since_boot(get_absolute_time()) + CONFIG_SAVE_DELAY_MS;
+    g_config_dirty = true;
+    send_empty_response(conn, "200 OK");
+}
+
+// GET /getconfig: limites e offsets atuais.
+static void handle_getconfig(http_connection_t *conn)
+{
+    estacao_config_t config;
+    seqlock_read(&g_config_lock, &g_config, &config, sizeof(config));
+
+    char json_payload[512];
+    snprintf(json_payload, sizeof(json_payload),
+             "{\"temp_offset\":%.2f,\"temp_min\":%.2f,\"temp_max\":%.2f,"
+             "\"umid_offset\":%.2f,\"umid_min\":%.2f,\"umid_max\":%.2f,"
+             "\"press_offset\":%.2f,\"press_min\":%.2f,\"press_max\":%.2f,"
+             "\"alt_offset\":%.2f,\"alt_min\":%.2f,\"alt_max\":%.2f}",
+             config.temp_offset, config.temp_min, config.temp_max, config.umid_offset, config.umid_min,
+             config.umid_max, config.press_offset, config.press_min, config.press_max, config.alt_offset,
+             config.alt_min, config.alt_max);
+    send_json_response(conn, json_payload);
+}
+
+// Guarda a amostra no historico e atualiza os agregados de todas as resolucoes; os intervalos fechados
+// da resolucao marcada com 'archive' seguem para o arquivo na flash.
+static void history_add(const sensor_sample_t *amostra)
+{
+    history_push(&g_history, amostra);
+
+    history_entry_t entry;
+    history_get(&g_history, history_last(&g_history), &entry);
+    int32_t values[ROLLUP_QUANTITIES] = {entry.temperatura, entry.umidade, entry.pressao, entry.altitude};
+    for (size_t i = 0; i < HISTORY_RESOLUTION_COUNT; i++)
+    {
+        history_resolution_t *res = &g_history_resolutions[i];
+        rollup_bucket_t bucket;
+        if (rollup_add(&res->rollup, entry.timestamp_ms, values) && res->archive &&
+            rollup_get(&res->rollup, rollup_last(&res->rollup), &bucket))
+        {
+            int32_t means[FLASH_LOG_QUANTITIES];
+            for (int q = 0; q < FLASH_LOG_QUANTITIES; q++)
+            {
+                means[q] = bucket.stats[q].mean;
+            }
+            flash_log_append(&g_flash_log, bucket.start_ms, means);
+        }
+    }
+}
+
+// Formata um intervalo agregado: [inicio em ms, amostras, min, max, media de cada grandeza].
+static int history_format_bucket(char *buffer, size_t size, const rollup_bucket_t *bucket)
+{
+    int len = snprintf(buffer, size, "[%lu,%lu", (unsigned long)bucket->start_ms, (unsigned long)bucket->count);
+    for (int i = 0; i < ROLLUP_QUANTITIES && len > 0 && (size_t)len < size; i++)
+    {
+        const rollup_stat_t *stat = &bucket->stats[i];
+        len += snprintf(buffer + len, size - len, ",%ld,%ld,%ld", (long)stat->min, (long)stat->max, (long)stat->mean);
+    }
+    if (len > 0 && (size_t)len < size)
+    {
+        len += snprintf(buffer + len, size - len, "]");
+    }
+    return len;
+}
+
+// Formata o ponto de numero 'sequence' da resposta de /history; retorna -1 se ele ja foi descartado.
+static int history_format_point(const http_connection_t *conn, uint32_t sequence, char *buffer, size_t size)
+{
+    if (conn->history_res)
+    {
+        rollup_bucket_t bucket;
+        if (!rollup_get(&conn->history_res->rollup, sequence, &bucket))
+        {
+            return -1;
+        }
+        return history_format_bucket(buffer, size, &bucket);
+    }
+
+    // Amostra: [instante em ms, temperatura, umidade, pressao, altitude], nas unidades de history_entry_t.
+    history_entry_t entry;
+    if (!history_get(&g_history, sequence, &entry))
+    {
+        return -1;
+    }
+    return snprintf(buffer, size, "[%lu,%d,%u,%ld,%ld]", (unsigned long)entry.timestamp_ms, entry.temperatura,
+                    entry.umidade, (long)entry.pressao, (long)entry.altitude);
+}
+
+/*
+ * Corpo de /history, produzido aos poucos: a abertura do objeto, os pontos de conn->history_next ate
+ * conn->history_end e o fechamento (com o intervalo ainda aberto, nas resolucoes agregadas). O cursor
+ * guarda a etapa (history_step_t).
+ */
+static uint16_t history_generate(char *buffer, uint16_t size, uint32_t *cursor, void *arg)
+{
+    http_connection_t *conn = arg;
+    uint16_t length = 0;
+    char point[192];
+
+    if (*cursor == HISTORY_STEP_OPEN)
+    {
+        int n = snprintf(buffer, size, "{\"res\":\"%s\",\"now\":%lu,\"first\":%lu,\"last\":%lu,\"points\":[",
+                         conn->history_res ? conn->history_res->name : "raw",
+                         (unsigned long)to_ms_since_boot(get_absolute_time()), (unsigned long)conn->history_next,
+                         (unsigned long)conn->history_end);
+        if (n < 0 || n >= size)
+        {
+            return 0;
+        }
+        length = n;
+        *cursor = HISTORY_STEP_FIRST_POINT;
+    }
+
+    while (*cursor != HISTORY_STEP_DONE && conn->history_next <= conn->history_end)
+    {
+        int n = history_format_point(conn, conn->history_next, point + 1, sizeof(point) - 1);
+        if (n < 0)
+        {
+            conn->history_next++; // Descartado enquanto a resposta era enviada.
+            continue;
+        }
+
+        // O ponto eh formatado depois de point[0], que recebe a virgula quando necessario.
+        char *text = point + 1;
+        if (*cursor == HISTORY_STEP_POINTS)
+        {
+            *--text = ',';
+            n++;
+        }
+        if (length + n > size)
+        {
+            return length; // Continua no proximo pedaco.
+        }
+        memcpy(buffer + length, text, n);
+        length += n;
+        conn->history_next++;
+        *cursor = HISTORY_STEP_POINTS;
+    }
+
+    if (*cursor != HISTORY_STEP_DONE)
+    {
+        int n;
+        rollup_bucket_t bucket;
+        if (conn->history_res && rollup_get_open(&conn->history_res->rollup, &bucket))
+        {
+            n = snprintf(point, sizeof(point), "],\"open\":");
+            n += history_format_bucket(point + n, sizeof(point) - n, &bucket);
+            n += snprintf(point + n, sizeof(point) - n, "}");
+        }
+        else
+        {
+            n = snprintf(point, sizeof(point), conn->history_res ? "],\"open\":null}" : "]}");
+        }
+        if (length + n > size)
+        {
+            return length;
+        }
+        memcpy(buffer + length, point, n);
+        length += n;
+        *cursor = HISTORY_STEP_DONE;
+    }
+    return length;
+}
+
+/*
+ * GET /history?since=&limit=&res=: amostras guardadas em g_history ou, com res=1m, 1h ou 1d, os intervalos
+ * agregados dessa resolucao (o intervalo ainda aberto vai em "open"). Com 'since', devolve os primeiros
+ * 'limit' pontos de sequencia maior que 'since' (o cliente repete a consulta com since=last para receber
+ * so o que chegou depois). Sem 'since', devolve os 'limit' pontos mais recentes. Um 'since' maior que a
+ * ultima sequencia (a placa reiniciou) eh tratado como 0.
+ */
+static void handle_history(http_connection_t *conn)
+{
+    uint32_t since = 0;
+    uint32_t limit = HTTP_HISTORY_LIMIT;
+    bool has_since = http_query_uint(conn, "since", &since);
+    http_query_uint(conn, "limit", &limit);
+
+    char res_name[8];
+    conn->history_res = NULL;
+    if (http_query_param(conn, "res", res_name, sizeof(res_name)) && strcmp(res_name, "raw") != 0)
+    {
+        for (size_t i = 0; i < HISTORY_RESOLUTION_COUNT; i++)
+        {
+            if (strcmp(res_name, g_history_resolutions[i].name) == 0)
+            {
+                conn->history_res = &g_history_resolutions[i];
+            }
+        }
+        if (!conn->history_res)
+        {
+            send_empty_response(conn, "400 Bad Request");
+            return;
+        }
+    }
+
+    uint32_t first, last, capacity;
+    if (conn->history_res)
+    {
+        first = rollup_first(&conn->history_res->rollup);
+        last = rollup_last(&conn->history_res->rollup);
+        capacity = conn->history_res->capacity;
+    }
+    else
+    {
+        first = history_first(&g_history);
+        last = history_last(&g_history);
+        capacity = HISTORY_CAPACITY;
+    }
+    if (limit == 0 || limit > capacity)
+    {
+        limit = capacity;
+    }
+    if (since > last)
+    {
+        since = 0;
+    }
+
+    if (last == 0)
+    {
+        // Nada guardado ainda: nenhum ponto.
+        conn->history_next = 1;
+        conn->history_end = 0;
+    }
+    else if (has_since)
+    {
+        conn->history_next = since + 1 > first ? since + 1 : first;
+        conn->history_end = last - conn->history_next + 1 > limit ? conn->history_next + limit - 1 : last;
+    }
+    else
+    {
+        conn->history_end = last;
+        conn->history_next = last - first + 1 > limit ? last - limit + 1 : first;
+    }
+
+    char http_header[192];
+    int header_len = format_http_header(conn, http_header, sizeof(http_header), "200 OK", "application/json",
+                                        "Cache-Control: no-store\r\n", -1);
+    http_tx_add_copy(conn, http_header, header_len);
+    http_tx_add_generator(conn, history_generate, conn);
+}
+
+/*
+ * Corpo de /archive, produzido aos poucos a partir de conn->archive_reader, como o de /history. Cada ponto eh
+ * [boot, inicio do minuto em ms desde esse boot, temperatura, umidade, pressao, altitude], com as medias do
+ * minuto nas unidades de history_entry_t.
+ */
+static uint16_t archive_generate(char *buffer, uint16_t size, uint32_t *cursor, void *arg)
+{
+    http_connection_t *conn = arg;
+    uint16_t length = 0;
+    char point[96];
+
+    if (*cursor == HISTORY_STEP_OPEN)
+    {
+        int n = snprintf(buffer, size, "{\"boot\":%u,\"now\":%lu,\"points\":[", g_flash_log.boot,
+                         (unsigned long)to_ms_since_boot(get_absolute_time()));
+        if (n < 0 || n >= size)
+        {
+            return 0;
+        }
+        length = n;
+        *cursor = HISTORY_STEP_FIRST_POINT;
+    }
+
+    while (*cursor != HISTORY_STEP_DONE && conn->archive_remaining > 0)
+    {
+        // O leitor so avanca depois que o ponto cabe no pedaco, entao le de uma copia.
+        flash_log_reader_t reader = conn->archive_reader;
+        flash_log_record_t record;
+        if (!flash_log_read(&g_flash_log, &reader, &record))
+        {
+            break;
+        }
+
+        int n = snprintf(point, sizeof(point), "%s[%u,%lu,%ld,%ld,%ld,%ld]", *cursor == HISTORY_STEP_POINTS ? "," : "",
+                         record.boot, (unsigned long)record.timestamp_ms, (long)record.values[0],
+                         (long)record.values[1], (long)record.values[2], (long)record.values[3]);
+        if (length + n > size)
+        {
+            return length; // Continua no proximo pedaco.
+        }
+        memcpy(buffer + length, point, n);
+        length += n;
+        conn->archive_reader = reader;
+        conn->archive_remaining--;
+        *cursor = HISTORY_STEP_POINTS;
+    }
+
+    if (*cursor != HISTORY_STEP_DONE)
+    {
+        if (length + 2 > size)
+        {
+            return length;
+        }
+        memcpy(buffer + length, "]}", 2);
+        length += 2;
+        *cursor = HISTORY_STEP_DONE;
+    }
+    return length;
+}
+
+/*
+ * GET /archive?limit=: as 'limit' medias por minuto mais recentes guardadas na flash (HTTP_ARCHIVE_LIMIT por
+ * padrao; limit=0 devolve tudo), em ordem cronologica. Inclui os minutos que ainda nao foram gravados.
+ */
+static void handle_archive(http_connection_t *conn)
+{
+    uint32_t limit = HTTP_ARCHIVE_LIMIT;
+    http_query_uint(conn, "limit", &limit);
+    if (limit == 0)
+    {
+        limit = UINT32_MAX;
+    }
+
+    flash_log_reader_init(&g_flash_log, &conn->archive_reader, limit);
+    conn->archive_remaining = limit;
+
+    char http_header[192];
+    int header_len = format_http_header(conn, http_header, sizeof(http_header), "200 OK", "application/json",
+                                        "Cache-Control: no-store\r\n", -1);
+    http_tx_add_copy(conn, http_header, header_len);
+    http_tx_add_generator(conn, archive_generate, conn);
+}
+
+// GET /estado: leitura atual dos sensores.
+static void handle_estado(http_connection_t *conn)
+{
+    sensor_sample_t amostra;
+    seqlock_read(&g_estado_lock, &g_estado, &amostra, sizeof(amostra));
+
+    char json_payload[128];
+    format_estado_json(json_payload, sizeof(json_payload), &amostra);
+    send_json_response(conn, json_payload);
+}
+
+// GET /: pagina inicial.
+static void handle_inicio(http_connection_t *conn)
+{
+    send_gzip_response(conn, HTML_CONTENT_TYPE, PAGE_CACHE_CONTROL, WEB_PAGE_INICIO_ETAG, WEB_PAGE_INICIO,
+                       sizeof(WEB_PAGE_INICIO));
+}
+
+// GET /config: pagina de configuracoes.
+static void handle_config_page(http_connection_t *conn)
+{
+    send_gzip_response(conn, HTML_CONTENT_TYPE, PAGE_CACHE_CONTROL, WEB_PAGE_CONFIG_ETAG, WEB_PAGE_CONFIG,
+                       sizeof(WEB_PAGE_CONFIG));
+}
+
+// GET /temperatura, /umidade, /pressao e /altitude: a mesma pagina, que escolhe a grandeza pelo caminho.
+static void handle_grafico(http_connection_t *conn)
+{
+    send_gzip_response(conn, HTML_CONTENT_TYPE, PAGE_CACHE_CONTROL, WEB_PAGE_GRAFICO_ETAG, WEB_PAGE_GRAFICO,
+                       sizeof(WEB_PAGE_GRAFICO));
+}
+
+// GET /trace: spans dos dois nucleos no formato JSON do Chrome (chrome://tracing ou ui.perfetto.dev).
+static void handle_trace(http_connection_t *conn)
+{
+    perf_export_start(&conn->trace_export);
+
+    char http_header[192];
+    int header_len = format_http_header(conn, http_header, sizeof(http_header), "200 OK", "application/json",
+                                        "Cache-Control: no-store\r\n", -1);
+    http_tx_add_copy(conn, http_header, header_len);
+    http_tx_add_generator(conn, perf_export_generate, &conn->trace_export);
+}
+
+// GET /metrics: contadores, medidores e histogramas no formato de texto do Prometheus.
+static void handle_metrics(http_connection_t *conn)
+{
+    char http_header[192];
+    int header_len = format_http_header(conn, http_header, sizeof(http_header), "200 OK",
+                                        "text/plain; version=0.0.4", "Cache-Control: no-store\r\n", -1);
+    http_tx_add_copy(conn, http_header, header_len);
+    http_tx_add_generator(conn, metrics_generate, conn);
+}
+
+/*
+ * Rotas do servidor: metodo + caminho exato -> funcao. A tabela eh consultada por busca binaria, entao
+ * DEVE estar em ordem crescente de caminho (strcmp) e, para o mesmo caminho, as entradas ficam juntas.
+ */
+static const http_route_t HTTP_ROUTES[] = {
+    {"/", "GET", handle_inicio},
+    {"/altitude", "GET", handle_grafico},
+    {"/archive", "GET", handle_archive},
+    {"/config", "GET", handle_config_page},
+    {"/config", "POST", handle_config_post},
+    {"/estado", "GET", handle_estado},
+    {"/events", "GET", handle_events},
+    {"/getconfig", "GET", handle_getconfig},
+    {"/history", "GET", handle_history},
+    {"/metrics", "GET", handle_metrics},
+    {"/navigate", "GET", handle_navigate},
+    {"/pressao", "GET", handle_grafico},
+    {"/temperatura", "GET", handle_grafico},
+    {"/trace", "GET", handle_trace},
+    {"/umidade", "GET", handle_grafico},
+    {"/ws", "GET", handle_websocket},
+};
+#define HTTP_ROUTE_COUNT (sizeof(HTTP_ROUTES) / sizeof(HTTP_ROUTES[0]))
+#define HTTP_ROUTE_ASSETS HTTP_ROUTE_COUNT          // Indice devolvido por http_dispatch para os arquivos de /assets.
+#define HTTP_ROUTE_UNMATCHED (HTTP_ROUTE_COUNT + 1) // Indice devolvido por http_dispatch para 404 e 405.
+
+// Requisicoes e latencias por indice de http_dispatch. Alterado e lido apenas no contexto do lwIP.
+static http_route_metrics_t g_route_metrics[HTTP_ROUTE_UNMATCHED + 1];
+
+// Registra a latencia da resposta que acabou de ser entregue inteira ao lwIP.
+static void http_metrics_response_done(http_connection_t *conn)
+{
+    histogram_observe(&g_route_metrics[conn->metrics_route].latency, time_us_32() - conn->metrics_start_us);
+    conn->metrics_pending = false;
+}
+
+// Compara o caminho procurado com o de uma rota (bsearch).
+static int http_route_compare(const void *key, const void *element)
+{
+    return strcmp((const char *)key, ((const http_route_t *)element)->path);
+}
+
+/*
+ * Encaminha a requisicao completa para a rota correspondente. Caminhos desconhecidos recebem 404;
+ * caminhos conhecidos com outro metodo recebem 405 e o cabecalho Allow com os metodos aceitos.
+ * Retorna o indice da rota em HTTP_ROUTES, HTTP_ROUTE_ASSETS ou HTTP_ROUTE_UNMATCHED.
+ */
+static uint16_t http_dispatch(http_connection_t *conn)
+{
+    const http_route_t *route = bsearch(conn->path, HTTP_ROUTES, HTTP_ROUTE_COUNT, sizeof(HTTP_ROUTES[0]),
+                                        http_route_compare);
+    if (!route)
+    {
+        // Arquivos de /assets: o nome muda junto com o conteudo, entao o navegador pode guarda-los para sempre.
+        const web_asset_t *asset = web_asset_find(conn->path);
+        if (asset && strcmp(conn->method, "GET") == 0)
+        {
+            send_gzip_response(conn, asset->content_type, ASSET_CACHE_CONTROL, asset->etag, asset->data,
+                               asset->length);
+            return HTTP_ROUTE_ASSETS;
+        }
+        if (asset)
+        {
+            send_empty_response_with(conn, "405 Method Not Allowed", "Allow: GET\r\n");
+        }
+        else
+        {
+            send_empty_response(conn, "404 Not Found");
+        }
+        return HTTP_ROUTE_UNMATCHED;
+    }
+
+    // bsearch pode cair em qualquer entrada do caminho: volta para a primeira.
+    while (route > HTTP_ROUTES && strcmp(route[-1].path, conn->path) == 0)
+    {
+        route--;
+    }
+
+    char allow[48] = "Allow: ";
+    size_t allow_len = strlen(allow);
+    const http_route_t *end = HTTP_ROUTES + HTTP_ROUTE_COUNT;
+    for (; route < end && strcmp(route->path, conn->path) == 0; route++)
+    {
+        if (strcmp(route->method, conn->method) == 0)
+        {
+            route->handler(conn);
+            return route - HTTP_ROUTES;
+        }
+        allow_len += snprintf(allow + allow_len, sizeof(allow) - allow_len, "%s%s",
+                              allow_len > 7 ? ", " : "", route->method);
+    }
+    snprintf(allow + allow_len, sizeof(allow) - allow_len, "\r\n");
+    send_empty_response_with(conn, "405 Method Not Allowed", allow);
+    return HTTP_ROUTE_UNMATCHED;
+}
+
+// Formata um span como um evento "X" (trecho completo) do JSON do Chrome, precedido de virgula; ts e dur em us.
+static int perf_format_event(char *buffer, size_t size, uint8_t core, const perf_trace_event_t *event,
+                             uint64_t now_us)
+{
+    char route_name[HTTP_METHOD_SIZE + HTTP_PATH_SIZE];
+    const char *name = "?";
+    const char *category = "?";
+    if (event->id < PERF_SPAN_COUNT)
+    {
+        name = PERF_SPANS[event->id].name;
+        category = PERF_SPANS[event->id].category;
+    }
+    if (event->id == PERF_SPAN_HTTP_ROUTE)
+    {
+        // As rotas aparecem com o proprio nome, para comparar as duracoes de cada uma.
+        if (event->arg < HTTP_ROUTE_COUNT)
+        {
+            snprintf(route_name, sizeof(route_name), "%s %s", HTTP_ROUTES[event->arg].method,
+                     HTTP_ROUTES[event->arg].path);
+        }
+        else
+        {
+            snprintf(route_name, sizeof(route_name), "%s", event->arg == HTTP_ROUTE_ASSETS ? "GET /assets" : "sem rota");
+        }
+        name = route_name;
+    }
+
+    int len = snprintf(buffer, size,
+                       ",{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu,\"dur\":%lu,"
+                       "\"args\":{\"arg\":%u",
+                       name, category, core, (unsigned long long)perf_trace_time_us(now_us, event->start_us),
+                       (unsigned long)event->duration_us, event->arg);
+    if (event->cycles != 0 && len > 0 && (size_t)len < size)
+    {
+        len += snprintf(buffer + len, size - len, ",\"cycles\":%lu", (unsigned long)event->cycles);
+    }
+    if (len > 0 && (size_t)len < size)
+    {
+        len += snprintf(buffer + len, size - len, "}}");
+    }
+    return len;
+}
+
+// Fixa o que entra em uma exportacao do trace de desempenho: os spans registrados ate agora.
+static void perf_export_start(perf_export_t *export)
+{
+    export->now_us = time_us_64();
+    for (uint8_t core = 0; core < PERF_TRACE_CORES; core++)
+    {
+        export->end[core] = perf_trace_last(&g_perf_trace, core);
+    }
+    export->core = 0;
+    export->next = perf_trace_first(&g_perf_trace, 0);
+}
+
+/*
+ * Corpo do JSON do trace de desempenho, produzido aos poucos como o de /history: os nomes dos nucleos e
+ * um evento por span, do mais antigo para o mais novo, primeiro o nucleo 0 e depois o 1. Os mais antigos
+ * vao primeiro porque sao os proximos a serem sobrescritos; os que forem sobrescritos durante a
+ * exportacao (os proprios tcp_write dela registram spans) sao pulados.
+ */
+static uint16_t perf_export_generate(char *buffer, uint16_t size, uint32_t *cursor, void *arg)
+{
+    perf_export_t *export = arg;
+    uint16_t length = 0;
+    char event_json[192];
+
+    if (*cursor == HISTORY_STEP_OPEN)
+    {
+        int n = snprintf(buffer, size,
+                         "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"clk_sys_hz\":%lu},\"traceEvents\":["
+                         "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"nucleo 0 (rede)\"}},"
+                         "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"nucleo 1 (sensores)\"}}",
+                         (unsigned long)clock_get_hz(clk_sys));
+        if (n < 0 || n >= size)
+        {
+            return 0;
+        }
+        length = n;
+        *cursor = HISTORY_STEP_POINTS;
+    }
+
+    while (*cursor != HISTORY_STEP_DONE && export->core < PERF_TRACE_CORES)
+    {
+        if (export->next == 0 || export->next > export->end[export->core])
+        {
+            export->core++; // Nucleo terminado (ou sem spans): passa ao proximo.
+            export->next = export->core < PERF_TRACE_CORES ? perf_trace_first(&g_perf_trace, export->core) : 0;
+            continue;
+        }
+
+        perf_trace_event_t event;
+        if (!perf_trace_get(&g_perf_trace, export->core, export->next, &event))
+        {
+            uint32_t first = perf_trace_first(&g_perf_trace, export->core);
+            export->next = first > export->next ? first : export->next + 1;
+            continue;
+        }
+        int n = perf_format_event(event_json, sizeof(event_json), export->core, &event, export->now_us);
+        if (n < 0 || n >= (int)sizeof(event_json))
+        {
+            export->next++; // Nao deveria acontecer: descarta o span em vez de gerar JSON invalido.
+            continue;
+        }
+        if (length + n > size)
+        {
+            return length; // Continua no proximo pedaco.
+        }
+        memcpy(buffer + length, event_json, n);
+        length += n;
+        export->next++;
+    }
+
+    if (*cursor != HISTORY_STEP_DONE)
+    {
+        if (length + 2 > size)
+        {
+            return length;
+        }
+        memcpy(buffer + length, "]}", 2);
+        length += 2;
+        *cursor = HISTORY_STEP_DONE;
+    }
+    return length;
+}
+
+// Envia o trace de desempenho pela USB (comando 'p'), entre as linhas "PERF inicio" e "PERF fim".
+static void perf_export_usb()
+{
+    perf_export_t export;
+    perf_export_start(&export);
+
+    char buffer[512];
+    uint32_t cursor = HISTORY_STEP_OPEN;
+    uint16_t length;
+    printf("PERF inicio\n");
+    while ((length = perf_export_generate(buffer, sizeof(buffer), &cursor, &export)) > 0)
+    {
+        fwrite(buffer, 1, length, stdout);
+    }
+    printf("\nPERF fim\n");
+}
+
+// Pools do lwIP expostos em /metrics, com o nome usado no rotulo 'pool'.
+static const struct
+{
+    memp_t id;
+    const char *name;
+} METRICS_POOLS[] = {
+    {MEMP_TCP_PCB, "tcp_pcb"},
+    {MEMP_TCP_SEG, "tcp_seg"},
+    {MEMP_PBUF, "pbuf"},
+    {MEMP_PBUF_POOL, "pbuf_pool"},
+};
+#define METRICS_POOL_COUNT (sizeof(METRICS_POOLS) / sizeof(METRICS_POOLS[0]))
+
+// Acrescenta texto formatado em buffer a partir de length; um texto que nao cabe deixa length >= size.
+static int metrics_append(char *buffer, size_t size, int length, const char *format, ...)
+{
+    if (length < 0 || (size_t)length >= size)
+    {
+        return length;
+    }
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer + length, size - length, format, args);
+    va_end(args);
+    return n < 0 ? n : length + n;
+}
+
+// Rotulos method e route de um indice de http_dispatch.
+static void metrics_route_labels(uint16_t route, char *buffer, size_t size)
+{
+    if (route < HTTP_ROUTE_COUNT)
+    {
+        snprintf(buffer, size, "method=\"%s\",route=\"%s\"", HTTP_ROUTES[route].method, HTTP_ROUTES[route].path);
+    }
+    else if (route == HTTP_ROUTE_ASSETS)
+    {
+        snprintf(buffer, size, "method=\"GET\",route=\"/assets\"");
+    }
+    else
+    {
+        snprintf(buffer, size, "method=\"*\",route=\"sem_rota\"");
+    }
+}
+
+/*
+ * Linha 'line' de um histograma em segundos: os baldes acumulados (le), do primeiro ao +Inf, e por fim
+ * _sum e _count. Retorna -1 depois da ultima.
+ */
+static int metrics_format_histogram(char *buffer, size_t size, const char *name, const char *labels,
+                                    const histogram_t *histogram, uint32_t line)
+{
+    const char *comma = labels[0] ? "," : "";
+    if (line < HISTOGRAM_BUCKETS - 1)
+    {
+        uint32_t bound_us = histogram_bound_us(line);
+        return snprintf(buffer, size, "%s_bucket{%s%sle=\"%lu.%06lu\"} %lu\n", name, labels, comma,
+                        (unsigned long)(bound_us / 1000000), (unsigned long)(bound_us % 1000000),
+                        (unsigned long)histogram_cumulative(histogram, line));
+    }
+    if (line == HISTOGRAM_BUCKETS - 1)
+    {
+        return snprintf(buffer, size, "%s_bucket{%s%sle=\"+Inf\"} %lu\n", name, labels, comma,
+                        (unsigned long)histogram->count);
+    }
+    if (line == HISTOGRAM_BUCKETS)
+    {
+        const char *open = labels[0] ? "{" : "";
+        const char *close = labels[0] ? "}" : "";
+        return snprintf(buffer, size, "%s_sum%s%s%s %llu.%06llu\n%s_count%s%s%s %lu\n", name, open, labels, close,
+                        (unsigned long long)(histogram->sum_us / 1000000),
+                        (unsigned long long)(histogram->sum_us % 1000000), name, open, labels, close,
+                        (unsigned long)histogram->count);
+    }
+    return -1;
+}
+
+// Linha 'line' da secao de medidores e contadores simples; retorna 0 para pular a linha e -1 no fim.
+static int metrics_format_gauge(char *buffer, size_t size, uint32_t line)
+{
+    sensor_sample_t amostra;
+    int n = 0;
+    switch (line)
+    {
+    case 0:
+    case 1:
+    case 2:
+    case 3:
+    case 4:
+        seqlock_read(&g_estado_lock, &g_estado, &amostra, sizeof(amostra));
+        if (line == 0)
+        {
+            return snprintf(buffer, size,
+                            "# HELP estacao_temperatura_celsius Temperatura da ultima amostra.\n"
+                            "# TYPE estacao_temperatura_celsius gauge\nestacao_temperatura_celsius %.2f\n",
+                            amostra.temperatura);
+        }
+        if (line == 1)
+        {
+            return snprintf(buffer, size,
+                            "# HELP estacao_umidade_percent Umidade relativa da ultima amostra.\n"
+                            "# TYPE estacao_umidade_percent gauge\nestacao_umidade_percent %.2f\n",
+                            amostra.umidade);
+        }
+        if (line == 2)
+        {
+            return snprintf(buffer, size,
+                            "# HELP estacao_pressao_pascals Pressao atmosferica da ultima amostra.\n"
+                            "# TYPE estacao_pressao_pascals gauge\nestacao_pressao_pascals %.0f\n",
+                            amostra.pressao * 1000.0f);
+        }
+        if (line == 3)
+        {
+            return snprintf(buffer, size,
+                            "# HELP estacao_altitude_meters Altitude estimada pela pressao.\n"
+                            "# TYPE estacao_altitude_meters gauge\nestacao_altitude_meters %.1f\n",
+                            amostra.altitude);
+        }
+        return snprintf(buffer, size,
+                        "# HELP estacao_sensor_samples_total Amostras produzidas pelo nucleo 1.\n"
+                        "# TYPE estacao_sensor_samples_total counter\nestacao_sensor_samples_total %lu\n",
+                        (unsigned long)amostra.sequence);
+    case 5:
+        return snprintf(buffer, size,
+                        "# HELP estacao_sensor_i2c_errors_total Transacoes I2C com falha.\n"
+                        "# TYPE estacao_sensor_i2c_errors_total counter\n"
+                        "estacao_sensor_i2c_errors_total{sensor=\"aht20\"} %lu\n"
+                        "estacao_sensor_i2c_errors_total{sensor=\"bmp280\"} %lu\n",
+                        (unsigned long)g_sensor_counters.aht20_i2c_errors,
+                        (unsigned long)g_sensor_counters.bmp280_i2c_errors);
+    case 6:
+        return snprintf(buffer, size,
+                        "# HELP estacao_sensor_retries_total Leituras repetidas porque o sensor estava ocupado.\n"
+                        "# TYPE estacao_sensor_retries_total counter\n"
+                        "estacao_sensor_retries_total{sensor=\"aht20\"} %lu\n",
+                        (unsigned long)g_sensor_counters.aht20_retries);
+    case 7:
+        return snprintf(buffer, size,
+                        "# HELP estacao_sensor_crc_errors_total Leituras recusadas pelo CRC.\n"
+                        "# TYPE estacao_sensor_crc_errors_total counter\n"
+                        "estacao_sensor_crc_errors_total{sensor=\"aht20\"} %lu\n",
+                        (unsigned long)g_sensor_counters.aht20_crc_errors);
+    case 8:
+        return snprintf(buffer, size,
+                        "# HELP estacao_sensor_read_failures_total Ciclos em que a leitura anterior foi mantida.\n"
+                        "# TYPE estacao_sensor_read_failures_total counter\n"
+                        "estacao_sensor_read_failures_total{sensor=\"aht20\"} %lu\n"
+                        "estacao_sensor_read_failures_total{sensor=\"bmp280\"} %lu\n",
+                        (unsigned long)g_sensor_counters.aht20_failures,
+                        (unsigned long)g_sensor_counters.bmp280_failures);
+    case 9:
+        return snprintf(buffer, size,
+                        "# HELP estacao_sensor_ring_dropped_total Amostras descartadas com a fila entre os nucleos cheia.\n"
+                        "# TYPE estacao_sensor_ring_dropped_total counter\nestacao_sensor_ring_dropped_total %lu\n",
+                        (unsigned long)__atomic_load_n(&g_sensor_ring.dropped, __ATOMIC_RELAXED));
+    case 10:
+        return snprintf(buffer, size,
+                        "# HELP estacao_heap_free_bytes Heap do malloc ainda livre.\n"
+                        "# TYPE estacao_heap_free_bytes gauge\nestacao_heap_free_bytes %lu\n"
+                        "# HELP estacao_heap_size_bytes Tamanho do heap do malloc.\n"
+                        "# TYPE estacao_heap_size_bytes gauge\nestacao_heap_size_bytes %lu\n",
+                        (unsigned long)heap_free_bytes(), (unsigned long)heap_total_bytes());
+    case 11:
+        return snprintf(buffer, size,
+                        "# HELP estacao_lwip_heap_used_bytes Heap do lwIP em uso.\n"
+                        "# TYPE estacao_lwip_heap_used_bytes gauge\nestacao_lwip_heap_used_bytes %lu\n"
+                        "# HELP estacao_lwip_heap_high_water_bytes Maior uso do heap do lwIP.\n"
+                        "# TYPE estacao_lwip_heap_high_water_bytes gauge\nestacao_lwip_heap_high_water_bytes %lu\n",
+                        (unsigned long)lwip_stats.mem.used, (unsigned long)lwip_stats.mem.max);
+    case 12:
+        return snprintf(buffer, size,
+                        "# HELP estacao_lwip_heap_size_bytes Tamanho do heap do lwIP.\n"
+                        "# TYPE estacao_lwip_heap_size_bytes gauge\nestacao_lwip_heap_size_bytes %lu\n"
+                        "# HELP estacao_lwip_heap_errors_total Alocacoes recusadas no heap do lwIP.\n"
+                        "# TYPE estacao_lwip_heap_errors_total counter\nestacao_lwip_heap_errors_total %lu\n",
+                        (unsigned long)lwip_stats.mem.avail, (unsigned long)lwip_stats.mem.err);
+    case 13:
+    case 14:
+    case 15:
+    case 16:
+    {
+        // Uma metrica por linha, com um rotulo 'pool' para cada pool de METRICS_POOLS.
+        static const char *const NAMES[] = {"estacao_lwip_pool_used", "estacao_lwip_pool_high_water",
+                                            "estacao_lwip_pool_size", "estacao_lwip_pool_errors_total"};
+        static const char *const HELP[] = {"Elementos do pool em uso.", "Maior uso do pool.",
+                                           "Elementos do pool.", "Alocacoes recusadas pelo pool."};
+        uint32_t metric = line - 13;
+        n = metrics_append(buffer, size, n, "# HELP %s %s\n# TYPE %s %s\n", NAMES[metric], HELP[metric],
+                           NAMES[metric], metric == 3 ? "counter" : "gauge");
+        for (size_t i = 0; i < METRICS_POOL_COUNT; i++)
+        {
+            const struct stats_mem *stat = lwip_stats.memp[METRICS_POOLS[i].id];
+            uint32_t values[] = {stat->used, stat->max, stat->avail, stat->err};
+            n = metrics_append(buffer, size, n, "%s{pool=\"%s\"} %lu\n", NAMES[metric], METRICS_POOLS[i].name,
+                               (unsigned long)values[metric]);
+        }
+        return n;
+    }
+    case 17:
+        if (!g_wifi_rssi_ok)
+        {
+            return 0;
+        }
+        return snprintf(buffer, size,
+                        "# HELP estacao_wifi_rssi_dbm Intensidade do sinal do Wi-Fi.\n"
+                        "# TYPE estacao_wifi_rssi_dbm gauge\nestacao_wifi_rssi_dbm %ld\n",
+                        (long)g_wifi_rssi);
+    case 18:
+        for (int i = 0; i < HTTP_MAX_CONNECTIONS; i++)
+        {
+            n += g_http_connections[i].in_use;
+        }
+        return snprintf(buffer, size,
+                        "# HELP estacao_http_connections Contextos de conexao HTTP em uso.\n"
+                        "# TYPE estacao_http_connections gauge\nestacao_http_connections %d\n"
+                        "# HELP estacao_http_connections_max Contextos de conexao HTTP disponiveis.\n"
+                        "# TYPE estacao_http_connections_max gauge\nestacao_http_connections_max %d\n",
+                        n, HTTP_MAX_CONNECTIONS);
+    case 19:
+    {
+        uint64_t agora_us = time_us_64();
+        return snprintf(buffer, size,
+                        "# HELP estacao_uptime_seconds Tempo desde o boot.\n"
+                        "# TYPE estacao_uptime_seconds counter\nestacao_uptime_seconds %llu.%03llu\n",
+                        (unsigned long long)(agora_us / 1000000), (unsigned long long)(agora_us % 1000000 / 1000));
+    }
+    default:
+        return -1;
+    }
+}
+
+/*
+ * Linha 'line' da secao 'section' de /metrics; retorna 0 para pular a linha e -1 no fim da secao. Os
+ * histogramas sao copiados para conn->metrics_histogram na primeira linha de cada um, para que os baldes,
+ * _sum e _count enviados em pedacos diferentes sejam da mesma versao.
+ */
+static int metrics_format(http_connection_t *conn, uint32_t section, uint32_t line, char *buffer, size_t size)
+{
+    char labels[HTTP_METHOD_SIZE + HTTP_PATH_SIZE + 24];
+    switch (section)
+    {
+    case METRICS_SECTION_GAUGES:
+        return metrics_format_gauge(buffer, size, line);
+    case METRICS_SECTION_LOOP_JITTER:
+        if (line == 0)
+        {
+            conn->metrics_histogram = g_loop_jitter;
+            return snprintf(buffer, size,
+                            "# HELP estacao_loop_jitter_seconds Atraso de cada volta do loop principal alem da pausa.\n"
+                            "# TYPE estacao_loop_jitter_seconds histogram\n");
+        }
+        return metrics_format_histogram(buffer, size, "estacao_loop_jitter_seconds", "", &conn->metrics_histogram,
+                                        line - 1);
+    case METRICS_SECTION_REQUESTS:
+        if (line == 0)
+        {
+            return snprintf(buffer, size,
+                            "# HELP estacao_http_requests_total Requisicoes HTTP por rota.\n"
+                            "# TYPE estacao_http_requests_total counter\n");
+        }
+        if (line - 1 > HTTP_ROUTE_UNMATCHED)
+        {
+            return -1;
+        }
+        if (g_route_metrics[line - 1].requests == 0)
+        {
+            return 0;
+        }
+        metrics_route_labels(line - 1, labels, sizeof(labels));
+        return snprintf(buffer, size, "estacao_http_requests_total{%s} %lu\n", labels,
+                        (unsigned long)g_route_metrics[line - 1].requests);
+    case METRICS_SECTION_LATENCY:
+    {
+        if (line == 0)
+        {
+            return snprintf(buffer, size,
+                            "# HELP estacao_http_request_duration_seconds Do despacho ate a resposta inteira entregue ao lwIP.\n"
+                            "# TYPE estacao_http_request_duration_seconds histogram\n");
+        }
+        // HISTOGRAM_BUCKETS + 1 linhas por rota (a ultima com _sum e _count); rotas sem requisicoes ficam de fora.
+        uint32_t route = (line - 1) / (HISTOGRAM_BUCKETS + 1);
+        uint32_t k = (line - 1) % (HISTOGRAM_BUCKETS + 1);
+        if (route > HTTP_ROUTE_UNMATCHED)
+        {
+            return -1;
+        }
+        if (k == 0)
+        {
+            conn->metrics_histogram = g_route_metrics[route].latency;
+        }
+        if (conn->metrics_histogram.count == 0)
+        {
+            return 0;
+        }
+        metrics_route_labels(route, labels, sizeof(labels));
+        return metrics_format_histogram(buffer, size, "estacao_http_request_duration_seconds", labels,
+                                        &conn->metrics_histogram, k);
+    }
+    default:
+        return -1;
+    }
+}
+
+/*
+ * Corpo de /metrics, produzido aos poucos como o de /history: uma linha de cada secao por vez, com no maximo
+ * METRICS_PIECE_SIZE bytes cada, ate a ultima secao.
+ */
+static uint16_t metrics_generate(char *buffer, uint16_t size, uint32_t *cursor, void *arg)
+{
+    http_connection_t *conn = arg;
+    uint16_t length = 0;
+    char piece[METRICS_PIECE_SIZE];
+
+    while ((*cursor >> 24) < METRICS_SECTION_COUNT)
+    {
+        int n = metrics_format(conn, *cursor >> 24, *cursor & 0xFFFFFF, piece, sizeof(piece));
+        if (n < 0)
+        {
+            *cursor = ((*cursor >> 24) + 1) << 24; // Fim da secao: passa a proxima.
+            continue;
+        }
+        if (n >= (int)sizeof(piece))
+        {
+            n = 0; // Nao deveria acontecer: descarta a linha em vez de gerar texto truncado.
+        }
+        if (length + n > size)
+        {
+            return length; // Continua no proximo pedaco.
+        }
+        memcpy(buffer + length, piece, n);
+        length += n;
+        (*cursor)++;
+    }
+    return length;
+}
+
+/*
+ * Descarta a requisicao ja respondida do buffer, preservando os bytes seguintes (requisicoes
+ * enviadas em pipeline na mesma conexao), e reinicia a maquina de estados.
+ */
+static void http_consume_request(http_connection_t *conn)
+{
+    uint16_t request_end = conn->body_start + conn->content_length;
+    uint16_t remaining = conn->length - request_end;
+
+    memmove(conn->buffer, conn->buffer + request_end, remaining);
+    conn->length = remaining;
+    conn->line_start = 0;
+    conn->scan_pos = 0;
+    conn->body_start = 0;
+    conn->content_length = 0;
+    conn->upgrade_websocket = false;
+    conn->ws_key[0] = '\0';
+    conn->if_none_match[0] = '\0';
+    conn->state = HTTP_STATE_REQUEST_LINE;
+}
+
+/*
+ * Copia para o buffer os dados pendentes e responde as requisicoes completas, em ordem. Enquanto
+ * uma resposta ainda estiver sendo entregue, as requisicoes seguintes (pipeline) aguardam no buffer
+ * e os bytes que nao couberem ficam em rx_pending, sem confirmacao (tcp_recved), o que reduz a
+ * janela TCP do cliente. O processamento eh retomado em tcp_sent.
+ */
+static err_t http_connection_process(http_connection_t *conn)
+{
+    while (true)
+    {
+        // Copia o que cabe no buffer; o restante do pbuf eh copiado assim que houver espaco.
+        struct pbuf *p = conn->rx_pending;
+        if (p)
+        {
+            uint16_t copied = pbuf_copy_partial(p, conn->buffer + conn->length,
+                                                HTTP_REQUEST_BUFFER_SIZE - conn->length, conn->rx_offset);
+            conn->length += copied;
+            conn->rx_offset += copied;
+            if (conn->rx_offset == p->tot_len)
+            {
+                tcp_recved(conn->pcb, p->tot_len);
+                pbuf_free(p);
+                conn->rx_pending = NULL;
+                conn->rx_offset = 0;
+            }
+        }
+
+        if (conn->mode == HTTP_MODE_WEBSOCKET)
+        {
+            if (!ws_process_frames(conn))
+            {
+                return http_connection_close(conn);
+            }
+            if (!conn->rx_pending)
+            {
+                return ERR_OK;
+            }
+            continue;
+        }
+        if (conn->mode != HTTP_MODE_REQUEST)
+        {
+            return ERR_OK;
+        }
+
+        http_parse(conn);
+        if (conn->state == HTTP_STATE_COMPLETE)
+        {
+            if (http_tx_busy(conn))
+            {
+                return ERR_OK; // Responde depois que a resposta anterior for entregue.
+            }
+
+            conn->requests_served++;
+            if (conn->requests_served >= HTTP_KEEPALIVE_MAX)
+            {
+                conn->keep_alive = false;
+            }
+
+            perf_span_t span = perf_span_begin();
+            uint16_t route = http_dispatch(conn);
+            perf_trace_end(&g_perf_trace, span, PERF_SPAN_HTTP_ROUTE, route);
+            g_route_metrics[route].requests++;
+            conn->metrics_route = route;
+            conn->metrics_start_us = span.start_us;
+            conn->metrics_pending = true;
+            http_consume_request(conn);
+            if (!conn->keep_alive)
+            {
+                conn->close_after_tx = true;
+            }
+
+            err_t result = http_tx_pump(conn);
+            if (result != ERR_OK || conn->close_after_tx)
+            {
+                return result; // Conexao fechada ou aguardando o fim da resposta para fechar.
+            }
+            continue;
+        }
+
+        // Buffer cheio sem uma requisicao completa: a requisicao eh grande demais.
+        if (conn->state != HTTP_STATE_ERROR && conn->length == HTTP_REQUEST_BUFFER_SIZE)
+        {
+            conn->state = HTTP_STATE_ERROR;
+        }
+        if (conn->state == HTTP_STATE_ERROR)
+        {
+            if (http_tx_busy(conn))
+            {
+                return ERR_OK;
+            }
+            conn->keep_alive = false;
+            conn->close_after_tx = true;
+            send_empty_response(conn, "400 Bad Request");
+            return http_tx_pump(conn);
+        }
+        if (!conn->rx_pending)
+        {
+            return ERR_OK; // Aguarda o restante da requisicao nos proximos segmentos.
+        }
+    }
+}
+
+/*
+ * Funcao principal de callback para receber dados do servidor TCP. Os segmentos recebidos sao
+ * acumulados no contexto da conexao ate que a requisicao esteja completa (linha de requisicao,
+ * cabecalhos e corpo), so entao ela eh despachada. Em conexoes persistentes as requisicoes sao
+ * respondidas em ordem, inclusive quando varias chegam no mesmo segmento.
+ */
+static err_t tcp_server_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err)
+{
+    http_connection_t *conn = (http_connection_t *)arg;
+
+    if (!p)
+    {
+        return conn ? http_connection_close(conn) : tcp_close(tpcb);
+    }
+    if (err != ERR_OK || !conn || conn->close_after_tx)
+    {
+        tcp_recved(tpcb, p->tot_len);
+        pbuf_free(p);
+        return ERR_OK;
+    }
+
+    if (conn->mode == HTTP_MODE_EVENTS)
+    {
+        // Streams SSE sao unidirecionais: qualquer dado enviado pelo cliente eh descartado.
+        tcp_recved(tpcb, p->tot_len);
+        pbuf_free(p);
+        return ERR_OK;
+    }
+
+    conn->idle_seconds = 0;
+    tcp_setprio(tpcb, TCP_PRIO_NORMAL);
+
+    perf_span_t span = perf_span_begin();
+    uint16_t received = p->tot_len;
+    if (conn->rx_pending)
+    {
+        pbuf_cat(conn->rx_pending, p);
+    }
+    else
+    {
+        conn->rx_pending = p;
+        conn->rx_offset = 0;
+    }
+    err_t result = http_connection_process(conn);
+    perf_trace_end(&g_perf_trace, span, PERF_SPAN_TCP_RECV, received);
+    return result;
+}
+
+// Callback chamado pelo lwIP quando a conexao eh abortada; o PCB ja foi liberado.
+static void tcp_server_err(void *arg, err_t err)
+{
+    http_connection_t *conn = (http_connection_t *)arg;
+    if (conn)
+    {
+        http_connection_free(conn);
+    }
+}
+
+/*
+ * Chamado periodicamente pelo lwIP (a cada HTTP_POLL_INTERVAL). Fecha conexoes persistentes que
+ * ficaram ociosas alem de HTTP_KEEPALIVE_TIMEOUT_S e reduz a prioridade das que estao esperando,
+ * para que o lwIP possa recupera-las primeiro quando faltarem PCBs para novas conexoes.
+ */
+static err_t tcp_server_poll(void *arg, struct tcp_pcb *tpcb)
+{
+    http_connection_t *conn = (http_connection_t *)arg;
+    if (!conn)
+    {
+        return ERR_OK;
+    }
+
+    conn->idle_seconds += HTTP_POLL_INTERVAL / 2;
+    if (conn->mode == HTTP_MODE_EVENTS)
+    {
+        // Comentario periodico para que proxies e o navegador nao considerem o stream inativo.
+        if (conn->idle_seconds >= HTTP_EVENTS_PING_S && http_tcp_write(tpcb, ":\n\n", 3, 0) == ERR_OK)
+        {
+            conn->idle_seconds = 0;
+            http_tcp_output(tpcb);
+        }
+        return ERR_OK;
+    }
+    if (conn->mode == HTTP_MODE_WEBSOCKET)
+    {
+        ws_flush_queue(conn);
+        return ERR_OK;
+    }
+    if (http_tx_busy(conn))
+    {
+        // Retoma uma resposta que parou por falta de memoria no lwIP (tcp_write retornou ERR_MEM).
+        err_t result = http_tx_pump(conn);
+        return result == ERR_OK && !conn->close_after_tx ? http_connection_process(conn) : result;
+    }
+    if (conn->idle_seconds >= HTTP_KEEPALIVE_TIMEOUT_S)
+    {
+        return http_connection_close(conn);
+    }
+    if (conn->length == 0)
+    {
+        tcp_setprio(tpcb, TCP_PRIO_MIN);
+    }
+    return ERR_OK;
+}
+
+/*
+ * Chamado quando o cliente confirma dados enviados. Continua a resposta em andamento e, ao termina-la,
+ * atende as requisicoes que aguardavam no buffer; em streams, reenvia o evento de navegacao pendente e
+ * esvazia a fila de amostras do WebSocket.
+ */
+static err_t tcp_server_sent(void *arg, struct tcp_pcb *tpcb, u16_t len)
+{
+    http_connection_t *conn = (http_connection_t *)arg;
+    if (!conn)
+    {
+        return ERR_OK;
+    }
+    conn->idle_seconds = 0;
+    if (conn->mode == HTTP_MODE_REQUEST)
+    {
+        conn->tx_unacked = len < conn->tx_unacked ? conn->tx_unacked - len : 0;
+        err_t result = http_tx_pump(conn);
+        return result == ERR_OK && !conn->close_after_tx ? http_connection_process(conn) : result;
+    }
+    if (conn->mode == HTTP_MODE_WEBSOCKET)
+    {
+        ws_flush_queue(conn);
+    }
+    if (conn->pending_navigate)
+    {
+        char json_payload[128];
+        snprintf(json_payload, sizeof(json_payload), "{\"goto\":\"%s\"}", conn->pending_navigate);
+        if (sse_send(conn, "navigate", json_payload))
+        {
+            conn->pending_navigate = NULL;
+        }
+    }
+    return ERR_OK;
+}
+
+// Callback chamado quando uma nova conexao TCP eh aceita.
+static err_t tcp_server_accept(void *arg, struct tcp_pcb *newpcb, err_t err)
+{
+    if (err != ERR_OK || !newpcb)
+    {
+        return ERR_VAL;
+    }
+
+    http_connection_t *conn = http_connection_alloc(newpcb);
+    if (!conn && http_connection_reclaim_idle())
+    {
+        conn = http_connection_alloc(newpcb);
+    }
+    if (!conn)
+    {
+        tcp_abort(newpcb); // Pool cheio: recusa a conexao.
+        return ERR_ABRT;
+    }
+
+    tcp_arg(newpcb, conn);
     tcp_recv(newpcb, tcp_server_recv);
+    tcp_err(newpcb, tcp_server_err);
+    tcp_sent(newpcb, tcp_server_sent);
+    tcp_poll(newpcb, tcp_server_poll, HTTP_POLL_INTERVAL);
     return ERR_OK;
 }
 
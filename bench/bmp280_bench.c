@@ -0,0 +1,132 @@
+// Compara as compensações do BMP280 (32 bits, 64 bits e ponto flutuante) em precisão e velocidade.
+// Primeiro confere os vetores de referência do datasheet; depois varre leituras brutas usando a
+// fórmula em double como referência e mede o tempo médio de cada caminho.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "bmp280_compensation.h"
+
+// Calibração e leituras do exemplo do datasheet (seção 3.12)
+static const struct bmp280_calib_param DATASHEET_PARAMS = {
+    .dig_t1 = 27504, .dig_t2 = 26435, .dig_t3 = -1000,
+    .dig_p1 = 36477, .dig_p2 = -10685, .dig_p3 = 3024, .dig_p4 = 2855, .dig_p5 = 140,
+    .dig_p6 = -7, .dig_p7 = 15500, .dig_p8 = -14600, .dig_p9 = 6000,
+};
+#define DATASHEET_RAW_T 519888
+#define DATASHEET_RAW_P 415148
+
+#define SWEEP_STEP 97         // Passo da varredura de leituras brutas
+#define BENCH_ITERATIONS 2000000
+
+static volatile uint32_t sink;  // impede que o compilador descarte as chamadas medidas
+
+// Valores publicados no datasheet para o exemplo acima (calculados com a fórmula em double)
+#define DATASHEET_T_FINE 128422
+#define DATASHEET_TEMPERATURE 25.08     // °C
+#define DATASHEET_PRESSURE 100653.27    // Pa
+
+// Tolerância de cada caminho em relação ao valor publicado
+#define TOLERANCE_32 4.0       // Pa; a fórmula de 32 bits arredonda etapas intermediárias
+#define TOLERANCE_64 0.5       // Pa
+#define TOLERANCE_FLOAT 0.02   // o datasheet arredonda para duas casas e não trunca t_fine
+
+static int check(const char *name, double got, double expected, double tolerance) {
+    int ok = fabs(got - expected) <= tolerance;
+    printf("  %-16s %12.2f (esperado %.2f +- %.2f) %s\n", name, got, expected, tolerance, ok ? "ok" : "FALHOU");
+    return ok;
+}
+
+static int check_datasheet(void) {
+    bmp280_reading_t r32, r64;
+    double t, p;
+    int ok = 1;
+
+    bmp280_compensate(DATASHEET_RAW_T, DATASHEET_RAW_P, &DATASHEET_PARAMS, &r32);
+    bmp280_compensate_64(DATASHEET_RAW_T, DATASHEET_RAW_P, &DATASHEET_PARAMS, &r64);
+    bmp280_compensate_float(DATASHEET_RAW_T, DATASHEET_RAW_P, &DATASHEET_PARAMS, &t, &p);
+
+    printf("Vetores do datasheet:\n");
+    ok &= check("t_fine", r32.t_fine, DATASHEET_T_FINE, 0);
+    ok &= check("t_fine 64 bits", r64.t_fine, DATASHEET_T_FINE, 0);
+    ok &= check("temperatura", r32.temperature / 100.0, DATASHEET_TEMPERATURE, 0.005);
+    ok &= check("temp. double", t, DATASHEET_TEMPERATURE, TOLERANCE_FLOAT);
+    ok &= check("pressao 32 bits", r32.pressure, DATASHEET_PRESSURE, TOLERANCE_32);
+    ok &= check("pressao 64 bits", r64.pressure_q24_8 / 256.0, DATASHEET_PRESSURE, TOLERANCE_64);
+    ok &= check("pressao double", p, DATASHEET_PRESSURE, TOLERANCE_FLOAT);
+    return ok;
+}
+
+static void sweep_accuracy(void) {
+    double max32 = 0, max64 = 0, sum32 = 0, sum64 = 0;
+    long n = 0;
+
+    // Faixa útil do sensor: cerca de -40..85 °C e 300..1100 hPa
+    for (int32_t raw_t = 380000; raw_t <= 640000; raw_t += 40000 + SWEEP_STEP) {
+        for (int32_t raw_p = 150000; raw_p <= 650000; raw_p += SWEEP_STEP) {
+            bmp280_reading_t r32, r64;
+            double t, p;
+            bmp280_compensate(raw_t, raw_p, &DATASHEET_PARAMS, &r32);
+            bmp280_compensate_64(raw_t, raw_p, &DATASHEET_PARAMS, &r64);
+            bmp280_compensate_float(raw_t, raw_p, &DATASHEET_PARAMS, &t, &p);
+            if (p < 30000.0 || p > 110000.0) {
+                continue;
+            }
+            double e32 = fabs((double)r32.pressure - p);
+            double e64 = fabs(r64.pressure_q24_8 / 256.0 - p);
+            sum32 += e32;
+            sum64 += e64;
+            if (e32 > max32) max32 = e32;
+            if (e64 > max64) max64 = e64;
+            n++;
+        }
+    }
+
+    printf("\nErro da pressao em relacao ao double (%ld leituras):\n", n);
+    printf("  32 bits: medio %.3f Pa, maximo %.3f Pa\n", sum32 / n, max32);
+    printf("  64 bits: medio %.3f Pa, maximo %.3f Pa\n", sum64 / n, max64);
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void bench_speed(void) {
+    bmp280_reading_t r;
+    double t, p;
+    double start;
+
+    printf("\nTempo por leitura (%d iteracoes):\n", BENCH_ITERATIONS);
+
+    start = now_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        bmp280_compensate(DATASHEET_RAW_T + (i & 1023), DATASHEET_RAW_P + (i & 4095), &DATASHEET_PARAMS, &r);
+        sink += r.pressure;
+    }
+    printf("  32 bits: %.1f ns\n", (now_ns() - start) / BENCH_ITERATIONS);
+
+    start = now_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        bmp280_compensate_64(DATASHEET_RAW_T + (i & 1023), DATASHEET_RAW_P + (i & 4095), &DATASHEET_PARAMS, &r);
+        sink += r.pressure_q24_8;
+    }
+    printf("  64 bits: %.1f ns\n", (now_ns() - start) / BENCH_ITERATIONS);
+
+    start = now_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        bmp280_compensate_float(DATASHEET_RAW_T + (i & 1023), DATASHEET_RAW_P + (i & 4095), &DATASHEET_PARAMS, &t, &p);
+        sink += (uint32_t)p;
+    }
+    printf("  double:  %.1f ns\n", (now_ns() - start) / BENCH_ITERATIONS);
+}
+
+int main(void) {
+    int ok = check_datasheet();
+    sweep_accuracy();
+    bench_speed();
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
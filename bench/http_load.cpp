@@ -0,0 +1,1028 @@
+// Gerador de carga HTTP para o servidor do build de host (host/). Cada cliente simulado é um painel aberto
+// no navegador e repete a mistura de requisições da interface: /estado a cada 2 s, /navigate a cada 1,2 s,
+// carregamentos de página ocasionais (a página, os arquivos de /assets ainda fora do cache, /getconfig e
+// /history) e POST /config. Tudo roda em uma thread com epoll; a agenda de cada cliente sai de uma semente
+// fixa, então duas execuções do mesmo cenário geram a mesma sequência de requisições.
+//
+// A latência é contada a partir do instante em que a requisição deveria ter saído, e não de quando saiu de
+// fato: se o servidor atrasa, as requisições que ficaram na fila também pagam o atraso. Medir do envio
+// esconderia justamente as piores latências ("omissão coordenada").
+//
+// Uso: http_load [opções] cenario.scn [chave=valor ...]
+//   --host ENDEREÇO   servidor (padrão: 127.0.0.1)
+//   --port PORTA      porta (padrão: 8080)
+//   --stats ARQUIVO   contadores do servidor (ESTACAO_HOST_STATS), para medir o esgotamento dos pools
+//   --server-pid PID  mede o tempo de CPU gasto pelo servidor durante a medição
+//   --json ARQUIVO    acrescenta o resultado ao arquivo, um objeto JSON por linha (sem ele, vai para stdout)
+// As chaves do cenário estão em Scenario; as passadas na linha de comando têm precedência sobre o arquivo.
+// Sai com 1 se algum limite do cenário (max_*) for ultrapassado e com 2 em erro de uso.
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Scenario {
+    std::string name;
+    int clients = 4;
+    int connections = 2;        // Conexões simultâneas por cliente (um navegador abre até 6 por servidor)
+    double duration_s = 30;     // Duração da medição
+    double warmup_s = 3;        // Aquecimento antes da medição, fora das estatísticas
+    double ramp_s = 2;          // Os clientes entram espalhados nesse intervalo
+    double estado_ms = 2000;    // Período de GET /estado (0 desliga)
+    double navigate_ms = 1200;  // Período de GET /navigate (0 desliga)
+    double page_ms = 60000;     // Intervalo médio entre carregamentos de página (0 desliga)
+    double config_ms = 0;       // Intervalo médio entre POST /config (0 desliga)
+    bool keepalive = true;      // false: "Connection: close" em todas as requisições
+    double timeout_ms = 5000;   // Sem resposta nesse tempo, a requisição conta como erro
+    int history_limit = 120;    // 'limit' do /history pedido pelas páginas de gráfico
+    unsigned long seed = 1;
+    std::vector<std::string> assets;  // Caminhos de /assets (o nome tem o hash do conteúdo; ver web/)
+
+    // Limites para a execução passar (negativo: sem limite)
+    double max_p99_ms = -1;
+    long max_errors = -1;
+    long max_pool_exhausted = -1;
+};
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int port = 8080;
+    std::string stats_path;
+    long server_pid = 0;
+    std::string json_path;
+};
+
+enum Route { ROUTE_ESTADO, ROUTE_NAVIGATE, ROUTE_PAGE, ROUTE_ASSET, ROUTE_GETCONFIG, ROUTE_HISTORY, ROUTE_CONFIG,
+             ROUTE_COUNT };
+const char *const ROUTE_NAMES[ROUTE_COUNT] = {"estado", "navigate", "page", "asset", "getconfig", "history",
+                                              "config_post"};
+
+// Páginas de G_PAGES no firmware
+const char *const PAGES[] = {"/", "/config", "/temperatura", "/umidade", "/pressao", "/altitude"};
+const int PAGE_COUNT = sizeof(PAGES) / sizeof(PAGES[0]);
+
+// Tipos de erro, na ordem em que aparecem no resultado
+enum Failure { FAIL_CONNECT, FAIL_REFUSED, FAIL_RESET, FAIL_TIMEOUT, FAIL_HTTP, FAIL_PARSE, FAIL_COUNT };
+const char *const FAILURE_NAMES[FAIL_COUNT] = {"connect", "refused", "reset", "timeout", "http", "parse"};
+
+uint64_t now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+struct Request {
+    Route route;
+    std::string method;
+    std::string path;
+    std::string body;
+    uint64_t scheduled_us;  // Quando deveria ter saído; base da latência
+    bool retried = false;
+};
+
+struct Client;
+
+struct Connection {
+    Client *client;
+    int fd = -1;
+    bool connecting = false;
+    bool busy = false;      // Há uma requisição em andamento
+    bool got_bytes = false; // Já chegou algum byte da resposta atual
+    int served = 0;         // Respostas completas nesta conexão
+    Request request;
+    std::string out;
+    size_t out_sent = 0;
+    std::string in;
+    uint64_t last_progress_us = 0;
+};
+
+struct Client {
+    int id;
+    std::mt19937_64 rng;
+    uint64_t next_estado_us = 0;
+    uint64_t next_navigate_us = 0;
+    uint64_t next_page_us = 0;
+    uint64_t next_config_us = 0;
+    std::deque<Request> queue;
+    std::vector<std::unique_ptr<Connection>> connections;
+    std::map<std::string, std::string> etags;  // ETag de cada página, para o If-None-Match
+    bool assets_cached = false;                // Os assets são imutáveis: baixados uma vez por cliente
+};
+
+struct RouteStats {
+    std::vector<uint32_t> latency_us;
+    long ok = 0;
+    long not_modified = 0;
+    long errors = 0;
+};
+
+struct Response {
+    int status = 0;
+    size_t length = 0;  // Bytes consumidos de 'in' (cabeçalho e corpo)
+    bool close = false;
+    std::string etag;
+};
+
+enum ParseResult { PARSE_INCOMPLETE, PARSE_DONE, PARSE_ERROR };
+
+std::string lower(std::string text) {
+    for (char &c : text) {
+        c = (char)tolower((unsigned char)c);
+    }
+    return text;
+}
+
+std::string trim(const std::string &text) {
+    size_t start = text.find_first_not_of(" \t\r\n");
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return start == std::string::npos ? std::string() : text.substr(start, end - start + 1);
+}
+
+// Lê uma resposta HTTP/1.1 do início de 'in': corpo por Content-Length, chunked ou até o fim da conexão.
+ParseResult parse_response(const std::string &in, bool eof, Response &out) {
+    size_t header_end = in.find("\r\n\r\n");
+    if (header_end == std::string::npos) {
+        return eof ? PARSE_ERROR : PARSE_INCOMPLETE;
+    }
+    if (in.compare(0, 5, "HTTP/") != 0) {
+        return PARSE_ERROR;
+    }
+    size_t space = in.find(' ');
+    if (space == std::string::npos || space > header_end) {
+        return PARSE_ERROR;
+    }
+    out = Response();
+    out.status = atoi(in.c_str() + space + 1);
+    if (out.status < 100 || out.status > 599) {
+        return PARSE_ERROR;
+    }
+
+    long content_length = -1;
+    bool chunked = false;
+    size_t line = in.find("\r\n") + 2;
+    while (line < header_end) {
+        size_t line_end = in.find("\r\n", line);
+        size_t colon = in.find(':', line);
+        if (colon != std::string::npos && colon < line_end) {
+            std::string key = lower(in.substr(line, colon - line));
+            std::string value = trim(in.substr(colon + 1, line_end - colon - 1));
+            if (key == "content-length") {
+                content_length = atol(value.c_str());
+            } else if (key == "transfer-encoding") {
+                chunked = lower(value).find("chunked") != std::string::npos;
+            } else if (key == "connection") {
+                out.close = lower(value) == "close";
+            } else if (key == "etag") {
+                out.etag = value;
+            }
+        }
+        line = line_end + 2;
+    }
+
+    size_t body = header_end + 4;
+    if (out.status / 100 == 1 || out.status == 204 || out.status == 304) {
+        out.length = body;
+    } else if (chunked) {
+        size_t pos = body;
+        while (true) {
+            size_t size_end = in.find("\r\n", pos);
+            if (size_end == std::string::npos) {
+                return eof ? PARSE_ERROR : PARSE_INCOMPLETE;
+            }
+            char *end;
+            unsigned long size = strtoul(in.c_str() + pos, &end, 16);
+            if (end == in.c_str() + pos) {
+                return PARSE_ERROR;
+            }
+            pos = size_end + 2 + size;
+            if (in.size() < pos + 2) {
+                return eof ? PARSE_ERROR : PARSE_INCOMPLETE;
+            }
+            if (in.compare(pos, 2, "\r\n") != 0) {
+                return PARSE_ERROR;
+            }
+            pos += 2;
+            if (size == 0) {
+                break;
+            }
+        }
+        out.length = pos;
+    } else if (content_length >= 0) {
+        if (in.size() < body + (size_t)content_length) {
+            return eof ? PARSE_ERROR : PARSE_INCOMPLETE;
+        }
+        out.length = body + (size_t)content_length;
+    } else {
+        if (!eof) {
+            return PARSE_INCOMPLETE;
+        }
+        out.length = in.size();
+        out.close = true;
+    }
+    return PARSE_DONE;
+}
+
+std::map<std::string, long> read_server_stats(const std::string &path) {
+    std::map<std::string, long> stats;
+    std::ifstream file(path);
+    std::string key;
+    long value;
+    while (file >> key >> value) {
+        stats[key] = value;
+    }
+    return stats;
+}
+
+// Tempo de CPU (usuário + sistema) do processo, em segundos
+double process_cpu_s(long pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%ld/stat", pid);
+    std::ifstream file(path);
+    std::string line;
+    if (!std::getline(file, line)) {
+        return -1;
+    }
+    // Os campos contam a partir do estado, logo depois do nome entre parênteses
+    size_t paren = line.rfind(')');
+    if (paren == std::string::npos) {
+        return -1;
+    }
+    std::vector<std::string> fields;
+    size_t pos = paren + 2;
+    while (pos < line.size()) {
+        size_t space = line.find(' ', pos);
+        if (space == std::string::npos) {
+            space = line.size();
+        }
+        fields.push_back(line.substr(pos, space - pos));
+        pos = space + 1;
+    }
+    if (fields.size() < 13) {
+        return -1;
+    }
+    double ticks = atof(fields[11].c_str()) + atof(fields[12].c_str());  // utime, stime
+    return ticks / (double)sysconf(_SC_CLK_TCK);
+}
+
+double percentile_ms(const std::vector<uint32_t> &sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = (size_t)std::ceil(p * (double)sorted.size());
+    index = index == 0 ? 0 : index - 1;
+    return sorted[std::min(index, sorted.size() - 1)] / 1000.0;
+}
+
+class LoadRun {
+  public:
+    LoadRun(const Scenario &scenario, const Options &options) : scenario_(scenario), options_(options) {}
+
+    int run();
+
+  private:
+    void start_clients(uint64_t start_us);
+    uint64_t interval_us(Client &client, double mean_ms);
+    void schedule(Client &client, uint64_t now);
+    void enqueue(Client &client, Route route, const std::string &method, const std::string &path,
+                 const std::string &body, uint64_t scheduled_us);
+    void enqueue_page_load(Client &client, uint64_t now);
+    void dispatch(Client &client, uint64_t now);
+    bool open_connection(Connection &conn, uint64_t now);
+    void send_request(Connection &conn, uint64_t now);
+    void flush_output(Connection &conn);
+    void handle_event(Connection &conn, uint32_t events, uint64_t now);
+    void handle_input(Connection &conn, bool eof, uint64_t now);
+    void complete(Connection &conn, const Response &response, uint64_t now);
+    void fail(Connection &conn, Failure failure, uint64_t now);
+    void close_connection(Connection &conn);
+    void check_timeouts(uint64_t now);
+    bool measured(const Request &request) const { return request.scheduled_us >= measure_start_us_; }
+    int report();
+
+    const Scenario &scenario_;
+    const Options &options_;
+    struct sockaddr_in address_ = {};
+    int epoll_fd_ = -1;
+    std::vector<std::unique_ptr<Client>> clients_;
+    uint64_t measure_start_us_ = 0;
+    uint64_t measure_end_us_ = 0;
+
+    RouteStats routes_[ROUTE_COUNT];
+    long failures_[FAIL_COUNT] = {};
+    std::map<int, long> statuses_;
+    long retries_ = 0;
+    long connections_opened_ = 0;
+    unsigned long long bytes_in_ = 0;
+    std::map<std::string, long> server_before_;
+    std::map<std::string, long> server_after_;
+    double cpu_before_s_ = -1;
+    double cpu_after_s_ = -1;
+};
+
+void LoadRun::start_clients(uint64_t start_us) {
+    for (int i = 0; i < scenario_.clients; i++) {
+        auto client = std::make_unique<Client>();
+        client->id = i;
+        client->rng.seed(scenario_.seed * 1000003u + (unsigned long)i);
+        for (int c = 0; c < scenario_.connections; c++) {
+            auto conn = std::make_unique<Connection>();
+            conn->client = client.get();
+            client->connections.push_back(std::move(conn));
+        }
+
+        // Cada cliente abre o painel em um instante da rampa e, a partir daí, os timers da página correm
+        uint64_t opened = start_us + (uint64_t)(scenario_.ramp_s * 1e6 * i / std::max(scenario_.clients, 1));
+        client->next_page_us = opened;
+        client->next_estado_us = opened + (uint64_t)(scenario_.estado_ms * 1000);
+        client->next_navigate_us = opened + (uint64_t)(scenario_.navigate_ms * 1000);
+        client->next_config_us = opened + interval_us(*client, scenario_.config_ms);
+        clients_.push_back(std::move(client));
+    }
+}
+
+// Intervalo exponencial com a média dada: eventos sem período fixo, como um usuário trocando de página
+uint64_t LoadRun::interval_us(Client &client, double mean_ms) {
+    if (mean_ms <= 0) {
+        return UINT64_MAX / 2;
+    }
+    std::exponential_distribution<double> distribution(1.0 / (mean_ms * 1000));
+    return (uint64_t)distribution(client.rng) + 1;
+}
+
+void LoadRun::enqueue(Client &client, Route route, const std::string &method, const std::string &path,
+                      const std::string &body, uint64_t scheduled_us) {
+    Request request;
+    request.route = route;
+    request.method = method;
+    request.path = path;
+    request.body = body;
+    request.scheduled_us = scheduled_us;
+    client.queue.push_back(request);
+}
+
+// Só a página; o que ela carrega em seguida é pedido quando a resposta chega (ver complete)
+void LoadRun::enqueue_page_load(Client &client, uint64_t now) {
+    std::uniform_int_distribution<int> page(0, PAGE_COUNT - 1);
+    enqueue(client, ROUTE_PAGE, "GET", PAGES[page(client.rng)], "", now);
+}
+
+void LoadRun::schedule(Client &client, uint64_t now) {
+    // Os timers são como setInterval: o atraso de uma requisição não desloca as seguintes
+    while (scenario_.estado_ms > 0 && client.next_estado_us <= now) {
+        enqueue(client, ROUTE_ESTADO, "GET", "/estado", "", client.next_estado_us);
+        client.next_estado_us += (uint64_t)(scenario_.estado_ms * 1000);
+    }
+    while (scenario_.navigate_ms > 0 && client.next_navigate_us <= now) {
+        enqueue(client, ROUTE_NAVIGATE, "GET", "/navigate", "", client.next_navigate_us);
+        client.next_navigate_us += (uint64_t)(scenario_.navigate_ms * 1000);
+    }
+    // O primeiro carregamento é a abertura do painel; os seguintes, só se page_ms > 0
+    while (client.next_page_us <= now) {
+        enqueue_page_load(client, client.next_page_us);
+        client.next_page_us += interval_us(client, scenario_.page_ms);
+    }
+    while (client.next_config_us <= now) {
+        // O formulário de web/config.html, com valores que variam para não cair no caso "nada mudou"
+        char body[256];
+        std::uniform_int_distribution<int> offset(-20, 20);
+        snprintf(body, sizeof(body),
+                 "temp_offset=%.1f&temp_min=10&temp_max=35&umid_offset=0&umid_min=30&umid_max=80&"
+                 "press_offset=0&press_min=900&press_max=1100&alt_offset=0&alt_min=0&alt_max=2000",
+                 offset(client.rng) / 10.0);
+        enqueue(client, ROUTE_CONFIG, "POST", "/config", body, client.next_config_us);
+        client.next_config_us += interval_us(client, scenario_.config_ms);
+    }
+}
+
+void LoadRun::dispatch(Client &client, uint64_t now) {
+    for (auto &slot : client.connections) {
+        if (client.queue.empty()) {
+            return;
+        }
+        Connection &conn = *slot;
+        if (conn.busy || conn.connecting) {
+            continue;
+        }
+        conn.request = client.queue.front();
+        client.queue.pop_front();
+        conn.busy = true;
+        if (conn.fd < 0) {
+            if (!open_connection(conn, now)) {
+                fail(conn, FAIL_CONNECT, now);
+            }
+            continue;
+        }
+        send_request(conn, now);
+    }
+}
+
+bool LoadRun::open_connection(Connection &conn, uint64_t now) {
+    conn.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (conn.fd < 0) {
+        return false;
+    }
+    int one = 1;
+    setsockopt(conn.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    conn.served = 0;
+    conn.in.clear();
+    conn.last_progress_us = now;
+    if (measured(conn.request)) {
+        connections_opened_++;
+    }
+
+    int result = connect(conn.fd, (struct sockaddr *)&address_, sizeof(address_));
+    if (result < 0 && errno != EINPROGRESS) {
+        close(conn.fd);
+        conn.fd = -1;
+        return false;
+    }
+    conn.connecting = result < 0;
+    struct epoll_event event = {};
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP;
+    event.data.ptr = &conn;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, conn.fd, &event);
+    if (!conn.connecting) {
+        send_request(conn, now);
+    }
+    return true;
+}
+
+void LoadRun::send_request(Connection &conn, uint64_t now) {
+    const Request &request = conn.request;
+    std::string &out = conn.out;
+    out = request.method + " " + request.path + " HTTP/1.1\r\nHost: " + options_.host + "\r\n";
+    out += "Accept-Encoding: gzip, deflate\r\n";
+    if (request.route == ROUTE_PAGE) {
+        auto etag = conn.client->etags.find(request.path);
+        if (etag != conn.client->etags.end()) {
+            out += "If-None-Match: " + etag->second + "\r\n";
+        }
+    }
+    if (!scenario_.keepalive) {
+        out += "Connection: close\r\n";
+    }
+    if (request.method == "POST") {
+        out += "Content-Type: application/x-www-form-urlencoded\r\n";
+        out += "Content-Length: " + std::to_string(request.body.size()) + "\r\n";
+    }
+    out += "\r\n" + request.body;
+    conn.out_sent = 0;
+    conn.got_bytes = false;
+    conn.last_progress_us = now;
+    flush_output(conn);
+}
+
+void LoadRun::flush_output(Connection &conn) {
+    while (conn.out_sent < conn.out.size()) {
+        ssize_t n = send(conn.fd, conn.out.data() + conn.out_sent, conn.out.size() - conn.out_sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            break;
+        }
+        conn.out_sent += (size_t)n;
+    }
+    // EPOLLOUT só enquanto houver o que enviar
+    struct epoll_event event = {};
+    event.events = EPOLLIN | EPOLLRDHUP | (conn.out_sent < conn.out.size() ? (uint32_t)EPOLLOUT : 0u);
+    event.data.ptr = &conn;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, conn.fd, &event);
+}
+
+void LoadRun::handle_event(Connection &conn, uint32_t events, uint64_t now) {
+    if (conn.fd < 0) {
+        return;
+    }
+    if (conn.connecting) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        getsockopt(conn.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+        if (error != 0) {
+            fail(conn, FAIL_CONNECT, now);
+            return;
+        }
+        if (!(events & (EPOLLOUT | EPOLLIN))) {
+            return;
+        }
+        conn.connecting = false;
+        send_request(conn, now);
+    } else if (events & EPOLLOUT) {
+        flush_output(conn);
+    }
+
+    bool eof = false;
+    char buffer[16384];
+    while (true) {
+        ssize_t n = recv(conn.fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            conn.in.append(buffer, (size_t)n);
+            if (conn.busy && measured(conn.request)) {
+                bytes_in_ += (unsigned long long)n;
+            }
+            continue;
+        }
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            eof = true;
+        }
+        break;
+    }
+    handle_input(conn, eof, now);
+}
+
+void LoadRun::handle_input(Connection &conn, bool eof, uint64_t now) {
+    if (!conn.in.empty()) {
+        conn.got_bytes = true;
+        conn.last_progress_us = now;
+    }
+    while (conn.busy && !conn.in.empty()) {
+        Response response;
+        ParseResult result = parse_response(conn.in, eof, response);
+        if (result == PARSE_INCOMPLETE) {
+            return;
+        }
+        if (result == PARSE_ERROR) {
+            fail(conn, FAIL_PARSE, now);
+            return;
+        }
+        conn.in.erase(0, response.length);
+        complete(conn, response, now);
+        if (conn.fd < 0) {
+            return;
+        }
+    }
+    if (!eof) {
+        return;
+    }
+    if (!conn.busy) {
+        close_connection(conn);  // O servidor fechou uma conexão ociosa
+        return;
+    }
+
+    // Conexão fechada antes da resposta. Numa conexão reaproveitada, o servidor pode tê-la fechado por
+    // ociosidade no mesmo instante em que a requisição saiu; o navegador repete a requisição em uma
+    // conexão nova, e aqui também. Numa conexão nova, é recusa: sem PCB ou sem contexto livre no servidor.
+    if (!conn.got_bytes && conn.served > 0 && !conn.request.retried) {
+        Request request = conn.request;
+        request.retried = true;
+        if (measured(request)) {
+            retries_++;
+        }
+        conn.busy = false;
+        close_connection(conn);
+        conn.client->queue.push_front(request);
+        return;
+    }
+    fail(conn, conn.got_bytes ? FAIL_RESET : FAIL_REFUSED, now);
+}
+
+void LoadRun::complete(Connection &conn, const Response &response, uint64_t now) {
+    Request request = conn.request;
+    Client &client = *conn.client;
+    conn.busy = false;
+    conn.served++;
+
+    if (measured(request)) {
+        RouteStats &stats = routes_[request.route];
+        statuses_[response.status]++;
+        if (response.status >= 400) {
+            stats.errors++;
+            failures_[FAIL_HTTP]++;
+        } else {
+            stats.latency_us.push_back((uint32_t)std::min<uint64_t>(now - request.scheduled_us, UINT32_MAX));
+            if (response.status == 304) {
+                stats.not_modified++;
+            } else {
+                stats.ok++;
+            }
+        }
+    }
+
+    if (response.close || !scenario_.keepalive) {
+        close_connection(conn);
+    }
+
+    // O que a página busca depois de carregada
+    if (request.route == ROUTE_PAGE && response.status < 400) {
+        if (!response.etag.empty()) {
+            client.etags[request.path] = response.etag;
+        }
+        if (!client.assets_cached) {
+            client.assets_cached = true;
+            for (const std::string &asset : scenario_.assets) {
+                enqueue(client, ROUTE_ASSET, "GET", asset, "", now);
+            }
+        }
+        if (request.path == "/") {
+            enqueue(client, ROUTE_ESTADO, "GET", "/estado", "", now);
+        } else {
+            enqueue(client, ROUTE_GETCONFIG, "GET", "/getconfig", "", now);
+            if (request.path != "/config") {
+                enqueue(client, ROUTE_HISTORY, "GET", "/history?limit=" + std::to_string(scenario_.history_limit),
+                        "", now);
+            }
+        }
+    }
+}
+
+void LoadRun::fail(Connection &conn, Failure failure, uint64_t now) {
+    (void)now;
+    if (conn.busy && measured(conn.request)) {
+        routes_[conn.request.route].errors++;
+        failures_[failure]++;
+    }
+    conn.busy = false;
+    close_connection(conn);
+}
+
+void LoadRun::close_connection(Connection &conn) {
+    if (conn.fd >= 0) {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn.fd, nullptr);
+        close(conn.fd);
+    }
+    conn.fd = -1;
+    conn.connecting = false;
+    conn.in.clear();
+    conn.out.clear();
+}
+
+void LoadRun::check_timeouts(uint64_t now) {
+    uint64_t timeout = (uint64_t)(scenario_.timeout_ms * 1000);
+    for (auto &client : clients_) {
+        for (auto &conn : client->connections) {
+            if (conn->busy && now - conn->last_progress_us > timeout) {
+                fail(*conn, FAIL_TIMEOUT, now);
+            }
+        }
+    }
+}
+
+int LoadRun::run() {
+    address_.sin_family = AF_INET;
+    address_.sin_port = htons((uint16_t)options_.port);
+    if (inet_pton(AF_INET, options_.host.c_str(), &address_.sin_addr) != 1) {
+        fprintf(stderr, "endereco invalido: %s\n", options_.host.c_str());
+        return 2;
+    }
+    epoll_fd_ = epoll_create1(0);
+
+    uint64_t start = now_us();
+    measure_start_us_ = start + (uint64_t)(scenario_.warmup_s * 1e6);
+    measure_end_us_ = measure_start_us_ + (uint64_t)(scenario_.duration_s * 1e6);
+    start_clients(start);
+    bool measuring = false;
+
+    std::vector<struct epoll_event> events(256);
+    while (true) {
+        uint64_t now = now_us();
+        if (!measuring && now >= measure_start_us_) {
+            measuring = true;
+            if (!options_.stats_path.empty()) {
+                server_before_ = read_server_stats(options_.stats_path);
+            }
+            if (options_.server_pid > 0) {
+                cpu_before_s_ = process_cpu_s(options_.server_pid);
+            }
+        }
+        if (now >= measure_end_us_) {
+            break;  // O que ainda estiver em andamento fica de fora
+        }
+
+        uint64_t next = measure_end_us_;
+        for (auto &client : clients_) {
+            schedule(*client, now);
+            dispatch(*client, now);
+            next = std::min({next, client->next_estado_us, client->next_navigate_us, client->next_page_us,
+                             client->next_config_us});
+        }
+        check_timeouts(now);
+
+        int wait_ms = next > now ? (int)std::min<uint64_t>((next - now + 999) / 1000, 10) : 0;
+        int count = epoll_wait(epoll_fd_, events.data(), (int)events.size(), wait_ms);
+        now = now_us();
+        for (int i = 0; i < count; i++) {
+            handle_event(*static_cast<Connection *>(events[i].data.ptr), events[i].events, now);
+        }
+    }
+
+    if (!options_.stats_path.empty()) {
+        server_after_ = read_server_stats(options_.stats_path);
+    }
+    if (options_.server_pid > 0) {
+        cpu_after_s_ = process_cpu_s(options_.server_pid);
+    }
+    for (auto &client : clients_) {
+        for (auto &conn : client->connections) {
+            close_connection(*conn);
+        }
+    }
+    close(epoll_fd_);
+    return report();
+}
+
+// Escreve '"nome":{"p50":...}' com a distribuição das latências (que é ordenada aqui)
+void json_latency(std::string &json, std::vector<uint32_t> &latency) {
+    std::sort(latency.begin(), latency.end());
+    double sum = 0;
+    for (uint32_t value : latency) {
+        sum += value;
+    }
+    char text[192];
+    snprintf(text, sizeof(text), "\"latency_ms\":{\"p50\":%.3f,\"p99\":%.3f,\"p999\":%.3f,\"max\":%.3f,\"mean\":%.3f}",
+             percentile_ms(latency, 0.50), percentile_ms(latency, 0.99), percentile_ms(latency, 0.999),
+             latency.empty() ? 0.0 : latency.back() / 1000.0, latency.empty() ? 0.0 : sum / latency.size() / 1000.0);
+    json += text;
+}
+
+std::string json_string(const std::string &text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out + "\"";
+}
+
+int LoadRun::report() {
+    std::vector<uint32_t> all;
+    long requests = 0;
+    long errors = 0;
+    for (int r = 0; r < ROUTE_COUNT; r++) {
+        all.insert(all.end(), routes_[r].latency_us.begin(), routes_[r].latency_us.end());
+        requests += (long)routes_[r].latency_us.size() + routes_[r].errors;
+    }
+    for (int f = 0; f < FAIL_COUNT; f++) {
+        errors += failures_[f];
+    }
+    long completed = (long)all.size();
+    double throughput = completed / scenario_.duration_s;
+
+    // Esgotamento dos pools visto pelo servidor; sem --stats, as recusas vistas pelos clientes
+    auto delta = [this](const char *key) { return server_after_[key] - server_before_[key]; };
+    bool have_server = !server_after_.empty();
+    long pool_exhausted = have_server ? delta("pcb_exhausted") + delta("accept_rejected") : failures_[FAIL_REFUSED];
+    double cpu_s = cpu_before_s_ >= 0 && cpu_after_s_ >= 0 ? cpu_after_s_ - cpu_before_s_ : -1;
+
+    char text[512];
+    std::string json = "{\"scenario\":" + json_string(scenario_.name);
+    snprintf(text, sizeof(text),
+             ",\"clients\":%d,\"connections\":%d,\"keepalive\":%s,\"duration_s\":%.1f,\"seed\":%lu,"
+             "\"requests\":%ld,\"completed\":%ld,\"throughput_rps\":%.2f,\"bytes_in\":%llu,"
+             "\"connections_opened\":%ld,\"retries\":%ld,",
+             scenario_.clients, scenario_.connections, scenario_.keepalive ? "true" : "false",
+             scenario_.duration_s, scenario_.seed, requests, completed, throughput, bytes_in_,
+             connections_opened_, retries_);
+    json += text;
+    std::vector<uint32_t> all_sorted = all;
+    json_latency(json, all_sorted);
+
+    json += ",\"errors\":{";
+    snprintf(text, sizeof(text), "\"total\":%ld", errors);
+    json += text;
+    for (int f = 0; f < FAIL_COUNT; f++) {
+        snprintf(text, sizeof(text), ",\"%s\":%ld", FAILURE_NAMES[f], failures_[f]);
+        json += text;
+    }
+    json += "},\"status\":{";
+    bool first = true;
+    for (const auto &status : statuses_) {
+        snprintf(text, sizeof(text), "%s\"%d\":%ld", first ? "" : ",", status.first, status.second);
+        json += text;
+        first = false;
+    }
+    json += "},\"routes\":{";
+    first = true;
+    for (int r = 0; r < ROUTE_COUNT; r++) {
+        RouteStats &stats = routes_[r];
+        if (stats.latency_us.empty() && stats.errors == 0) {
+            continue;
+        }
+        snprintf(text, sizeof(text), "%s\"%s\":{\"requests\":%ld,\"ok\":%ld,\"not_modified\":%ld,\"errors\":%ld,",
+                 first ? "" : ",", ROUTE_NAMES[r], (long)stats.latency_us.size() + stats.errors, stats.ok,
+                 stats.not_modified, stats.errors);
+        json += text;
+        json_latency(json, stats.latency_us);
+        json += "}";
+        first = false;
+    }
+    json += "}";
+
+    snprintf(text, sizeof(text), ",\"pool_exhausted\":%ld", pool_exhausted);
+    json += text;
+    if (have_server) {
+        snprintf(text, sizeof(text),
+                 ",\"server\":{\"accepted\":%ld,\"pcb_exhausted\":%ld,\"accept_rejected\":%ld,\"aborted\":%ld,"
+                 "\"write_mem\":%ld,\"bytes_out\":%ld,\"pcb_high_water\":%ld,\"pcb_pool\":%ld",
+                 delta("accepted"), delta("pcb_exhausted"), delta("accept_rejected"), delta("aborted"),
+                 delta("write_mem"), delta("bytes_out"), server_after_["pcb_high_water"], server_after_["pcb_pool"]);
+        json += text;
+        if (cpu_s >= 0) {
+            snprintf(text, sizeof(text), ",\"cpu_s\":%.3f,\"cpu_us_per_request\":%.1f", cpu_s,
+                     completed ? cpu_s * 1e6 / completed : 0.0);
+            json += text;
+        }
+        json += "}";
+    }
+
+    // Limites do cenário
+    std::vector<std::string> failures;
+    double p99 = percentile_ms(all_sorted, 0.99);
+    if (scenario_.max_p99_ms >= 0 && p99 > scenario_.max_p99_ms) {
+        snprintf(text, sizeof(text), "p99 %.3f ms > %.3f ms", p99, scenario_.max_p99_ms);
+        failures.push_back(text);
+    }
+    if (scenario_.max_errors >= 0 && errors > scenario_.max_errors) {
+        snprintf(text, sizeof(text), "%ld erros > %ld", errors, scenario_.max_errors);
+        failures.push_back(text);
+    }
+    if (scenario_.max_pool_exhausted >= 0 && pool_exhausted > scenario_.max_pool_exhausted) {
+        snprintf(text, sizeof(text), "%ld pools esgotados > %ld", pool_exhausted, scenario_.max_pool_exhausted);
+        failures.push_back(text);
+    }
+    if (completed == 0) {
+        failures.push_back("nenhuma resposta");
+    }
+    json += std::string(",\"pass\":") + (failures.empty() ? "true" : "false") + ",\"failures\":[";
+    for (size_t i = 0; i < failures.size(); i++) {
+        json += (i ? "," : "") + json_string(failures[i]);
+    }
+    json += "]}\n";
+
+    // Resumo legível em stderr; o JSON vai para o arquivo ou para stdout
+    fprintf(stderr, "cenario %s: %d clientes x %d conexoes, %.0f s%s\n", scenario_.name.c_str(), scenario_.clients,
+            scenario_.connections, scenario_.duration_s, scenario_.keepalive ? "" : ", sem keep-alive");
+    fprintf(stderr, "  %ld requisicoes (%.1f/s), %ld erros, %ld repetidas, %ld pools esgotados\n", requests,
+            throughput, errors, retries_, pool_exhausted);
+    fprintf(stderr, "  %-12s %7s %9s %9s %9s %9s\n", "rota", "n", "p50 ms", "p99 ms", "p999 ms", "max ms");
+    for (int r = 0; r < ROUTE_COUNT; r++) {
+        const std::vector<uint32_t> &latency = routes_[r].latency_us;
+        if (latency.empty()) {
+            continue;
+        }
+        fprintf(stderr, "  %-12s %7zu %9.2f %9.2f %9.2f %9.2f\n", ROUTE_NAMES[r], latency.size(),
+                percentile_ms(latency, 0.5), percentile_ms(latency, 0.99), percentile_ms(latency, 0.999),
+                latency.back() / 1000.0);
+    }
+    fprintf(stderr, "  %-12s %7zu %9.2f %9.2f %9.2f %9.2f\n", "total", all_sorted.size(),
+            percentile_ms(all_sorted, 0.5), p99, percentile_ms(all_sorted, 0.999),
+            all_sorted.empty() ? 0.0 : all_sorted.back() / 1000.0);
+    if (cpu_s >= 0 && completed) {
+        fprintf(stderr, "  CPU do servidor: %.3f s (%.1f us por requisicao)\n", cpu_s, cpu_s * 1e6 / completed);
+    }
+    for (const std::string &failure : failures) {
+        fprintf(stderr, "  FALHOU: %s\n", failure.c_str());
+    }
+
+    if (options_.json_path.empty()) {
+        fputs(json.c_str(), stdout);
+    } else {
+        FILE *file = fopen(options_.json_path.c_str(), "a");
+        if (!file) {
+            perror(options_.json_path.c_str());
+            return 2;
+        }
+        fputs(json.c_str(), file);
+        fclose(file);
+    }
+    return failures.empty() ? 0 : 1;
+}
+
+bool parse_bool(const std::string &value) {
+    return value == "1" || value == "true" || value == "yes" || value == "sim";
+}
+
+bool scenario_set(Scenario &scenario, const std::string &key, const std::string &value) {
+    if (key == "name") scenario.name = value;
+    else if (key == "clients") scenario.clients = atoi(value.c_str());
+    else if (key == "connections") scenario.connections = std::max(1, atoi(value.c_str()));
+    else if (key == "duration_s") scenario.duration_s = atof(value.c_str());
+    else if (key == "warmup_s") scenario.warmup_s = atof(value.c_str());
+    else if (key == "ramp_s") scenario.ramp_s = atof(value.c_str());
+    else if (key == "estado_ms") scenario.estado_ms = atof(value.c_str());
+    else if (key == "navigate_ms") scenario.navigate_ms = atof(value.c_str());
+    else if (key == "page_ms") scenario.page_ms = atof(value.c_str());
+    else if (key == "config_ms") scenario.config_ms = atof(value.c_str());
+    else if (key == "keepalive") scenario.keepalive = parse_bool(value);
+    else if (key == "timeout_ms") scenario.timeout_ms = atof(value.c_str());
+    else if (key == "history_limit") scenario.history_limit = atoi(value.c_str());
+    else if (key == "seed") scenario.seed = strtoul(value.c_str(), nullptr, 10);
+    else if (key == "max_p99_ms") scenario.max_p99_ms = atof(value.c_str());
+    else if (key == "max_errors") scenario.max_errors = atol(value.c_str());
+    else if (key == "max_pool_exhausted") scenario.max_pool_exhausted = atol(value.c_str());
+    else if (key == "assets") {
+        scenario.assets.clear();
+        size_t start = 0;
+        while (start < value.size()) {
+            size_t comma = value.find(',', start);
+            if (comma == std::string::npos) {
+                comma = value.size();
+            }
+            std::string asset = trim(value.substr(start, comma - start));
+            if (!asset.empty()) {
+                scenario.assets.push_back(asset);
+            }
+            start = comma + 1;
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Linhas "chave = valor"; '#' começa um comentário
+bool scenario_set_line(Scenario &scenario, const std::string &line, const std::string &where) {
+    std::string text = trim(line.substr(0, line.find('#')));
+    if (text.empty()) {
+        return true;
+    }
+    size_t equals = text.find('=');
+    if (equals == std::string::npos || !scenario_set(scenario, trim(text.substr(0, equals)), trim(text.substr(equals + 1)))) {
+        fprintf(stderr, "%s: linha invalida: %s\n", where.c_str(), text.c_str());
+        return false;
+    }
+    return true;
+}
+
+void usage() {
+    fprintf(stderr, "uso: http_load [--host ENDERECO] [--port PORTA] [--stats ARQUIVO] [--server-pid PID] "
+                    "[--json ARQUIVO] cenario.scn [chave=valor ...]\n");
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    Scenario scenario;
+    std::vector<std::string> overrides;
+    std::string scenario_path;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--host" && has_value) options.host = argv[++i];
+        else if (arg == "--port" && has_value) options.port = atoi(argv[++i]);
+        else if (arg == "--stats" && has_value) options.stats_path = argv[++i];
+        else if (arg == "--server-pid" && has_value) options.server_pid = atol(argv[++i]);
+        else if (arg == "--json" && has_value) options.json_path = argv[++i];
+        else if (arg.find('=') != std::string::npos) overrides.push_back(arg);
+        else if (arg[0] != '-' && scenario_path.empty()) scenario_path = arg;
+        else {
+            usage();
+            return 2;
+        }
+    }
+
+    if (!scenario_path.empty()) {
+        std::ifstream file(scenario_path);
+        if (!file) {
+            perror(scenario_path.c_str());
+            return 2;
+        }
+        // O nome padrão é o do arquivo, sem diretório e extensão
+        size_t slash = scenario_path.rfind('/');
+        scenario.name = scenario_path.substr(slash == std::string::npos ? 0 : slash + 1);
+        scenario.name = scenario.name.substr(0, scenario.name.rfind('.'));
+        std::string line;
+        while (std::getline(file, line)) {
+            if (!scenario_set_line(scenario, line, scenario_path)) {
+                return 2;
+            }
+        }
+    }
+    for (const std::string &line : overrides) {
+        if (!scenario_set_line(scenario, line, "linha de comando")) {
+            return 2;
+        }
+    }
+    if (scenario.name.empty()) {
+        scenario.name = "padrao";
+    }
+    if (scenario.clients <= 0 || scenario.duration_s <= 0) {
+        fprintf(stderr, "clients e duration_s precisam ser positivos\n");
+        return 2;
+    }
+
+    LoadRun run(scenario, options);
+    return run.run();
+}
@@ -0,0 +1,64 @@
+#!/bin/sh
+# Compila o build de host e o gerador de carga, e roda cada cenário contra um servidor recém-iniciado
+# (flash vazia, mesma semente), para que os resultados sejam comparáveis entre execuções.
+#
+# Uso: bench/run_http_load.sh [cenario.scn ...]     (padrão: bench/scenarios/*.scn)
+# Os resultados são acrescentados, um JSON por linha, a $HTTP_LOAD_OUT (padrão: bench/build/http_load.jsonl).
+# Sai com erro se algum cenário ultrapassar seus limites.
+set -eu
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+HOST_BUILD=${HOST_BUILD:-$ROOT/build-host}
+BENCH_BUILD=$ROOT/bench/build
+PORT=${HTTP_LOAD_PORT:-18080}
+OUT=${HTTP_LOAD_OUT:-$BENCH_BUILD/http_load.jsonl}
+
+cmake -S "$ROOT" -B "$HOST_BUILD" -DESTACAO_HOST_BUILD=ON -DCMAKE_BUILD_TYPE=Release >/dev/null
+cmake --build "$HOST_BUILD" >/dev/null
+cmake -S "$ROOT/bench" -B "$BENCH_BUILD" >/dev/null
+cmake --build "$BENCH_BUILD" --target http_load >/dev/null
+
+# Os nomes dos assets levam o hash do conteúdo; a lista sai do cabeçalho gerado
+ASSETS=$(grep -o '"/assets/[^"]*"' "$HOST_BUILD/host/generated/web_pages.h" | tr -d '"' | sort -u | paste -sd, -)
+
+WORK=$(mktemp -d)
+SERVER=
+cleanup() {
+    [ -n "$SERVER" ] && kill "$SERVER" 2>/dev/null
+    rm -rf "$WORK"
+}
+trap cleanup EXIT INT TERM
+
+if [ $# -eq 0 ]; then
+    set -- "$ROOT"/bench/scenarios/*.scn
+fi
+
+STATUS=0
+for SCENARIO in "$@"; do
+    rm -f "$WORK/flash" "$WORK/stats"
+    ESTACAO_HOST_PORT=$PORT ESTACAO_HOST_FLASH=$WORK/flash ESTACAO_HOST_STATS=$WORK/stats \
+        "$HOST_BUILD/host/estacao_host" >"$WORK/server.log" 2>&1 &
+    SERVER=$!
+
+    # O arquivo de contadores aparece quando o loop principal já está atendendo
+    TRIES=0
+    while [ ! -f "$WORK/stats" ]; do
+        TRIES=$((TRIES + 1))
+        if [ $TRIES -gt 100 ] || ! kill -0 "$SERVER" 2>/dev/null; then
+            echo "servidor nao iniciou:" >&2
+            cat "$WORK/server.log" >&2
+            exit 2
+        fi
+        sleep 0.1
+    done
+
+    "$BENCH_BUILD/http_load" --port "$PORT" --stats "$WORK/stats" --server-pid "$SERVER" --json "$OUT" \
+        "$SCENARIO" "assets=$ASSETS" || STATUS=1
+
+    kill "$SERVER"
+    wait "$SERVER" 2>/dev/null || true
+    SERVER=
+done
+
+echo "resultados em $OUT" >&2
+exit $STATUS
@@ -0,0 +1,64 @@
+// Flash simulada. Se ESTACAO_HOST_FLASH indicar um arquivo, o conteúdo é carregado dele no início e
+// salvo nele a cada gravação, para que a configuração e o arquivo de medições sobrevivam entre
+// execuções, como na placa.
+
+#include <stdlib.h>
+#include <string.h>
+#include "hardware/flash.h"
+#include "pico/flash.h"
+
+uint8_t host_flash[PICO_FLASH_SIZE_BYTES];
+
+static const char *flash_path(void) {
+    return getenv("ESTACAO_HOST_FLASH");
+}
+
+__attribute__((constructor)) static void flash_load(void) {
+    memset(host_flash, 0xFF, sizeof(host_flash));
+    const char *path = flash_path();
+    FILE *file = path ? fopen(path, "rb") : NULL;
+    if (file) {
+        size_t loaded = fread(host_flash, 1, sizeof(host_flash), file);
+        (void)loaded;
+        fclose(file);
+    }
+}
+
+static void flash_save(void) {
+    const char *path = flash_path();
+    FILE *file = path ? fopen(path, "wb") : NULL;
+    if (file) {
+        fwrite(host_flash, 1, sizeof(host_flash), file);
+        fclose(file);
+    }
+}
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+    if (flash_offs % FLASH_SECTOR_SIZE || count % FLASH_SECTOR_SIZE || flash_offs + count > sizeof(host_flash)) {
+        fprintf(stderr, "flash_range_erase: faixa invalida (0x%x, %zu)\n", (unsigned)flash_offs, count);
+        abort();
+    }
+    memset(host_flash + flash_offs, 0xFF, count);
+    flash_save();
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count) {
+    if (flash_offs % FLASH_PAGE_SIZE || count % FLASH_PAGE_SIZE || flash_offs + count > sizeof(host_flash)) {
+        fprintf(stderr, "flash_range_program: faixa invalida (0x%x, %zu)\n", (unsigned)flash_offs, count);
+        abort();
+    }
+    for (size_t i = 0; i < count; i++) {
+        host_flash[flash_offs + i] &= data[i];
+    }
+    flash_save();
+}
+
+int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms) {
+    (void)enter_exit_timeout_ms;
+    func(param);
+    return PICO_OK;
+}
+
+bool flash_safe_execute_core_init(void) {
+    return true;
+}
@@ -0,0 +1,163 @@
+// Tempo, SysTick, GPIO, PIO e núcleo 1 para a compilação no computador. GPIO e PIO não têm efeito (os botões
+// ficam sempre soltos); o núcleo 1 é uma thread.
+
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/pio.h"
+#include "hardware/structs/systick.h"
+
+struct pio_hw {
+    int unused;
+};
+static struct pio_hw pio0_hw;
+pio_hw_t *const host_pio0 = &pio0_hw;
+
+void stdio_init_all(void) {
+    setvbuf(stdout, NULL, _IOLBF, 0);
+}
+
+// Lê um byte da entrada padrão, como o stdio USB do Pico; no fim da entrada, nunca há dados
+int getchar_timeout_us(uint32_t timeout_us) {
+    struct pollfd fd = {.fd = STDIN_FILENO, .events = POLLIN};
+    unsigned char c;
+    if (poll(&fd, 1, (int)(timeout_us / 1000)) == 1 && (fd.revents & POLLIN) && read(STDIN_FILENO, &c, 1) == 1) {
+        return c;
+    }
+    return PICO_ERROR_TIMEOUT;
+}
+
+uint64_t time_us_64(void) {
+    static uint64_t start_us;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t now_us = (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+    if (start_us == 0) {
+        start_us = now_us - 1;  // como no Pico, o tempo começa perto de zero
+    }
+    return now_us - start_us;
+}
+
+uint32_t time_us_32(void) {
+    return (uint32_t)time_us_64();
+}
+
+absolute_time_t get_absolute_time(void) {
+    return time_us_64();
+}
+
+uint32_t to_ms_since_boot(absolute_time_t t) {
+    return (uint32_t)(t / 1000u);
+}
+
+uint64_t to_us_since_boot(absolute_time_t t) {
+    return t;
+}
+
+absolute_time_t delayed_by_ms(absolute_time_t t, uint32_t ms) {
+    return t + (uint64_t)ms * 1000u;
+}
+
+void sleep_us(uint64_t us) {
+    struct timespec ts = {.tv_sec = (time_t)(us / 1000000u), .tv_nsec = (long)(us % 1000000u) * 1000};
+    while (nanosleep(&ts, &ts) != 0) {
+    }
+}
+
+void sleep_ms(uint32_t ms) {
+    sleep_us((uint64_t)ms * 1000u);
+}
+
+void sleep_until(absolute_time_t t) {
+    uint64_t now = time_us_64();
+    if (t > now) {
+        sleep_us(t - now);
+    }
+}
+
+void tight_loop_contents(void) {
+}
+
+void gpio_init(uint gpio) {
+    (void)gpio;
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+    (void)gpio;
+    (void)out;
+}
+
+void gpio_put(uint gpio, bool value) {
+    (void)gpio;
+    (void)value;
+}
+
+bool gpio_get(uint gpio) {
+    (void)gpio;
+    return true;  // botões com pull-up, soltos
+}
+
+void gpio_pull_up(uint gpio) {
+    (void)gpio;
+}
+
+void gpio_set_function(uint gpio, int fn) {
+    (void)gpio;
+    (void)fn;
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t events, bool enabled, gpio_irq_callback_t callback) {
+    (void)gpio;
+    (void)events;
+    (void)enabled;
+    (void)callback;
+}
+
+uint pio_add_program(PIO pio, const pio_program_t *program) {
+    (void)pio;
+    (void)program;
+    return 0;
+}
+
+int pio_claim_unused_sm(PIO pio, bool required) {
+    (void)pio;
+    (void)required;
+    return 0;
+}
+
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data) {
+    (void)pio;
+    (void)sm;
+    (void)data;
+}
+
+static _Thread_local uint core_num;
+
+uint get_core_num(void) {
+    return core_num;
+}
+
+// SysTick de 24 bits contando para baixo a 125 MHz (HOST_CLK_SYS_HZ)
+systick_hw_t *host_systick_hw(void) {
+    static _Thread_local systick_hw_t systick;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t cycles = (uint64_t)ts.tv_sec * 125000000u + (uint64_t)ts.tv_nsec / 8u;
+    systick.cvr = (uint32_t)~cycles & 0x00FFFFFFu;
+    return &systick;
+}
+
+static void *core1_thread(void *entry) {
+    core_num = 1;
+    ((void (*)(void))entry)();
+    return NULL;
+}
+
+void multicore_launch_core1(void (*entry)(void)) {
+    pthread_t thread;
+    pthread_create(&thread, NULL, core1_thread, (void *)entry);
+    pthread_detach(thread);
+}
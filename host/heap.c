@@ -0,0 +1,14 @@
+// lib/heap.h para a compilação no computador: o heap do glibc cresce sob demanda, então o total é o
+// que ele já reservou do sistema.
+
+#include <malloc.h>
+#include "heap.h"
+
+uint32_t heap_total_bytes(void) {
+    struct mallinfo2 info = mallinfo2();
+    return (uint32_t)(info.arena + info.hblkhd);
+}
+
+uint32_t heap_free_bytes(void) {
+    return (uint32_t)mallinfo2().fordblks;
+}
@@ -0,0 +1,69 @@
+// I2C bloqueante e a interface de lib/i2c_dma.h sobre os sensores simulados. Aqui não há DMA nem
+// interrupção: cada transação acontece inteira dentro de i2c_dma_write_read, que já a deixa concluída
+// (e chama o callback, se houver) antes de retornar.
+
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "i2c_dma.h"
+#include "sensors.h"
+
+struct i2c_inst {
+    unsigned index;
+    uint baudrate;
+    i2c_dma_status_t status;
+};
+
+static struct i2c_inst buses[2] = {{.index = 0}, {.index = 1}};
+i2c_inst_t *const host_i2c0 = &buses[0];
+i2c_inst_t *const host_i2c1 = &buses[1];
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate) {
+    i2c->baudrate = baudrate;
+    return baudrate;
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop) {
+    (void)nostop;
+    return host_i2c_transfer(i2c->index, addr, src, len, NULL, 0) ? (int)len : -1;
+}
+
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop) {
+    (void)nostop;
+    return host_i2c_transfer(i2c->index, addr, NULL, 0, dst, len) ? (int)len : -1;
+}
+
+bool i2c_dma_init(i2c_inst_t *i2c) {
+    (void)i2c;
+    return true;
+}
+
+bool i2c_dma_write_read(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t src_len,
+                        uint8_t *dst, size_t dst_len, i2c_dma_callback_t callback, void *arg) {
+    if (src_len + dst_len == 0 || src_len + dst_len > I2C_DMA_MAX_TRANSFER) {
+        return false;
+    }
+    bool ack = host_i2c_transfer(i2c->index, addr, src, src_len, dst, dst_len);
+    i2c->status = ack ? I2C_DMA_DONE : I2C_DMA_ERROR;
+    if (callback) {
+        callback(i2c, i2c->status, arg);
+    }
+    return true;
+}
+
+i2c_dma_status_t i2c_dma_status(i2c_inst_t *i2c) {
+    return i2c->status;
+}
+
+bool i2c_dma_busy(i2c_inst_t *i2c) {
+    (void)i2c;
+    return false;
+}
+
+i2c_dma_status_t i2c_dma_wait(i2c_inst_t *i2c) {
+    return i2c->status;
+}
+
+bool i2c_dma_write_read_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t src_len,
+                                 uint8_t *dst, size_t dst_len) {
+    return i2c_dma_write_read(i2c, addr, src, src_len, dst, dst_len, NULL, NULL) && i2c->status == I2C_DMA_DONE;
+}
@@ -0,0 +1,16 @@
+#ifndef HOST_BLINK_PIO_H
+#define HOST_BLINK_PIO_H
+
+// Substituto do cabeçalho gerado de blink.pio
+#include "hardware/pio.h"
+
+static const pio_program_t blink_program = {0};
+
+static inline void blink_program_init(PIO pio, uint sm, uint offset, uint pin) {
+    (void)pio;
+    (void)sm;
+    (void)offset;
+    (void)pin;
+}
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef HOST_HARDWARE_CLOCKS_H
+#define HOST_HARDWARE_CLOCKS_H
+
+#include "pico/stdlib.h"
+
+// Clock do sistema simulado, o mesmo usado para o SysTick (hardware/structs/systick.h)
+#define HOST_CLK_SYS_HZ 125000000u
+
+enum clock_index {
+    clk_sys = 5,
+};
+
+static inline uint32_t clock_get_hz(enum clock_index clk_index) {
+    (void)clk_index;
+    return HOST_CLK_SYS_HZ;
+}
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef HOST_HARDWARE_FLASH_H
+#define HOST_HARDWARE_FLASH_H
+
+// Flash simulada (host/flash.c): um array de 2 MB que faz o papel da janela XIP. Como na flash real,
+// apagar leva os bytes a 0xFF e gravar só zera bits.
+
+#include "pico/stdlib.h"
+
+#define FLASH_SECTOR_SIZE 4096u
+#define FLASH_PAGE_SIZE 256u
+#define PICO_FLASH_SIZE_BYTES (2u * 1024 * 1024)
+
+extern uint8_t host_flash[PICO_FLASH_SIZE_BYTES];
+#define XIP_BASE ((uintptr_t)host_flash)
+
+void flash_range_erase(uint32_t flash_offs, size_t count);
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count);
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef HOST_HARDWARE_GPIO_H
+#define HOST_HARDWARE_GPIO_H
+
+// As funções de GPIO estão em pico/stdlib.h
+#include "pico/stdlib.h"
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef HOST_HARDWARE_PIO_H
+#define HOST_HARDWARE_PIO_H
+
+// PIO sem efeito: a matriz de LEDs não é simulada
+
+#include "pico/stdlib.h"
+
+typedef struct pio_hw pio_hw_t;
+typedef pio_hw_t *PIO;
+typedef struct {
+    int unused;
+} pio_program_t;
+
+extern pio_hw_t *const host_pio0;
+#define pio0 host_pio0
+
+uint pio_add_program(PIO pio, const pio_program_t *program);
+int pio_claim_unused_sm(PIO pio, bool required);
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data);
+
+#endif
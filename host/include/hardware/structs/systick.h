@@ -0,0 +1,18 @@
+#ifndef HOST_HARDWARE_STRUCTS_SYSTICK_H
+#define HOST_HARDWARE_STRUCTS_SYSTICK_H
+
+#include <stdint.h>
+
+// Registradores do SysTick do Cortex-M0+. No computador, cvr é recalculado a cada acesso a partir do
+// relógio monotônico, como se o núcleo rodasse a 125 MHz; as escritas não têm efeito.
+typedef struct {
+    volatile uint32_t csr;
+    volatile uint32_t rvr;
+    volatile uint32_t cvr;
+    volatile uint32_t calib;
+} systick_hw_t;
+
+systick_hw_t *host_systick_hw(void);
+#define systick_hw (host_systick_hw())
+
+#endif
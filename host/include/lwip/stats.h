@@ -0,0 +1,36 @@
+#ifndef HOST_LWIP_STATS_H
+#define HOST_LWIP_STATS_H
+
+// Subconjunto de lwip/stats.h (e dos pools de lwip/memp.h) lido por /metrics. host/tcp_socket.c mantém
+// os pools que a pilha simulada tem de fato: PCBs (limitados por MEMP_NUM_TCP_PCB) e os pbufs dos
+// dados recebidos; os demais só informam o tamanho configurado no lwipopts.h.
+
+#include "lwip/tcp.h"
+
+typedef u16_t mem_size_t;
+
+typedef enum {
+    MEMP_TCP_PCB,
+    MEMP_TCP_SEG,
+    MEMP_PBUF,
+    MEMP_PBUF_POOL,
+    MEMP_MAX
+} memp_t;
+
+struct stats_mem {
+    const char *name;
+    u16_t err;
+    mem_size_t avail;
+    mem_size_t used;
+    mem_size_t max;
+    u16_t illegal;
+};
+
+struct stats_ {
+    struct stats_mem mem;
+    struct stats_mem *memp[MEMP_MAX];
+};
+
+extern struct stats_ lwip_stats;
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef HOST_LWIP_TCP_H
+#define HOST_LWIP_TCP_H
+
+// Subconjunto da API raw do lwIP (tcp_*, pbuf_*) usado pelo servidor HTTP, implementado sobre sockets
+// POSIX em host/tcp_socket.c. Os limites (TCP_SND_BUF, MEMP_NUM_TCP_PCB) vêm do mesmo lwipopts.h do
+// firmware, para que o servidor encontre as mesmas restrições de memória.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "lwipopts.h"
+
+typedef uint8_t u8_t;
+typedef uint16_t u16_t;
+typedef uint32_t u32_t;
+typedef int8_t s8_t;
+typedef int16_t s16_t;
+typedef int32_t s32_t;
+typedef s8_t err_t;
+
+#define ERR_OK 0
+#define ERR_MEM -1
+#define ERR_BUF -2
+#define ERR_TIMEOUT -3
+#define ERR_VAL -6
+#define ERR_USE -8
+#define ERR_CONN -11
+#define ERR_ABRT -13
+#define ERR_RST -14
+#define ERR_CLSD -15
+#define ERR_ARG -16
+
+#define LWIP_UNUSED_ARG(x) (void)x
+
+#define TCP_WRITE_FLAG_COPY 0x01
+#define TCP_WRITE_FLAG_MORE 0x02
+#define TCP_PRIO_MIN 1
+#define TCP_PRIO_NORMAL 64
+#define TCP_PRIO_MAX 127
+
+#define IPADDR_TYPE_V4 0
+#define IPADDR_TYPE_ANY 46
+#define IP_ANY_TYPE NULL
+
+struct pbuf {
+    struct pbuf *next;
+    void *payload;
+    u16_t tot_len;
+    u16_t len;
+};
+
+typedef struct {
+    u32_t addr;
+} ip_addr_t;
+
+struct tcp_pcb;
+typedef err_t (*tcp_accept_fn)(void *arg, struct tcp_pcb *newpcb, err_t err);
+typedef err_t (*tcp_recv_fn)(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err);
+typedef err_t (*tcp_sent_fn)(void *arg, struct tcp_pcb *tpcb, u16_t len);
+typedef err_t (*tcp_poll_fn)(void *arg, struct tcp_pcb *tpcb);
+typedef void (*tcp_err_fn)(void *arg, err_t err);
+
+struct tcp_pcb *tcp_new_ip_type(u8_t type);
+err_t tcp_bind(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port);
+struct tcp_pcb *tcp_listen(struct tcp_pcb *pcb);
+void tcp_accept(struct tcp_pcb *pcb, tcp_accept_fn accept);
+void tcp_arg(struct tcp_pcb *pcb, void *arg);
+void tcp_recv(struct tcp_pcb *pcb, tcp_recv_fn recv);
+void tcp_sent(struct tcp_pcb *pcb, tcp_sent_fn sent);
+void tcp_poll(struct tcp_pcb *pcb, tcp_poll_fn poll, u8_t interval);
+void tcp_err(struct tcp_pcb *pcb, tcp_err_fn err);
+void tcp_recved(struct tcp_pcb *pcb, u16_t len);
+err_t tcp_write(struct tcp_pcb *pcb, const void *dataptr, u16_t len, u8_t apiflags);
+err_t tcp_output(struct tcp_pcb *pcb);
+err_t tcp_close(struct tcp_pcb *pcb);
+void tcp_abort(struct tcp_pcb *pcb);
+void tcp_setprio(struct tcp_pcb *pcb, u8_t prio);
+void tcp_nagle_disable(struct tcp_pcb *pcb);
+u16_t host_tcp_sndbuf(const struct tcp_pcb *pcb);
+#define tcp_sndbuf(pcb) host_tcp_sndbuf(pcb)
+
+u16_t pbuf_copy_partial(const struct pbuf *p, void *dataptr, u16_t len, u16_t offset);
+u8_t pbuf_free(struct pbuf *p);
+void pbuf_cat(struct pbuf *head, struct pbuf *tail);
+
+struct netif {
+    ip_addr_t ip_addr;
+};
+extern struct netif *netif_default;
+const ip_addr_t *netif_ip4_addr(const struct netif *netif);
+const char *ip4addr_ntoa(const ip_addr_t *addr);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef HOST_PICO_CYW43_ARCH_H
+#define HOST_PICO_CYW43_ARCH_H
+
+// Substituto do pico/cyw43_arch.h: não há Wi-Fi, e cyw43_arch_poll atende os sockets de
+// host/tcp_socket.c. Os callbacks do lwIP rodam dentro de cyw43_arch_poll, na thread do núcleo 0,
+// então cyw43_arch_lwip_begin/end não precisam fazer nada.
+
+#include "pico/stdlib.h"
+#include "lwip/tcp.h"
+
+#define CYW43_AUTH_WPA2_AES_PSK 0x00400004
+
+int cyw43_arch_init(void);
+void cyw43_arch_enable_sta_mode(void);
+int cyw43_arch_wifi_connect_timeout_ms(const char *ssid, const char *password, uint32_t auth, uint32_t timeout_ms);
+
+// Estado do rádio, só para a assinatura de cyw43_wifi_get_rssi
+typedef struct cyw43_t {
+    int unused;
+} cyw43_t;
+extern cyw43_t cyw43_state;
+int cyw43_wifi_get_rssi(cyw43_t *self, int32_t *rssi);
+void cyw43_arch_poll(void);
+void cyw43_arch_lwip_begin(void);
+void cyw43_arch_lwip_end(void);
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef HOST_PICO_MULTICORE_H
+#define HOST_PICO_MULTICORE_H
+
+// O núcleo 1 é uma thread POSIX
+void multicore_launch_core1(void (*entry)(void));
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+// Substituto do pico/stdlib.h para a compilação no computador (ver host/). Declara só o que o
+// firmware usa, com as mesmas assinaturas do SDK; o tempo é o relógio monotônico do sistema,
+// contado a partir do início do processo.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+
+#define _u(x) x##u
+
+#define PICO_OK 0
+#define PICO_ERROR_TIMEOUT -1
+
+#define GPIO_IN 0
+#define GPIO_OUT 1
+#define GPIO_IRQ_EDGE_FALL 0x4u
+#define GPIO_IRQ_EDGE_RISE 0x8u
+#define GPIO_FUNC_I2C 3
+
+void stdio_init_all(void);
+int getchar_timeout_us(uint32_t timeout_us);
+
+uint64_t time_us_64(void);
+uint32_t time_us_32(void);
+absolute_time_t get_absolute_time(void);
+uint32_t to_ms_since_boot(absolute_time_t t);
+uint64_t to_us_since_boot(absolute_time_t t);
+absolute_time_t delayed_by_ms(absolute_time_t t, uint32_t ms);
+void sleep_ms(uint32_t ms);
+void sleep_us(uint64_t us);
+void sleep_until(absolute_time_t t);
+void tight_loop_contents(void);
+
+// 0 no loop principal, 1 na thread do núcleo 1
+uint get_core_num(void);
+
+typedef void (*gpio_irq_callback_t)(uint gpio, uint32_t events);
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+void gpio_pull_up(uint gpio);
+void gpio_set_function(uint gpio, int fn);
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t events, bool enabled, gpio_irq_callback_t callback);
+
+#endif
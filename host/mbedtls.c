@@ -0,0 +1,105 @@
+// SHA-1 e base64 com as mesmas assinaturas do mbedtls do SDK, usados só no handshake do WebSocket
+
+#include <stdint.h>
+#include <string.h>
+#include "mbedtls/sha1.h"
+#include "mbedtls/base64.h"
+
+#define ROL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+static void sha1_block(uint32_t h[5], const unsigned char *block) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t)block[4 * i] << 24 | (uint32_t)block[4 * i + 1] << 16 | (uint32_t)block[4 * i + 2] << 8 |
+               block[4 * i + 3];
+    }
+    for (int i = 16; i < 80; i++) {
+        w[i] = ROL(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t t = ROL(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = ROL(b, 30);
+        b = a;
+        a = t;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+}
+
+int mbedtls_sha1(const unsigned char *input, size_t ilen, unsigned char output[20]) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    size_t i = 0;
+    for (; i + 64 <= ilen; i += 64) {
+        sha1_block(h, input + i);
+    }
+
+    // Último bloco (ou dois): o resto da mensagem, o bit 1, zeros e o tamanho em bits
+    unsigned char tail[128] = {0};
+    size_t rest = ilen - i;
+    memcpy(tail, input + i, rest);
+    tail[rest] = 0x80;
+    size_t total = rest + 9 <= 64 ? 64 : 128;
+    uint64_t bits = (uint64_t)ilen * 8;
+    for (int j = 0; j < 8; j++) {
+        tail[total - 1 - j] = (unsigned char)(bits >> (8 * j));
+    }
+    for (size_t j = 0; j < total; j += 64) {
+        sha1_block(h, tail + j);
+    }
+
+    for (int j = 0; j < 5; j++) {
+        output[4 * j] = (unsigned char)(h[j] >> 24);
+        output[4 * j + 1] = (unsigned char)(h[j] >> 16);
+        output[4 * j + 2] = (unsigned char)(h[j] >> 8);
+        output[4 * j + 3] = (unsigned char)h[j];
+    }
+    return 0;
+}
+
+int mbedtls_base64_encode(unsigned char *dst, size_t dlen, size_t *olen, const unsigned char *src, size_t slen) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t needed = 4 * ((slen + 2) / 3) + 1;
+    if (dlen < needed) {
+        *olen = needed;
+        return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+    }
+
+    size_t out = 0;
+    for (size_t i = 0; i < slen; i += 3) {
+        uint32_t v = (uint32_t)src[i] << 16;
+        if (i + 1 < slen) {
+            v |= (uint32_t)src[i + 1] << 8;
+        }
+        if (i + 2 < slen) {
+            v |= src[i + 2];
+        }
+        dst[out++] = alphabet[(v >> 18) & 63];
+        dst[out++] = alphabet[(v >> 12) & 63];
+        dst[out++] = i + 1 < slen ? alphabet[(v >> 6) & 63] : '=';
+        dst[out++] = i + 2 < slen ? alphabet[v & 63] : '=';
+    }
+    dst[out] = '\0';
+    *olen = out;
+    return 0;
+}
@@ -0,0 +1,323 @@
+// Repete no computador o processamento das leituras do núcleo 1 (lib/sensor_pipeline.c) sobre um trace
+// capturado na placa (lib/sensor_trace.h), sem esperar o intervalo entre leituras. Serve para medir o
+// custo do processamento isolado e para conferir, bit a bit, que uma mudança não alterou os valores.
+//
+// Uso: estacao_replay [opções] trace
+//   trace         arquivo binário ou log da USB com as linhas "TRC ..." (a captura liga e desliga com 't')
+//   -o ARQUIVO    grava as amostras em CSV, com todos os dígitos significativos de cada float
+//   -e ARQUIVO    compara as amostras com um CSV gravado antes com -o; sai com 1 se algum valor mudou
+//   -b ARQUIVO    salva o trace em formato binário (converte um log da USB)
+//   -n VEZES      repete o processamento para medir o desempenho (padrão: 1)
+//
+// Cada amostra também é comparada com a que a placa produziu (registros SAMPLE). Divergências ali podem
+// vir da biblioteca matemática (pow na altitude) e não são erro; as de -e são.
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "sensor_pipeline.h"
+#include "sensor_trace.h"
+
+#define REPLAY_MAX_DIVERGENCES_SHOWN 5
+
+typedef struct {
+    long records;
+    long reads;
+    long samples;
+    long divergences;      // Amostras diferentes das que a placa produziu
+    uint32_t first_ms;
+    uint32_t last_ms;
+} replay_stats_t;
+
+static uint8_t *read_file(const char *path, size_t *length) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        perror(path);
+        return NULL;
+    }
+    size_t capacity = 1 << 16;
+    uint8_t *data = malloc(capacity);
+    *length = 0;
+    size_t n;
+    while ((n = fread(data + *length, 1, capacity - *length, file)) > 0) {
+        *length += n;
+        if (*length == capacity) {
+            capacity *= 2;
+            data = realloc(data, capacity);
+        }
+    }
+    fclose(file);
+    return data;
+}
+
+// Monta um trace binário com as linhas "TRC ..." de um log; as demais linhas são ignoradas
+static uint8_t *trace_from_log(const uint8_t *log, size_t log_length, size_t *length) {
+    size_t capacity = sizeof(sensor_trace_header_t) + log_length / 2 + 1;
+    uint8_t *data = malloc(capacity);
+    sensor_trace_header_t header = {.magic = SENSOR_TRACE_MAGIC, .version = SENSOR_TRACE_VERSION};
+    memcpy(data, &header, sizeof(header));
+    *length = sizeof(header);
+
+    char line[SENSOR_TRACE_LINE_SIZE + 1];
+    size_t start = 0;
+    while (start < log_length) {
+        const uint8_t *end = memchr(log + start, '\n', log_length - start);
+        size_t line_length = end ? (size_t)(end - (log + start)) : log_length - start;
+        if (line_length < sizeof(line)) {
+            memcpy(line, log + start, line_length);
+            line[line_length] = '\0';
+            *length += sensor_trace_parse_line(line, data + *length, capacity - *length);
+        }
+        start += line_length + 1;
+    }
+    return data;
+}
+
+static void write_sample(FILE *output, const sensor_sample_t *sample, bool alerta) {
+    fprintf(output, "%lu,%.9g,%.9g,%.9g,%.9g,%d\n", (unsigned long)sample->timestamp_ms, sample->temperatura,
+            sample->umidade, sample->pressao, sample->altitude, alerta);
+}
+
+// Processa o trace inteiro; cada amostra vai para output, se houver, e é comparada com a da placa
+static bool replay(const uint8_t *data, size_t length, FILE *output, bool verbose, replay_stats_t *stats) {
+    sensor_trace_reader_t reader;
+    sensor_trace_record_t record;
+    sensor_pipeline_t pipeline;
+    estacao_config_t config;
+    bool have_calib = false, have_config = false;
+
+    memset(stats, 0, sizeof(*stats));
+    if (!sensor_trace_reader_init(&reader, data, length)) {
+        fprintf(stderr, "trace invalido\n");
+        return false;
+    }
+
+    while (sensor_trace_next(&reader, &record)) {
+        stats->records++;
+        switch (record.type) {
+        case SENSOR_TRACE_CALIB: {
+            if (record.length != BMP280_CALIB_SIZE) {
+                break;
+            }
+            struct bmp280_calib_param params;
+            bmp280_decode_calib(record.payload, &params);
+            sensor_pipeline_init(&pipeline, &params);
+            have_calib = true;
+            break;
+        }
+        case SENSOR_TRACE_CONFIG:
+            if (record.length == sizeof(config)) {
+                memcpy(&config, record.payload, sizeof(config));
+                have_config = true;
+            }
+            break;
+        case SENSOR_TRACE_READ: {
+            sensor_trace_read_t read;
+            if (!have_calib || record.length != sizeof(read)) {
+                break;
+            }
+            memcpy(&read, record.payload, sizeof(read));
+            sensor_pipeline_read(&pipeline, read.flags & SENSOR_TRACE_AHT20_DONE, read.aht20,
+                                 read.flags & SENSOR_TRACE_BMP280_DONE, read.bmp280);
+            stats->reads++;
+            break;
+        }
+        case SENSOR_TRACE_SAMPLE: {
+            sensor_trace_sample_t expected;
+            if (!have_calib || !have_config || record.length != sizeof(expected)) {
+                break;
+            }
+            memcpy(&expected, record.payload, sizeof(expected));
+            sensor_sample_t sample;
+            bool alerta = sensor_pipeline_sample(&pipeline, expected.timestamp_ms, &config, &sample);
+
+            sensor_trace_sample_t got = {
+                .timestamp_ms = sample.timestamp_ms,
+                .temperatura = sample.temperatura,
+                .umidade = sample.umidade,
+                .pressao = sample.pressao,
+                .altitude = sample.altitude,
+                .alerta = alerta,
+            };
+            if (memcmp(&got, &expected, sizeof(got)) != 0) {
+                if (verbose && stats->divergences < REPLAY_MAX_DIVERGENCES_SHOWN) {
+                    fprintf(stderr, "  %lu ms: placa %.9g %.9g %.9g %.9g %d, replay %.9g %.9g %.9g %.9g %d\n",
+                            (unsigned long)expected.timestamp_ms, expected.temperatura, expected.umidade,
+                            expected.pressao, expected.altitude, expected.alerta, got.temperatura, got.umidade,
+                            got.pressao, got.altitude, got.alerta);
+                }
+                stats->divergences++;
+            }
+            if (output) {
+                write_sample(output, &sample, alerta);
+            }
+            if (stats->samples == 0) {
+                stats->first_ms = sample.timestamp_ms;
+            }
+            stats->last_ms = sample.timestamp_ms;
+            stats->samples++;
+            break;
+        }
+        default:
+            break;  // Tipos desconhecidos, de versões futuras, são ignorados
+        }
+    }
+    return true;
+}
+
+// Compara a saída com o CSV esperado; mostra a primeira linha diferente
+static bool compare_output(const char *got, size_t got_length, const char *expected_path) {
+    size_t expected_length;
+    char *expected = (char *)read_file(expected_path, &expected_length);
+    if (!expected) {
+        return false;
+    }
+    bool same = got_length == expected_length && memcmp(got, expected, got_length) == 0;
+    if (!same) {
+        size_t i = 0, line_start = 0;
+        long line = 1;
+        while (i < got_length && i < expected_length && got[i] == expected[i]) {
+            if (got[i] == '\n') {
+                line++;
+                line_start = i + 1;
+            }
+            i++;
+        }
+        const char *got_end = memchr(got + line_start, '\n', got_length - line_start);
+        const char *expected_end = memchr(expected + line_start, '\n', expected_length - line_start);
+        int got_n = got_end ? (int)(got_end - got - line_start) : (int)(got_length - line_start);
+        int expected_n = expected_end ? (int)(expected_end - expected - line_start) : (int)(expected_length - line_start);
+        fprintf(stderr, "diferente de %s na linha %ld:\n  esperado: %.*s\n  obtido:   %.*s\n", expected_path, line,
+                expected_n, expected + line_start, got_n, got + line_start);
+    }
+    free(expected);
+    return same;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void benchmark(const uint8_t *data, size_t length, int repeat) {
+    replay_stats_t stats;
+    long samples = 0;
+#if defined(__x86_64__) || defined(__i386__)
+    uint64_t start_cycles = __rdtsc();
+#endif
+    double start = now_s();
+    for (int i = 0; i < repeat; i++) {
+        replay(data, length, NULL, false, &stats);
+        samples += stats.samples;
+    }
+    double elapsed = now_s() - start;
+    if (samples == 0) {
+        return;
+    }
+    printf("%d repeticoes, %ld amostras em %.3f s: %.0f amostras/s, %.1f ns/amostra", repeat, samples, elapsed,
+           samples / elapsed, elapsed * 1e9 / samples);
+#if defined(__x86_64__) || defined(__i386__)
+    printf(", %.0f ciclos de TSC/amostra", (double)(__rdtsc() - start_cycles) / samples);
+#endif
+    printf("\n");
+}
+
+static void usage(void) {
+    fprintf(stderr, "uso: estacao_replay [-o saida.csv] [-e esperado.csv] [-b trace.bin] [-n vezes] trace\n");
+}
+
+int main(int argc, char **argv) {
+    const char *output_path = NULL, *expected_path = NULL, *binary_path = NULL;
+    int repeat = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "o:e:b:n:h")) != -1) {
+        switch (opt) {
+        case 'o':
+            output_path = optarg;
+            break;
+        case 'e':
+            expected_path = optarg;
+            break;
+        case 'b':
+            binary_path = optarg;
+            break;
+        case 'n':
+            repeat = atoi(optarg);
+            break;
+        default:
+            usage();
+            return 2;
+        }
+    }
+    if (optind != argc - 1 || repeat < 1) {
+        usage();
+        return 2;
+    }
+
+    size_t length;
+    uint8_t *data = read_file(argv[optind], &length);
+    if (!data) {
+        return 2;
+    }
+    sensor_trace_reader_t probe;
+    if (!sensor_trace_reader_init(&probe, data, length)) {
+        uint8_t *converted = trace_from_log(data, length, &length);
+        free(data);
+        data = converted;
+    }
+    if (binary_path) {
+        FILE *file = fopen(binary_path, "wb");
+        if (!file || fwrite(data, 1, length, file) != length) {
+            perror(binary_path);
+            return 2;
+        }
+        fclose(file);
+    }
+
+    // Primeira passada: saída, comparações e resumo
+    char *output = NULL;
+    size_t output_length = 0;
+    FILE *memory = open_memstream(&output, &output_length);
+    replay_stats_t stats;
+    if (!replay(data, length, memory, true, &stats)) {
+        return 2;
+    }
+    fclose(memory);
+
+    printf("%ld registros, %ld leituras, %ld amostras (%.1f min de medicoes), %ld divergencias com a placa\n",
+           stats.records, stats.reads, stats.samples, (stats.last_ms - stats.first_ms) / 60000.0, stats.divergences);
+    if (stats.samples == 0) {
+        fprintf(stderr, "nenhuma amostra no trace (falta a calibracao ou a configuracao?)\n");
+        return 2;
+    }
+
+    int status = 0;
+    if (output_path) {
+        FILE *file = fopen(output_path, "w");
+        if (!file || fwrite(output, 1, output_length, file) != output_length) {
+            perror(output_path);
+            return 2;
+        }
+        fclose(file);
+    }
+    if (expected_path) {
+        if (compare_output(output, output_length, expected_path)) {
+            printf("saida identica a %s\n", expected_path);
+        } else {
+            status = 1;
+        }
+    }
+
+    if (repeat > 1) {
+        benchmark(data, length, repeat);
+    }
+    free(output);
+    free(data);
+    return status;
+}
@@ -0,0 +1,345 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sensors.h"
+#include "pico/stdlib.h"
+#include "bmp280_compensation.h"
+
+#define AHT20_ADDR 0x38
+#define AHT20_BUS 1
+#define AHT20_MEASUREMENT_US 80000  // Tempo de conversão do datasheet
+#define AHT20_STATUS_BUSY 0x80
+#define AHT20_STATUS_CALIBRATED 0x08
+
+#define BMP280_ADDR 0x76
+#define BMP280_BUS 0
+#define BMP280_CHIP_ID 0x58
+#define BMP280_REG_CALIB 0x88
+#define BMP280_REG_ID 0xD0
+#define BMP280_REG_RESET 0xE0
+#define BMP280_REG_STATUS 0xF3
+#define BMP280_REG_CTRL_MEAS 0xF4
+#define BMP280_REG_CONFIG 0xF5
+#define BMP280_REG_DATA 0xF7
+#define BMP280_STATUS_MEASURING 0x08
+
+// Calibração do exemplo do datasheet do BMP280 (seção 3.12)
+static const struct bmp280_calib_param BMP280_CALIB = {
+    .dig_t1 = 27504, .dig_t2 = 26435, .dig_t3 = -1000,
+    .dig_p1 = 36477, .dig_p2 = -10685, .dig_p3 = 3024, .dig_p4 = 2855, .dig_p5 = 140,
+    .dig_p6 = -7, .dig_p7 = 15500, .dig_p8 = -14600, .dig_p9 = 6000,
+};
+
+//-------------------------------------------Ambiente-------------------------------------------
+
+typedef struct {
+    uint32_t ms;
+    host_environment_t env;
+} trace_point_t;
+
+static trace_point_t *trace;
+static size_t trace_length;
+static pthread_once_t trace_once = PTHREAD_ONCE_INIT;
+
+static void trace_load(void) {
+    const char *path = getenv("ESTACAO_HOST_TRACE");
+    if (path == NULL) {
+        return;
+    }
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        perror(path);
+        exit(1);
+    }
+
+    size_t capacity = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        trace_point_t point;
+        if (line[0] == '#' || sscanf(line, "%u,%lf,%lf,%lf", &point.ms, &point.env.temperatura,
+                                     &point.env.umidade, &point.env.pressao) != 4) {
+            continue;
+        }
+        if (trace_length > 0 && point.ms <= trace[trace_length - 1].ms) {
+            fprintf(stderr, "%s: instantes fora de ordem em %u ms\n", path, point.ms);
+            exit(1);
+        }
+        if (trace_length == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            trace = realloc(trace, capacity * sizeof(*trace));
+        }
+        trace[trace_length++] = point;
+    }
+    fclose(file);
+
+    if (trace_length == 0) {
+        fprintf(stderr, "%s: nenhum ponto no trace\n", path);
+        exit(1);
+    }
+    printf("Trace %s: %zu pontos, %u ms.\n", path, trace_length, trace[trace_length - 1].ms);
+}
+
+static double lerp(double a, double b, double t) {
+    return a + (b - a) * t;
+}
+
+void host_environment_at(uint64_t time_us, host_environment_t *env) {
+    pthread_once(&trace_once, trace_load);
+
+    if (trace_length == 0) {
+        // Variação lenta (ciclo de 10 minutos) com um ruído pequeno que só depende do instante
+        double t = (double)time_us / 1e6;
+        double cycle = sin(2.0 * M_PI * t / 600.0);
+        uint32_t hash = (uint32_t)(time_us / 100000u) * 2654435761u;
+        double noise = ((double)(hash >> 16) / 65536.0 - 0.5) * 0.1;
+        env->temperatura = 25.0 + 3.0 * cycle + noise;
+        env->umidade = 65.0 - 10.0 * cycle + noise;
+        env->pressao = 101325.0 + 150.0 * cycle + noise * 20.0;
+        return;
+    }
+
+    uint32_t span = trace[trace_length - 1].ms;
+    uint32_t ms = span > 0 ? (uint32_t)((time_us / 1000u) % span) : 0;
+    size_t i = 0;
+    while (i + 1 < trace_length && trace[i + 1].ms <= ms) {
+        i++;
+    }
+    if (i + 1 == trace_length || ms < trace[i].ms) {
+        *env = trace[i].env;
+        return;
+    }
+    const trace_point_t *a = &trace[i], *b = &trace[i + 1];
+    double t = (double)(ms - a->ms) / (double)(b->ms - a->ms);
+    env->temperatura = lerp(a->env.temperatura, b->env.temperatura, t);
+    env->umidade = lerp(a->env.umidade, b->env.umidade, t);
+    env->pressao = lerp(a->env.pressao, b->env.pressao, t);
+}
+
+//-------------------------------------------AHT20-------------------------------------------
+
+static struct {
+    bool calibrated;
+    uint64_t ready_us;  // Fim da medição em andamento
+    uint8_t data[7];    // Status, 5 bytes de medição e CRC
+} aht20;
+
+static uint8_t aht20_crc8(const uint8_t *data, int length) {
+    uint8_t crc = 0xFF;
+    for (int i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint32_t aht20_scale(double value, double offset, double range) {
+    double raw = round((value + offset) / range * 1048576.0);
+    return raw < 0 ? 0 : raw > 0xFFFFF ? 0xFFFFF : (uint32_t)raw;
+}
+
+static void aht20_write(const uint8_t *src, size_t len) {
+    if (len == 0) {
+        return;
+    }
+    switch (src[0]) {
+        case 0xBE:  // Inicialização/calibração
+            aht20.calibrated = true;
+            break;
+        case 0xBA:  // Reset
+            aht20.ready_us = 0;
+            break;
+        case 0xAC: {  // Dispara a medição; o resultado é o ambiente do fim da conversão
+            aht20.ready_us = time_us_64() + AHT20_MEASUREMENT_US;
+            host_environment_t env;
+            host_environment_at(aht20.ready_us, &env);
+            uint32_t humidity = aht20_scale(env.umidade, 0.0, 100.0);
+            uint32_t temperature = aht20_scale(env.temperatura, 50.0, 200.0);
+            aht20.data[1] = (uint8_t)(humidity >> 12);
+            aht20.data[2] = (uint8_t)(humidity >> 4);
+            aht20.data[3] = (uint8_t)((humidity & 0x0F) << 4 | temperature >> 16);
+            aht20.data[4] = (uint8_t)(temperature >> 8);
+            aht20.data[5] = (uint8_t)temperature;
+            break;
+        }
+    }
+}
+
+static void aht20_read(uint8_t *dst, size_t len) {
+    aht20.data[0] = (aht20.calibrated ? AHT20_STATUS_CALIBRATED | 0x10 : 0x10) |
+                    (time_us_64() < aht20.ready_us ? AHT20_STATUS_BUSY : 0);
+    aht20.data[6] = aht20_crc8(aht20.data, 6);
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = i < sizeof(aht20.data) ? aht20.data[i] : 0xFF;
+    }
+}
+
+//-------------------------------------------BMP280-------------------------------------------
+
+static struct {
+    bool initialized;
+    uint8_t regs[256];
+    uint8_t pointer;          // Registrador da próxima leitura
+    uint64_t ready_us;        // Fim da conversão em andamento
+    uint64_t next_normal_us;  // Próxima conversão no modo normal
+} bmp280;
+
+static void bmp280_reset(void) {
+    memset(bmp280.regs, 0, sizeof(bmp280.regs));
+    const struct bmp280_calib_param *c = &BMP280_CALIB;
+    const uint16_t words[12] = {c->dig_t1, (uint16_t)c->dig_t2, (uint16_t)c->dig_t3, c->dig_p1,
+                                (uint16_t)c->dig_p2, (uint16_t)c->dig_p3, (uint16_t)c->dig_p4, (uint16_t)c->dig_p5,
+                                (uint16_t)c->dig_p6, (uint16_t)c->dig_p7, (uint16_t)c->dig_p8, (uint16_t)c->dig_p9};
+    for (int i = 0; i < 12; i++) {
+        bmp280.regs[BMP280_REG_CALIB + 2 * i] = (uint8_t)words[i];
+        bmp280.regs[BMP280_REG_CALIB + 2 * i + 1] = (uint8_t)(words[i] >> 8);
+    }
+    bmp280.regs[BMP280_REG_ID] = BMP280_CHIP_ID;
+    bmp280.regs[BMP280_REG_DATA + 0] = 0x80;  // Valores de reset dos registradores de dados
+    bmp280.regs[BMP280_REG_DATA + 3] = 0x80;
+    bmp280.ready_us = 0;
+    bmp280.initialized = true;
+}
+
+// Leitura bruta de temperatura que a compensação converte na temperatura pedida (busca binária; a
+// compensação é crescente na faixa de operação)
+static int32_t bmp280_raw_temperature(double celsius, int32_t *t_fine) {
+    int32_t target = (int32_t)lround(celsius * 5120.0);
+    int32_t low = 0, high = 0xFFFFF;
+    while (low < high) {
+        int32_t mid = (low + high) / 2;
+        if (bmp280_compensate_t_fine(mid, &BMP280_CALIB) < target) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    *t_fine = bmp280_compensate_t_fine(low, &BMP280_CALIB);
+    return low;
+}
+
+// Leitura bruta de pressão para a pressão pedida (a compensação é decrescente)
+static int32_t bmp280_raw_pressure(double pascal, int32_t t_fine) {
+    uint32_t target = (uint32_t)lround(pascal * 256.0);
+    int32_t low = 0, high = 0xFFFFF;
+    while (low < high) {
+        int32_t mid = (low + high) / 2;
+        if (bmp280_compensate_pressure_64(mid, t_fine, &BMP280_CALIB) > target) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// Oversampling configurado (0 a 16 amostras) para o campo osrs de ctrl_meas
+static int bmp280_samples(uint8_t osrs) {
+    return osrs == 0 ? 0 : osrs >= 5 ? 16 : 1 << (osrs - 1);
+}
+
+// Tempo de conversão típico do datasheet (seção 3.8.1), em µs
+static uint64_t bmp280_conversion_us(uint8_t ctrl_meas) {
+    int t = bmp280_samples((ctrl_meas >> 5) & 7);
+    int p = bmp280_samples((ctrl_meas >> 2) & 7);
+    return 1000 + 2000 * (uint64_t)t + 2000 * (uint64_t)p + (p ? 500 : 0);
+}
+
+// Conclui a conversão que terminou: atualiza os registradores de dados e volta ao modo sleep (forçado)
+static void bmp280_update(void) {
+    uint64_t now = time_us_64();
+    uint8_t ctrl_meas = bmp280.regs[BMP280_REG_CTRL_MEAS];
+    uint8_t mode = ctrl_meas & 3;
+    if (mode == 3 && bmp280.ready_us == 0 && now >= bmp280.next_normal_us) {
+        bmp280.ready_us = now + bmp280_conversion_us(ctrl_meas);
+        bmp280.next_normal_us = bmp280.ready_us;
+    }
+    if (bmp280.ready_us == 0 || now < bmp280.ready_us) {
+        bmp280.regs[BMP280_REG_STATUS] = bmp280.ready_us ? BMP280_STATUS_MEASURING : 0;
+        return;
+    }
+
+    host_environment_t env;
+    host_environment_at(bmp280.ready_us, &env);
+    int32_t t_fine;
+    int32_t raw_t = bmp280_raw_temperature(env.temperatura, &t_fine);
+    int32_t raw_p = bmp280_raw_pressure(env.pressao, t_fine);
+    if (((ctrl_meas >> 5) & 7) == 0) {
+        raw_t = 0x80000;  // medição desligada: valor de reset
+    }
+    if (((ctrl_meas >> 2) & 7) == 0) {
+        raw_p = 0x80000;
+    }
+    uint8_t *data = &bmp280.regs[BMP280_REG_DATA];
+    data[0] = (uint8_t)(raw_p >> 12);
+    data[1] = (uint8_t)(raw_p >> 4);
+    data[2] = (uint8_t)((raw_p & 0x0F) << 4);
+    data[3] = (uint8_t)(raw_t >> 12);
+    data[4] = (uint8_t)(raw_t >> 4);
+    data[5] = (uint8_t)((raw_t & 0x0F) << 4);
+
+    bmp280.ready_us = 0;
+    bmp280.regs[BMP280_REG_STATUS] = 0;
+    if (mode != 3) {
+        bmp280.regs[BMP280_REG_CTRL_MEAS] &= (uint8_t)~3;
+    }
+}
+
+// Escritas são pares registrador/valor; um byte sozinho só posiciona o ponteiro de leitura
+static void bmp280_write(const uint8_t *src, size_t len) {
+    if (len == 1) {
+        bmp280.pointer = src[0];
+        return;
+    }
+    for (size_t i = 0; i + 1 < len; i += 2) {
+        uint8_t reg = src[i], value = src[i + 1];
+        if (reg == BMP280_REG_RESET) {
+            if (value == 0xB6) {
+                bmp280_reset();
+            }
+        } else if (reg == BMP280_REG_CONFIG) {
+            bmp280.regs[reg] = value & 0xFD;
+        } else if (reg == BMP280_REG_CTRL_MEAS) {
+            bmp280.regs[reg] = value;
+            uint8_t mode = value & 3;
+            if (mode == 1 || mode == 2) {
+                bmp280.ready_us = time_us_64() + bmp280_conversion_us(value);
+            } else if (mode == 3) {
+                bmp280.next_normal_us = 0;
+            }
+        }
+    }
+}
+
+static void bmp280_read(uint8_t *dst, size_t len) {
+    bmp280_update();
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = bmp280.regs[(uint8_t)(bmp280.pointer + i)];
+    }
+}
+
+//-------------------------------------------Barramento-------------------------------------------
+
+static pthread_mutex_t bus_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+bool host_i2c_transfer(unsigned bus, uint8_t addr, const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_len) {
+    bool ack = true;
+    pthread_mutex_lock(&bus_mutex);
+    if (bus == AHT20_BUS && addr == AHT20_ADDR) {
+        aht20_write(src, src_len);
+        aht20_read(dst, dst_len);
+    } else if (bus == BMP280_BUS && addr == BMP280_ADDR) {
+        if (!bmp280.initialized) {
+            bmp280_reset();
+        }
+        bmp280_write(src, src_len);
+        bmp280_read(dst, dst_len);
+    } else {
+        ack = false;
+    }
+    pthread_mutex_unlock(&bus_mutex);
+    return ack;
+}
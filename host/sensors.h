@@ -0,0 +1,30 @@
+#ifndef HOST_SENSORS_H
+#define HOST_SENSORS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Sensores simulados no nível de registradores: um AHT20 (0x38) no barramento 1 e um BMP280 (0x76)
+// no barramento 0, como no firmware. Os dois medem o mesmo ambiente, que vem de um trace CSV
+// (ESTACAO_HOST_TRACE) ou, sem ele, de uma variação sintética e determinística.
+//
+// Formato do trace: uma linha por ponto, "ms,temperatura_c,umidade_pct,pressao_pa", com ms crescente
+// a partir do início da execução; linhas começando com '#' são ignoradas. Entre dois pontos os valores
+// são interpolados, e depois do último o trace recomeça.
+
+// Grandezas físicas vistas pelos sensores
+typedef struct {
+    double temperatura;  // °C
+    double umidade;      // %
+    double pressao;      // Pa
+} host_environment_t;
+
+// Ambiente no instante time_us (desde o início da execução)
+void host_environment_at(uint64_t time_us, host_environment_t *env);
+
+// Transação no barramento simulado: escreve src_len bytes e depois lê dst_len bytes do dispositivo.
+// Retorna false se nenhum dispositivo responder no endereço (NACK).
+bool host_i2c_transfer(unsigned bus, uint8_t addr, const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_len);
+
+#endif
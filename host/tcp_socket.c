@@ -0,0 +1,497 @@
+// API raw do lwIP (tcp_*, pbuf_*) sobre sockets POSIX não bloqueantes. Tudo acontece dentro de
+// cyw43_arch_poll, chamada pelo loop principal do firmware: aceita conexões, entrega os dados recebidos
+// em cadeias de pbufs (tcp_recv), envia o que foi escrito (tcp_write/tcp_output), confirma o envio
+// (tcp_sent) e chama tcp_poll a cada 500 ms, como o lwIP.
+//
+// Variáveis de ambiente:
+//   ESTACAO_HOST_PORT   porta do servidor (padrão: 8080 no lugar das portas abaixo de 1024)
+//   ESTACAO_HOST_SNDBUF limite de tcp_sndbuf por conexão (padrão: TCP_SND_BUF do lwipopts.h)
+//   ESTACAO_HOST_PBUF   tamanho máximo de cada pbuf recebido (padrão: 512), para exercitar o
+//                       reagrupamento de requisições que chegam em pedaços
+//   ESTACAO_HOST_STATS  arquivo reescrito a cada 500 ms com os contadores da pilha simulada
+//                       (conexões, pool de PCBs esgotado, tcp_write sem espaço), lido por bench/http_load
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#undef TCP_MSS  // o de netinet/tcp.h; vale o do lwipopts.h
+#include "pico/cyw43_arch.h"
+#include "lwip/stats.h"
+
+#define HOST_TCP_POLL_US 500000  // Período do tcp_poll do lwIP
+#define HOST_TCP_PBUF_SIZE 512
+
+struct tcp_pcb {
+    int fd;
+    bool listening;
+    bool closing;  // tcp_close chamado: termina de enviar e fecha
+    bool dead;     // socket fechado; o pcb é liberado no fim de cyw43_arch_poll
+    u16_t port;
+    void *arg;
+    tcp_accept_fn accept;
+    tcp_recv_fn recv;
+    tcp_sent_fn sent;
+    tcp_poll_fn poll;
+    tcp_err_fn err;
+    u8_t poll_interval;
+    u8_t poll_ticks;
+    size_t tx_length;  // Bytes escritos e ainda não confirmados
+    size_t tx_sent;    // Quantos deles já foram entregues ao socket
+    uint8_t tx[TCP_SND_BUF];
+    struct tcp_pcb *next;
+};
+
+static struct tcp_pcb *pcbs;
+static int active_pcbs;
+
+// Estatísticas no formato do lwIP (MEMP_STATS), lidas pelo /metrics do firmware
+static struct stats_mem memp_tcp_pcb = {.name = "TCP_PCB", .avail = MEMP_NUM_TCP_PCB};
+static struct stats_mem memp_tcp_seg = {.name = "TCP_SEG", .avail = MEMP_NUM_TCP_SEG};
+static struct stats_mem memp_pbuf = {.name = "PBUF_REF/ROM"};
+static struct stats_mem memp_pbuf_pool = {.name = "PBUF_POOL", .avail = PBUF_POOL_SIZE};
+struct stats_ lwip_stats = {
+    .mem = {.name = "MEM", .avail = MEM_SIZE},
+    .memp = {
+        [MEMP_TCP_PCB] = &memp_tcp_pcb,
+        [MEMP_TCP_SEG] = &memp_tcp_seg,
+        [MEMP_PBUF] = &memp_pbuf,
+        [MEMP_PBUF_POOL] = &memp_pbuf_pool,
+    },
+};
+
+static void memp_stat_alloc(struct stats_mem *stat) {
+    if (++stat->used > stat->max) {
+        stat->max = stat->used;
+    }
+}
+
+static uint64_t last_poll_us;
+
+// Contadores exportados em ESTACAO_HOST_STATS
+static struct {
+    unsigned long accepted;         // Conexões entregues ao tcp_accept do firmware
+    unsigned long pcb_exhausted;    // Conexões fechadas por falta de PCB (MEMP_NUM_TCP_PCB)
+    unsigned long accept_rejected;  // Conexões recusadas pelo firmware (pool de contextos cheio)
+    unsigned long aborted;          // Chamadas a tcp_abort, incluindo as recusas acima
+    unsigned long write_mem;        // tcp_write que devolveram ERR_MEM
+    unsigned long bytes_in;
+    unsigned long bytes_out;
+    int pcb_high_water;             // Maior número de PCBs ativos ao mesmo tempo
+} stats;
+
+static struct netif host_netif = {.ip_addr = {0x0100007f}};
+struct netif *netif_default = &host_netif;
+
+const ip_addr_t *netif_ip4_addr(const struct netif *netif) {
+    return &netif->ip_addr;
+}
+
+const char *ip4addr_ntoa(const ip_addr_t *addr) {
+    static char text[16];
+    const uint8_t *bytes = (const uint8_t *)&addr->addr;
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", bytes[0], bytes[1], bytes[2], bytes[3]);
+    return text;
+}
+
+static size_t env_size(const char *name, size_t fallback) {
+    const char *value = getenv(name);
+    return value ? (size_t)strtoul(value, NULL, 10) : fallback;
+}
+
+static struct tcp_pcb *pcb_alloc(int fd) {
+    struct tcp_pcb *pcb = calloc(1, sizeof(*pcb));
+    pcb->fd = fd;
+    pcb->next = pcbs;
+    pcbs = pcb;
+    return pcb;
+}
+
+static void pcb_kill(struct tcp_pcb *pcb) {
+    if (pcb->fd >= 0) {
+        close(pcb->fd);
+    }
+    pcb->fd = -1;
+    pcb->dead = true;
+    if (!pcb->listening) {
+        active_pcbs--;
+        memp_tcp_pcb.used--;
+    }
+}
+
+struct tcp_pcb *tcp_new_ip_type(u8_t type) {
+    (void)type;
+    signal(SIGPIPE, SIG_IGN);
+    return pcb_alloc(-1);
+}
+
+err_t tcp_bind(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port) {
+    (void)ipaddr;
+    pcb->port = (u16_t)env_size("ESTACAO_HOST_PORT", port < 1024 ? 8080 : port);
+    return ERR_OK;
+}
+
+struct tcp_pcb *tcp_listen(struct tcp_pcb *pcb) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in address = {
+        .sin_family = AF_INET,
+        .sin_port = htons(pcb->port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) < 0 || listen(fd, 64) < 0) {
+        perror("tcp_listen");
+        close(fd);
+        return NULL;
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    pcb->fd = fd;
+    pcb->listening = true;
+    printf("Servidor simulado em http://127.0.0.1:%u/\n", pcb->port);
+    return pcb;
+}
+
+void tcp_accept(struct tcp_pcb *pcb, tcp_accept_fn accept) {
+    pcb->accept = accept;
+}
+
+void tcp_arg(struct tcp_pcb *pcb, void *arg) {
+    pcb->arg = arg;
+}
+
+void tcp_recv(struct tcp_pcb *pcb, tcp_recv_fn recv) {
+    pcb->recv = recv;
+}
+
+void tcp_sent(struct tcp_pcb *pcb, tcp_sent_fn sent) {
+    pcb->sent = sent;
+}
+
+void tcp_poll(struct tcp_pcb *pcb, tcp_poll_fn poll, u8_t interval) {
+    pcb->poll = poll;
+    pcb->poll_interval = interval;
+    pcb->poll_ticks = 0;
+}
+
+void tcp_err(struct tcp_pcb *pcb, tcp_err_fn err) {
+    pcb->err = err;
+}
+
+void tcp_recved(struct tcp_pcb *pcb, u16_t len) {
+    (void)pcb;
+    (void)len;
+}
+
+void tcp_setprio(struct tcp_pcb *pcb, u8_t prio) {
+    (void)pcb;
+    (void)prio;
+}
+
+void tcp_nagle_disable(struct tcp_pcb *pcb) {
+    (void)pcb;
+}
+
+u16_t host_tcp_sndbuf(const struct tcp_pcb *pcb) {
+    size_t limit = env_size("ESTACAO_HOST_SNDBUF", TCP_SND_BUF);
+    if (limit > TCP_SND_BUF) {
+        limit = TCP_SND_BUF;
+    }
+    return pcb->tx_length >= limit ? 0 : (u16_t)(limit - pcb->tx_length);
+}
+
+err_t tcp_write(struct tcp_pcb *pcb, const void *dataptr, u16_t len, u8_t apiflags) {
+    (void)apiflags;  // os dados são sempre copiados
+    if (pcb->dead || pcb->closing) {
+        return ERR_CONN;
+    }
+    if (len > host_tcp_sndbuf(pcb)) {
+        stats.write_mem++;
+        return ERR_MEM;
+    }
+    memcpy(pcb->tx + pcb->tx_length, dataptr, len);
+    pcb->tx_length += len;
+    return ERR_OK;
+}
+
+static void pcb_flush(struct tcp_pcb *pcb) {
+    while (pcb->tx_sent < pcb->tx_length) {
+        ssize_t n = send(pcb->fd, pcb->tx + pcb->tx_sent, pcb->tx_length - pcb->tx_sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            break;
+        }
+        pcb->tx_sent += (size_t)n;
+        stats.bytes_out += (unsigned long)n;
+    }
+}
+
+err_t tcp_output(struct tcp_pcb *pcb) {
+    if (!pcb->dead) {
+        pcb_flush(pcb);
+    }
+    return ERR_OK;
+}
+
+err_t tcp_close(struct tcp_pcb *pcb) {
+    pcb->closing = true;
+    pcb->recv = NULL;
+    pcb->sent = NULL;
+    pcb->poll = NULL;
+    pcb->err = NULL;
+    return ERR_OK;
+}
+
+void tcp_abort(struct tcp_pcb *pcb) {
+    tcp_err_fn err = pcb->err;
+    void *arg = pcb->arg;
+    struct linger linger = {.l_onoff = 1, .l_linger = 0};  // envia RST, como o lwIP
+    stats.aborted++;
+    setsockopt(pcb->fd, SOL_SOCKET, SO_LINGER, &linger, sizeof(linger));
+    pcb_kill(pcb);
+    if (err) {
+        err(arg, ERR_ABRT);
+    }
+}
+
+u16_t pbuf_copy_partial(const struct pbuf *p, void *dataptr, u16_t len, u16_t offset) {
+    u16_t copied = 0;
+    for (; p && copied < len; p = p->next) {
+        if (offset >= p->len) {
+            offset -= p->len;
+            continue;
+        }
+        u16_t n = p->len - offset;
+        if (n > len - copied) {
+            n = len - copied;
+        }
+        memcpy((uint8_t *)dataptr + copied, (const uint8_t *)p->payload + offset, n);
+        copied += n;
+        offset = 0;
+    }
+    return copied;
+}
+
+u8_t pbuf_free(struct pbuf *p) {
+    u8_t count = 0;
+    while (p) {
+        struct pbuf *next = p->next;
+        free(p);
+        memp_pbuf_pool.used--;
+        p = next;
+        count++;
+    }
+    return count;
+}
+
+void pbuf_cat(struct pbuf *head, struct pbuf *tail) {
+    struct pbuf *p = head;
+    for (; p->next; p = p->next) {
+        p->tot_len += tail->tot_len;
+    }
+    p->tot_len += tail->tot_len;
+    p->next = tail;
+}
+
+// Divide os bytes recebidos em uma cadeia de pbufs de até ESTACAO_HOST_PBUF bytes
+static struct pbuf *pbuf_chain(const uint8_t *data, size_t length) {
+    size_t chunk = env_size("ESTACAO_HOST_PBUF", HOST_TCP_PBUF_SIZE);
+    if (chunk == 0) {
+        chunk = HOST_TCP_PBUF_SIZE;
+    }
+    struct pbuf *head = NULL, **tail = &head;
+    size_t remaining = length;
+    for (size_t offset = 0; offset < length; offset += chunk) {
+        size_t n = length - offset < chunk ? length - offset : chunk;
+        struct pbuf *p = malloc(sizeof(*p) + n);
+        memp_stat_alloc(&memp_pbuf_pool);
+        p->next = NULL;
+        p->payload = p + 1;
+        p->len = (u16_t)n;
+        p->tot_len = (u16_t)remaining;
+        memcpy(p->payload, data + offset, n);
+        remaining -= n;
+        *tail = p;
+        tail = &p->next;
+    }
+    return head;
+}
+
+static void pcb_accept_all(struct tcp_pcb *listener) {
+    int fd;
+    while ((fd = accept(listener->fd, NULL, NULL)) >= 0) {
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (active_pcbs >= MEMP_NUM_TCP_PCB) {
+            close(fd);  // sem PCB livre, como o lwIP com o pool esgotado
+            stats.pcb_exhausted++;
+            memp_tcp_pcb.err++;
+            continue;
+        }
+        if (++active_pcbs > stats.pcb_high_water) {
+            stats.pcb_high_water = active_pcbs;
+        }
+        memp_stat_alloc(&memp_tcp_pcb);
+        stats.accepted++;
+        struct tcp_pcb *pcb = pcb_alloc(fd);
+        if (listener->accept(listener->arg, pcb, ERR_OK) != ERR_OK) {
+            stats.accept_rejected++;
+            if (!pcb->dead) {
+                pcb_kill(pcb);
+            }
+        }
+    }
+}
+
+static void pcb_service(struct tcp_pcb *pcb, bool poll_tick) {
+    if (pcb->listening) {
+        pcb_accept_all(pcb);
+        return;
+    }
+
+    // O que já saiu pelo socket conta como confirmado
+    if (pcb->tx_sent > 0) {
+        size_t sent = pcb->tx_sent;
+        memmove(pcb->tx, pcb->tx + sent, pcb->tx_length - sent);
+        pcb->tx_length -= sent;
+        pcb->tx_sent = 0;
+        if (pcb->sent && !pcb->closing) {
+            pcb->sent(pcb->arg, pcb, (u16_t)sent);
+        }
+        if (pcb->dead) {
+            return;
+        }
+    }
+
+    if (pcb->closing) {
+        pcb_flush(pcb);
+        if (pcb->tx_sent == pcb->tx_length) {
+            shutdown(pcb->fd, SHUT_WR);
+            pcb_kill(pcb);
+        }
+        return;
+    }
+
+    uint8_t buffer[4096];
+    ssize_t n = recv(pcb->fd, buffer, sizeof(buffer), 0);
+    if (n > 0) {
+        stats.bytes_in += (unsigned long)n;
+        if (pcb->recv) {
+            pcb->recv(pcb->arg, pcb, pbuf_chain(buffer, (size_t)n), ERR_OK);
+        }
+    } else if (n == 0) {
+        if (pcb->recv) {
+            pcb->recv(pcb->arg, pcb, NULL, ERR_OK);
+        } else {
+            tcp_close(pcb);
+        }
+    } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        tcp_err_fn err = pcb->err;
+        void *arg = pcb->arg;
+        pcb_kill(pcb);
+        if (err) {
+            err(arg, ERR_RST);
+        }
+        return;
+    }
+    if (pcb->dead) {
+        return;
+    }
+
+    pcb_flush(pcb);
+
+    if (poll_tick && pcb->poll && !pcb->closing && ++pcb->poll_ticks >= pcb->poll_interval) {
+        pcb->poll_ticks = 0;
+        pcb->poll(pcb->arg, pcb);
+    }
+}
+
+// Reescreve o arquivo de ESTACAO_HOST_STATS ("nome valor" por linha). A troca por rename garante que
+// quem lê nunca vê o arquivo pela metade.
+static void stats_write(void) {
+    const char *path = getenv("ESTACAO_HOST_STATS");
+    if (!path) {
+        return;
+    }
+    char temp[512];
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    FILE *file = fopen(temp, "w");
+    if (!file) {
+        return;
+    }
+    fprintf(file, "accepted %lu\n", stats.accepted);
+    fprintf(file, "pcb_exhausted %lu\n", stats.pcb_exhausted);
+    fprintf(file, "accept_rejected %lu\n", stats.accept_rejected);
+    fprintf(file, "aborted %lu\n", stats.aborted);
+    fprintf(file, "write_mem %lu\n", stats.write_mem);
+    fprintf(file, "bytes_in %lu\n", stats.bytes_in);
+    fprintf(file, "bytes_out %lu\n", stats.bytes_out);
+    fprintf(file, "pcb_active %d\n", active_pcbs);
+    fprintf(file, "pcb_high_water %d\n", stats.pcb_high_water);
+    fprintf(file, "pcb_pool %d\n", MEMP_NUM_TCP_PCB);
+    fclose(file);
+    rename(temp, path);
+}
+
+int cyw43_arch_init(void) {
+    return 0;
+}
+
+void cyw43_arch_enable_sta_mode(void) {
+}
+
+int cyw43_arch_wifi_connect_timeout_ms(const char *ssid, const char *password, uint32_t auth, uint32_t timeout_ms) {
+    (void)ssid;
+    (void)password;
+    (void)auth;
+    (void)timeout_ms;
+    return 0;
+}
+
+cyw43_t cyw43_state;
+
+// Não há rádio: o RSSI é sempre o de um sinal bom
+int cyw43_wifi_get_rssi(cyw43_t *self, int32_t *rssi) {
+    (void)self;
+    *rssi = -50;
+    return 0;
+}
+
+void cyw43_arch_lwip_begin(void) {
+}
+
+void cyw43_arch_lwip_end(void) {
+}
+
+void cyw43_arch_poll(void) {
+    uint64_t now = time_us_64();
+    bool poll_tick = now - last_poll_us >= HOST_TCP_POLL_US;
+    if (poll_tick) {
+        last_poll_us = now;
+        stats_write();
+    }
+
+    for (struct tcp_pcb *pcb = pcbs; pcb; pcb = pcb->next) {
+        if (!pcb->dead) {
+            pcb_service(pcb, poll_tick);
+        }
+    }
+
+    // Libera os pcbs fechados; nenhum callback guarda ponteiros para eles depois de tcp_err/tcp_close
+    struct tcp_pcb **link = &pcbs;
+    while (*link) {
+        struct tcp_pcb *pcb = *link;
+        if (pcb->dead) {
+            *link = pcb->next;
+            free(pcb);
+        } else {
+            link = &pcb->next;
+        }
+    }
+}
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
+#include "i2c_dma.h"
 #include "aht20.h"
 
 #define AHT20_I2C_ADDR      0x38
@@ -10,15 +11,23 @@
 #define AHT20_STATUS_BUSY   0x80  // Bit de status ocupado
 #define AHT20_STATUS_CALIBRATED 0x08  // Bit de calibração
 
+// Resultado lido por DMA e quantos bytes foram pedidos (6 sem CRC, 7 com CRC)
+static uint8_t result_buffer[7];
+static int result_length;
+
 bool aht20_init(i2c_inst_t *i2c) {
+    if (!i2c_dma_init(i2c)) {
+        return false;
+    }
+
     uint8_t init_cmd[3] = {AHT20_CMD_INIT, 0x08, 0x00};
-    i2c_write_blocking(i2c, AHT20_I2C_ADDR, init_cmd, 3, false);
+    i2c_dma_write_read_blocking(i2c, AHT20_I2C_ADDR, init_cmd, 3, NULL, 0);
     sleep_ms(50);  // Aguarda o sensor inicializar
 
     // Verifica status até que o sensor esteja pronto
     uint8_t status;
     for (int i = 0; i < 10; i++) {
-        i2c_read_blocking(i2c, AHT20_I2C_ADDR, &status, 1, false);
+        i2c_dma_write_read_blocking(i2c, AHT20_I2C_ADDR, NULL, 0, &status, 1);
         if ((status & AHT20_STATUS_CALIBRATED) == AHT20_STATUS_CALIBRATED) {
             return true;  // Sensor calibrado e pronto
         }
@@ -28,31 +37,52 @@ bool aht20_init(i2c_inst_t *i2c) {
     return false;  // Falhou na calibração
 }
 
-bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data) {
+bool aht20_start_measurement(i2c_inst_t *i2c) {
     uint8_t trigger_cmd[3] = {AHT20_CMD_TRIGGER, 0x33, 0x00};
-    uint8_t buffer[6];
+    return i2c_dma_write_read_blocking(i2c, AHT20_I2C_ADDR, trigger_cmd, 3, NULL, 0);
+}
 
-    // Envia comando de medição
-    i2c_write_blocking(i2c, AHT20_I2C_ADDR, trigger_cmd, 3, false);
-    
-    // Aguarda até o sensor estar pronto
-    uint8_t status;
-    for (int i = 0; i < 10; i++) {
-        i2c_read_blocking(i2c, AHT20_I2C_ADDR, &status, 1, false);
-        if (!(status & AHT20_STATUS_BUSY)) {
-            break;
+// CRC-8 do AHT20: polinômio 0x31 (x^8 + x^5 + x^4 + 1), valor inicial 0xFF
+static uint8_t aht20_crc8(const uint8_t *data, int length) {
+    uint8_t crc = 0xFF;
+    for (int i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
         }
-        sleep_ms(10);
     }
-    
-    // Se ainda estiver ocupado, falha na leitura
-    if (status & AHT20_STATUS_BUSY) {
-        return false;
+    return crc;
+}
+
+// Inicia a leitura do status e dos dados em uma única transação; length é 6 (sem CRC) ou 7 (com CRC)
+static bool aht20_request(i2c_inst_t *i2c, int length) {
+    result_length = length;
+    return i2c_dma_write_read(i2c, AHT20_I2C_ADDR, NULL, 0, result_buffer, length, NULL, NULL);
+}
+
+bool aht20_request_result(i2c_inst_t *i2c) {
+    return aht20_request(i2c, 7);
+}
+
+aht20_result_t aht20_take_result(i2c_inst_t *i2c, AHT20_Data *data) {
+    if (i2c_dma_status(i2c) != I2C_DMA_DONE) {
+        return AHT20_RESULT_ERROR;
     }
+    return aht20_decode(result_buffer, result_length, data);
+}
 
-    // Lê os 6 bytes de dados
-    if (i2c_read_blocking(i2c, AHT20_I2C_ADDR, buffer, 6, false) != 6) {
-        return false;
+const uint8_t *aht20_result_bytes(void) {
+    return result_buffer;
+}
+
+aht20_result_t aht20_decode(const uint8_t *buffer, int length, AHT20_Data *data) {
+    // O primeiro byte é o status: enquanto estiver ocupado, os dados ainda não são válidos
+    if (buffer[0] & AHT20_STATUS_BUSY) {
+        return AHT20_RESULT_BUSY;
+    }
+
+    if (length == 7 && aht20_crc8(buffer, 6) != buffer[6]) {
+        return AHT20_RESULT_CRC_ERROR;
     }
 
     // Processa os dados de umidade (20 bits)
@@ -63,17 +93,50 @@ bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data) {
     uint32_t raw_temp = ((uint32_t)(buffer[3] & 0x0F) << 16) | ((uint32_t)buffer[4] << 8) | buffer[5];
     data->temperature = ((float)raw_temp * 200.0 / 1048576.0) - 50.0;
 
-    return true;
+    return AHT20_RESULT_READY;
+}
+
+static aht20_result_t aht20_collect(i2c_inst_t *i2c, AHT20_Data *data, int length) {
+    if (!aht20_request(i2c, length)) {
+        return AHT20_RESULT_ERROR;
+    }
+    i2c_dma_wait(i2c);
+    return aht20_take_result(i2c, data);
+}
+
+aht20_result_t aht20_poll_result(i2c_inst_t *i2c, AHT20_Data *data) {
+    return aht20_collect(i2c, data, 6);
+}
+
+aht20_result_t aht20_poll_result_crc(i2c_inst_t *i2c, AHT20_Data *data) {
+    return aht20_collect(i2c, data, 7);
+}
+
+bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data) {
+    // Envia comando de medição
+    if (!aht20_start_measurement(i2c)) {
+        return false;
+    }
+
+    // Aguarda até o sensor estar pronto
+    sleep_ms(AHT20_MEASUREMENT_TIME_MS);
+    aht20_result_t result = aht20_poll_result(i2c, data);
+    for (int i = 0; i < 10 && result == AHT20_RESULT_BUSY; i++) {
+        sleep_ms(10);
+        result = aht20_poll_result(i2c, data);
+    }
+
+    return result == AHT20_RESULT_READY;
 }
 
 void aht20_reset(i2c_inst_t *i2c) {
     uint8_t reset_cmd = AHT20_CMD_RESET;
-    i2c_write_blocking(i2c, AHT20_I2C_ADDR, &reset_cmd, 1, false);
+    i2c_dma_write_read_blocking(i2c, AHT20_I2C_ADDR, &reset_cmd, 1, NULL, 0);
     sleep_ms(20);
     aht20_init(i2c);
 }
 
 bool aht20_check(i2c_inst_t *i2c) {
     uint8_t status;
-    return i2c_read_blocking(i2c, AHT20_I2C_ADDR, &status, 1, false) == 1;
+    return i2c_dma_write_read_blocking(i2c, AHT20_I2C_ADDR, NULL, 0, &status, 1);
 }
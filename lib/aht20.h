@@ -19,9 +19,41 @@ typedef struct {
 // Inicializa o sensor AHT20
 bool aht20_init(i2c_inst_t *i2c);
 
-// Faz a leitura de temperatura e umidade do AHT20
+// Tempo típico de conversão após o comando de medição (datasheet: 80 ms)
+#define AHT20_MEASUREMENT_TIME_MS 80
+
+// Resultado de aht20_poll_result
+typedef enum {
+    AHT20_RESULT_READY,     // Medição concluída, dados preenchidos
+    AHT20_RESULT_BUSY,      // Sensor ainda convertendo; consulte de novo mais tarde
+    AHT20_RESULT_ERROR,     // Falha de comunicação I2C
+    AHT20_RESULT_CRC_ERROR  // Dados recebidos não conferem com o CRC do sensor
+} aht20_result_t;
+
+// Faz a leitura de temperatura e umidade do AHT20 (bloqueia ~80 ms)
 bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data);
 
+// Dispara uma medição sem esperar o resultado
+bool aht20_start_measurement(i2c_inst_t *i2c);
+
+// Lê o resultado de uma medição disparada por aht20_start_measurement, sem bloquear
+aht20_result_t aht20_poll_result(i2c_inst_t *i2c, AHT20_Data *data);
+
+// Igual a aht20_poll_result, mas também lê o sétimo byte (CRC-8) e descarta leituras corrompidas
+aht20_result_t aht20_poll_result_crc(i2c_inst_t *i2c, AHT20_Data *data);
+
+// Inicia por DMA a leitura do resultado com CRC, sem esperar a transferência terminar
+bool aht20_request_result(i2c_inst_t *i2c);
+
+// Interpreta a leitura iniciada por aht20_request_result, depois que i2c_dma_busy(i2c) retornar false
+aht20_result_t aht20_take_result(i2c_inst_t *i2c, AHT20_Data *data);
+
+// Bytes brutos (status, dados e CRC) da última leitura iniciada por aht20_request_result
+const uint8_t *aht20_result_bytes(void);
+
+// Interpreta o status e os dados recebidos do sensor (length 6, ou 7 com o CRC-8 no último byte)
+aht20_result_t aht20_decode(const uint8_t *buffer, int length, AHT20_Data *data);
+
 // Reseta o sensor AHT20
 void aht20_reset(i2c_inst_t *i2c);
 
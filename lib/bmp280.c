@@ -1,104 +1,161 @@
 #include "bmp280.h"
+#include "pico/stdlib.h"
 #include "hardware/i2c.h"
+#include "i2c_dma.h"
 
 #define ADDR _u(0x76)
 
+// Configuração de um perfil: códigos de oversampling (osrs_t/osrs_p), filtro IIR e standby
+typedef struct {
+    uint8_t osrs_t;
+    uint8_t osrs_p;
+    uint8_t filter;
+    uint8_t t_sb;
+} bmp280_profile_config_t;
+
+// Códigos de oversampling: 1 = x1, 2 = x2, 3 = x4, 4 = x8, 5 = x16
+// Códigos do filtro: 0 = desligado, 2 = 4, 4 = 16. Standby: 0 = 0,5 ms, 4 = 500 ms
+static const bmp280_profile_config_t profiles[] = {
+    [BMP280_PROFILE_ULTRA_LOW_POWER]   = { .osrs_t = 1, .osrs_p = 1, .filter = 0, .t_sb = 4 },
+    [BMP280_PROFILE_STANDARD]          = { .osrs_t = 1, .osrs_p = 3, .filter = 2, .t_sb = 4 },
+    [BMP280_PROFILE_HIGH_RESOLUTION]   = { .osrs_t = 1, .osrs_p = 4, .filter = 2, .t_sb = 4 },
+    [BMP280_PROFILE_INDOOR_NAVIGATION] = { .osrs_t = 2, .osrs_p = 5, .filter = 4, .t_sb = 0 },
+};
+
+// ctrl_meas sem os bits de modo, e tempo de conversão do perfil em uso
+static uint8_t ctrl_meas_osrs = (0x01 << 5) | (0x03 << 2);
+static uint32_t measurement_time_us = 1250 + 2300 * 1 + 2300 * 4 + 575;
+
+// Registradores de pressão e temperatura lidos por DMA em bmp280_request_raw
+static uint8_t raw_buffer[6];
+
 void bmp280_init(i2c_inst_t *i2c) {
+    i2c_dma_init(i2c);
+
     uint8_t buf[2];
     const uint8_t reg_config_val = ((0x04 << 5) | (0x05 << 2)) & 0xFC;
     buf[0] = REG_CONFIG;
     buf[1] = reg_config_val;
    
-    i2c_write_blocking(i2c, ADDR, buf, 2, false);
+    i2c_dma_write_read_blocking(i2c, ADDR, buf, 2, NULL, 0);
 
     const uint8_t reg_ctrl_meas_val = (0x01 << 5) | (0x03 << 2) | (0x03);
     buf[0] = REG_CTRL_MEAS;
     buf[1] = reg_ctrl_meas_val;
-    i2c_write_blocking(i2c, ADDR, buf, 2, false);
+    i2c_dma_write_read_blocking(i2c, ADDR, buf, 2, NULL, 0);
  //   printf("Ctrl_meas register value: %x\n", reg_ctrl_meas_val);
 }
 
-void bmp280_read_raw(i2c_inst_t *i2c, int32_t* temp, int32_t* pressure) {
-    uint8_t buf[6];
+void bmp280_set_profile(i2c_inst_t *i2c, bmp280_profile_t profile, bmp280_mode_t mode) {
+    const bmp280_profile_config_t *config = &profiles[profile];
+    uint8_t buf[2];
+
+    // O registrador config só é garantido em modo sleep: desliga o sensor antes de escrevê-lo
+    buf[0] = REG_CTRL_MEAS;
+    buf[1] = BMP280_MODE_SLEEP;
+    i2c_dma_write_read_blocking(i2c, ADDR, buf, 2, NULL, 0);
+
+    buf[0] = REG_CONFIG;
+    buf[1] = ((config->t_sb << 5) | (config->filter << 2)) & 0xFC;
+    i2c_dma_write_read_blocking(i2c, ADDR, buf, 2, NULL, 0);
+
+    ctrl_meas_osrs = (config->osrs_t << 5) | (config->osrs_p << 2);
+
+    // t_measure,max = 1,25 + 2,3 * T_osr + (2,3 * P_osr + 0,575) ms, com T_osr/P_osr = 1, 2, 4, 8 ou 16
+    uint32_t t_osr = 1u << (config->osrs_t - 1);
+    uint32_t p_osr = 1u << (config->osrs_p - 1);
+    measurement_time_us = 1250 + 2300 * t_osr + 2300 * p_osr + 575;
+
+    // Em modo forçado a conversão só começa em bmp280_start_forced
+    if (mode == BMP280_MODE_NORMAL) {
+        buf[0] = REG_CTRL_MEAS;
+        buf[1] = ctrl_meas_osrs | BMP280_MODE_NORMAL;
+        i2c_dma_write_read_blocking(i2c, ADDR, buf, 2, NULL, 0);
+    }
+}
+
+uint32_t bmp280_measurement_time_us(void) {
+    return measurement_time_us;
+}
+
+bool bmp280_start_forced(i2c_inst_t *i2c) {
+    uint8_t buf[2] = { REG_CTRL_MEAS, ctrl_meas_osrs | BMP280_MODE_FORCED };
+    return i2c_dma_write_read_blocking(i2c, ADDR, buf, 2, NULL, 0);
+}
+
+bool bmp280_is_measuring(i2c_inst_t *i2c) {
+    uint8_t reg = REG_STATUS;
+    uint8_t status = 0;
+    i2c_dma_write_read_blocking(i2c, ADDR, &reg, 1, &status, 1);
+    return (status & 0x08) != 0;
+}
+
+bool bmp280_read_forced(i2c_inst_t *i2c, int32_t* temp, int32_t* pressure) {
+    if (!bmp280_start_forced(i2c)) {
+        return false;
+    }
+    sleep_us(measurement_time_us);
+    bmp280_read_raw(i2c, temp, pressure);
+    return true;
+}
+
+bool bmp280_request_raw(i2c_inst_t *i2c) {
     uint8_t reg = REG_PRESSURE_MSB;
-    i2c_write_blocking(i2c, ADDR, &reg, 1, true);
-    i2c_read_blocking(i2c, ADDR, buf, 6, false);
+    return i2c_dma_write_read(i2c, ADDR, &reg, 1, raw_buffer, sizeof(raw_buffer), NULL, NULL);
+}
+
+bool bmp280_take_raw(i2c_inst_t *i2c, int32_t* temp, int32_t* pressure) {
+    const uint8_t *buf = raw_buffer;
+    if (i2c_dma_status(i2c) != I2C_DMA_DONE) {
+        return false;
+    }
 
-    *pressure = (buf[0] << 12) | (buf[1] << 4) | (buf[2] >> 4);
-    *temp = (buf[3] << 12) | (buf[4] << 4) | (buf[5] >> 4);
+    bmp280_decode_raw(buf, temp, pressure);
+    return true;
+}
 
+const uint8_t *bmp280_raw_bytes(void) {
+    return raw_buffer;
+}
 
+void bmp280_read_raw(i2c_inst_t *i2c, int32_t* temp, int32_t* pressure) {
+    if (bmp280_request_raw(i2c)) {
+        i2c_dma_wait(i2c);
+    }
+    bmp280_take_raw(i2c, temp, pressure);
 }
 
 void bmp280_reset(i2c_inst_t *i2c) {
     uint8_t buf[2] = { REG_RESET, 0xB6 };
-    i2c_write_blocking(i2c, ADDR, buf, 2, false);
+    i2c_dma_write_read_blocking(i2c, ADDR, buf, 2, NULL, 0);
 }
 
 // função intermediária que calcula a temperatura de resolução fina
 // usada tanto para conversões de pressão quanto de temperatura
 int32_t bmp280_convert(int32_t temp, struct bmp280_calib_param* params) {
-    // usa os 32 bits de compensação de ponto fixo implementados no datasheet
-    int32_t var1, var2;
-    var1 = ((((temp >> 3) - ((int32_t)params->dig_t1 << 1))) * ((int32_t)params->dig_t2)) >> 11;
-    var2 = (((((temp >> 4) - ((int32_t)params->dig_t1)) * ((temp >> 4) - ((int32_t)params->dig_t1))) >> 12) * ((int32_t)params->dig_t3)) >> 14;
-    return var1 + var2;
+    return bmp280_compensate_t_fine(temp, params);
 }
 
+// Para ler temperatura e pressão juntas, prefira bmp280_compensate (calcula t_fine uma única vez)
 int32_t bmp280_convert_temp(int32_t temp, struct bmp280_calib_param* params) {
     // Utiliza os parâmetros de calibração do BMP280 para compensar o valor de temperatura lido de seus registradores
     int32_t t_fine = bmp280_convert(temp, params);
     return (t_fine * 5 + 128) >> 8;
 }
 
-
 int32_t bmp280_convert_pressure(int32_t pressure, int32_t temp, struct bmp280_calib_param* params) {
     // Utiliza os parâmetros de calibração do BMP280 para compensar o valor de pressão lido de seus registradores
-
     int32_t t_fine = bmp280_convert(temp, params);
+    return bmp280_compensate_pressure_32(pressure, t_fine, params);
+}
 
-    int32_t var1, var2;
-    uint32_t converted = 0.0;
-    var1 = (((int32_t)t_fine) >> 1) - (int32_t)64000;
-    var2 = (((var1 >> 2) * (var1 >> 2)) >> 11) * ((int32_t)params->dig_p6);
-    var2 += ((var1 * ((int32_t)params->dig_p5)) << 1);
-    var2 = (var2 >> 2) + (((int32_t)params->dig_p4) << 16);
-    var1 = (((params->dig_p3 * (((var1 >> 2) * (var1 >> 2)) >> 13)) >> 3) + ((((int32_t)params->dig_p2) * var1) >> 1)) >> 18;
-    var1 = ((((32768 + var1)) * ((int32_t)params->dig_p1)) >> 15);
-    if (var1 == 0) {
-        return 0;  // avoid exception caused by division by zero
-    }
-    converted = (((uint32_t)(((int32_t)1048576) - pressure) - (var2 >> 12))) * 3125;
-    if (converted < 0x80000000) {
-        converted = (converted << 1) / ((uint32_t)var1);
-    } else {
-        converted = (converted / (uint32_t)var1) * 2;
-    }
-    var1 = (((int32_t)params->dig_p9) * ((int32_t)(((converted >> 3) * (converted >> 3)) >> 13))) >> 12;
-    var2 = (((int32_t)(converted >> 2)) * ((int32_t)params->dig_p8)) >> 13;
-    converted = (uint32_t)((int32_t)converted + ((var1 + var2 + params->dig_p7) >> 4));
-    return converted;
+void bmp280_read_calib(i2c_inst_t *i2c, uint8_t buf[BMP280_CALIB_SIZE]) {
+    uint8_t reg = REG_DIG_T1_LSB;
+    i2c_dma_write_read_blocking(i2c, ADDR, &reg, 1, buf, BMP280_CALIB_SIZE);
 }
 
 void bmp280_get_calib_params(i2c_inst_t *i2c, struct bmp280_calib_param* params) {
     uint8_t buf[NUM_CALIB_PARAMS] = { 0 };
-    uint8_t reg = REG_DIG_T1_LSB;
-    i2c_write_blocking(i2c, ADDR, &reg, 1, true);
-    i2c_read_blocking(i2c, ADDR, buf, NUM_CALIB_PARAMS, false);
-
-    params->dig_t1 = (uint16_t)(buf[1] << 8) | buf[0];
-    params->dig_t2 = (int16_t)(buf[3] << 8) | buf[2];
-    params->dig_t3 = (int16_t)(buf[5] << 8) | buf[4];
-
-    params->dig_p1 = (uint16_t)(buf[7] << 8) | buf[6];
-    params->dig_p2 = (int16_t)(buf[9] << 8) | buf[8];
-    params->dig_p3 = (int16_t)(buf[11] << 8) | buf[10];
-    params->dig_p4 = (int16_t)(buf[13] << 8) | buf[12];
-    params->dig_p5 = (int16_t)(buf[15] << 8) | buf[14];
-    params->dig_p6 = (int16_t)(buf[17] << 8) | buf[16];
-    params->dig_p7 = (int16_t)(buf[19] << 8) | buf[18];
-    params->dig_p8 = (int16_t)(buf[21] << 8) | buf[20];
-    params->dig_p9 = (int16_t)(buf[23] << 8) | buf[22];
-
-
+    bmp280_read_calib(i2c, buf);
+    bmp280_decode_calib(buf, params);
 }
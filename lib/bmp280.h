@@ -2,12 +2,14 @@
 #define BMP280_H
 
 #include "hardware/i2c.h"
+#include "bmp280_compensation.h"
 
 // Defina os endereços e registros conforme o código original
 #define ADDR _u(0x76)
 
 #define REG_CONFIG _u(0xF5)
 #define REG_CTRL_MEAS _u(0xF4)
+#define REG_STATUS _u(0xF3)
 #define REG_RESET _u(0xE0)
 
 #define REG_TEMP_XLSB _u(0xFC)
@@ -45,28 +47,56 @@
 
 #define NUM_CALIB_PARAMS 24
 
-struct bmp280_calib_param {
-    uint16_t dig_t1;
-    int16_t dig_t2;
-    int16_t dig_t3;
-
-    uint16_t dig_p1;
-    int16_t dig_p2;
-    int16_t dig_p3;
-    int16_t dig_p4;
-    int16_t dig_p5;
-    int16_t dig_p6;
-    int16_t dig_p7;
-    int16_t dig_p8;
-    int16_t dig_p9;
-};
+// Modo de operação (bits mode de ctrl_meas)
+typedef enum {
+    BMP280_MODE_SLEEP = 0x00,
+    BMP280_MODE_FORCED = 0x01,  // Uma conversão por disparo; o sensor volta a dormir em seguida
+    BMP280_MODE_NORMAL = 0x03   // Conversões contínuas, separadas pelo tempo de standby
+} bmp280_mode_t;
+
+// Perfis de oversampling/filtro IIR recomendados no datasheet (seção 3.4)
+typedef enum {
+    BMP280_PROFILE_ULTRA_LOW_POWER,     // Temp x1, pressão x1, sem filtro (monitoramento do tempo)
+    BMP280_PROFILE_STANDARD,            // Temp x1, pressão x4, filtro 4
+    BMP280_PROFILE_HIGH_RESOLUTION,     // Temp x1, pressão x8, filtro 4
+    BMP280_PROFILE_INDOOR_NAVIGATION    // Temp x2, pressão x16, filtro 16
+} bmp280_profile_t;
 
 //void bmp280_init(void);
 void bmp280_init(i2c_inst_t *i2c);
+
+// Configura oversampling e filtro conforme o perfil e coloca o sensor no modo indicado
+void bmp280_set_profile(i2c_inst_t *i2c, bmp280_profile_t profile, bmp280_mode_t mode);
+
+// Tempo máximo de uma conversão, em microssegundos, para o perfil configurado (datasheet, seção 3.8.1)
+uint32_t bmp280_measurement_time_us(void);
+
+// Dispara uma conversão em modo forçado; o resultado pode ser lido após bmp280_measurement_time_us()
+bool bmp280_start_forced(i2c_inst_t *i2c);
+
+// Indica se o sensor ainda está convertendo (bit measuring do registrador de status)
+bool bmp280_is_measuring(i2c_inst_t *i2c);
+
+// Dispara uma conversão forçada, aguarda o tempo de conversão e lê os valores brutos
+bool bmp280_read_forced(i2c_inst_t *i2c, int32_t* temp, int32_t* pressure);
+
+// Inicia por DMA a leitura dos registradores de pressão e temperatura, sem esperar a transferência
+bool bmp280_request_raw(i2c_inst_t *i2c);
+
+// Converte a leitura iniciada por bmp280_request_raw, depois que i2c_dma_busy(i2c) retornar false;
+// retorna false se a transferência falhou
+bool bmp280_take_raw(i2c_inst_t *i2c, int32_t* temp, int32_t* pressure);
+
+// Bytes brutos (registradores 0xF7..0xFC) da última leitura iniciada por bmp280_request_raw
+const uint8_t *bmp280_raw_bytes(void);
+
 void bmp280_read_raw(i2c_inst_t *i2c, int32_t* temp, int32_t* pressure);
 void bmp280_reset(i2c_inst_t *i2c);
 int32_t bmp280_convert_temp(int32_t temp, struct bmp280_calib_param* params);
 int32_t bmp280_convert_pressure(int32_t pressure, int32_t temp, struct bmp280_calib_param* params);
 void bmp280_get_calib_params(i2c_inst_t *i2c, struct bmp280_calib_param* params);
 
+// Lê os registradores de calibração sem interpretá-los (ver bmp280_decode_calib)
+void bmp280_read_calib(i2c_inst_t *i2c, uint8_t buf[BMP280_CALIB_SIZE]);
+
 #endif
@@ -0,0 +1,116 @@
+#include "bmp280_compensation.h"
+
+// Fórmulas de compensação do datasheet do BMP280 (seção 3.11.3 e apêndice 8). Os deslocamentos à
+// esquerda de valores que podem ser negativos foram escritos como multiplicações, com o mesmo resultado.
+
+void bmp280_decode_calib(const uint8_t buf[BMP280_CALIB_SIZE], struct bmp280_calib_param *params) {
+    params->dig_t1 = (uint16_t)(buf[1] << 8) | buf[0];
+    params->dig_t2 = (int16_t)(buf[3] << 8) | buf[2];
+    params->dig_t3 = (int16_t)(buf[5] << 8) | buf[4];
+
+    params->dig_p1 = (uint16_t)(buf[7] << 8) | buf[6];
+    params->dig_p2 = (int16_t)(buf[9] << 8) | buf[8];
+    params->dig_p3 = (int16_t)(buf[11] << 8) | buf[10];
+    params->dig_p4 = (int16_t)(buf[13] << 8) | buf[12];
+    params->dig_p5 = (int16_t)(buf[15] << 8) | buf[14];
+    params->dig_p6 = (int16_t)(buf[17] << 8) | buf[16];
+    params->dig_p7 = (int16_t)(buf[19] << 8) | buf[18];
+    params->dig_p8 = (int16_t)(buf[21] << 8) | buf[20];
+    params->dig_p9 = (int16_t)(buf[23] << 8) | buf[22];
+}
+
+void bmp280_decode_raw(const uint8_t buf[BMP280_RAW_SIZE], int32_t *temp, int32_t *pressure) {
+    *pressure = (buf[0] << 12) | (buf[1] << 4) | (buf[2] >> 4);
+    *temp = (buf[3] << 12) | (buf[4] << 4) | (buf[5] >> 4);
+}
+
+int32_t bmp280_compensate_t_fine(int32_t raw_t, const struct bmp280_calib_param *params) {
+    // usa os 32 bits de compensação de ponto fixo implementados no datasheet
+    int32_t var1, var2;
+    var1 = ((((raw_t >> 3) - ((int32_t)params->dig_t1 << 1))) * ((int32_t)params->dig_t2)) >> 11;
+    var2 = (((((raw_t >> 4) - ((int32_t)params->dig_t1)) * ((raw_t >> 4) - ((int32_t)params->dig_t1))) >> 12) * ((int32_t)params->dig_t3)) >> 14;
+    return var1 + var2;
+}
+
+uint32_t bmp280_compensate_pressure_32(int32_t raw_p, int32_t t_fine, const struct bmp280_calib_param *params) {
+    int32_t var1, var2;
+    uint32_t converted;
+    var1 = (((int32_t)t_fine) >> 1) - (int32_t)64000;
+    var2 = (((var1 >> 2) * (var1 >> 2)) >> 11) * ((int32_t)params->dig_p6);
+    var2 += ((var1 * ((int32_t)params->dig_p5)) * 2);
+    var2 = (var2 >> 2) + (((int32_t)params->dig_p4) * 65536);
+    var1 = (((params->dig_p3 * (((var1 >> 2) * (var1 >> 2)) >> 13)) >> 3) + ((((int32_t)params->dig_p2) * var1) >> 1)) >> 18;
+    var1 = ((((32768 + var1)) * ((int32_t)params->dig_p1)) >> 15);
+    if (var1 == 0) {
+        return 0;  // evita divisão por zero
+    }
+    converted = (((uint32_t)(((int32_t)1048576) - raw_p) - (var2 >> 12))) * 3125;
+    if (converted < 0x80000000) {
+        converted = (converted << 1) / ((uint32_t)var1);
+    } else {
+        converted = (converted / (uint32_t)var1) * 2;
+    }
+    var1 = (((int32_t)params->dig_p9) * ((int32_t)(((converted >> 3) * (converted >> 3)) >> 13))) >> 12;
+    var2 = (((int32_t)(converted >> 2)) * ((int32_t)params->dig_p8)) >> 13;
+    converted = (uint32_t)((int32_t)converted + ((var1 + var2 + params->dig_p7) >> 4));
+    return converted;
+}
+
+uint32_t bmp280_compensate_pressure_64(int32_t raw_p, int32_t t_fine, const struct bmp280_calib_param *params) {
+    int64_t var1, var2, p;
+    var1 = ((int64_t)t_fine) - 128000;
+    var2 = var1 * var1 * (int64_t)params->dig_p6;
+    var2 = var2 + ((var1 * (int64_t)params->dig_p5) * ((int64_t)1 << 17));
+    var2 = var2 + (((int64_t)params->dig_p4) * ((int64_t)1 << 35));
+    var1 = ((var1 * var1 * (int64_t)params->dig_p3) >> 8) + ((var1 * (int64_t)params->dig_p2) * ((int64_t)1 << 12));
+    var1 = ((((int64_t)1 << 47) + var1) * ((int64_t)params->dig_p1)) >> 33;
+    if (var1 == 0) {
+        return 0;  // evita divisão por zero
+    }
+    p = 1048576 - raw_p;
+    p = ((p * ((int64_t)1 << 31)) - var2) * 3125 / var1;
+    var1 = (((int64_t)params->dig_p9) * (p >> 13) * (p >> 13)) >> 25;
+    var2 = (((int64_t)params->dig_p8) * p) >> 19;
+    p = ((p + var1 + var2) >> 8) + (((int64_t)params->dig_p7) * 16);
+    return (uint32_t)p;
+}
+
+void bmp280_compensate(int32_t raw_t, int32_t raw_p, const struct bmp280_calib_param *params, bmp280_reading_t *out) {
+    out->t_fine = bmp280_compensate_t_fine(raw_t, params);
+    out->temperature = (out->t_fine * 5 + 128) >> 8;
+    out->pressure = bmp280_compensate_pressure_32(raw_p, out->t_fine, params);
+    out->pressure_q24_8 = out->pressure << 8;
+}
+
+void bmp280_compensate_64(int32_t raw_t, int32_t raw_p, const struct bmp280_calib_param *params, bmp280_reading_t *out) {
+    out->t_fine = bmp280_compensate_t_fine(raw_t, params);
+    out->temperature = (out->t_fine * 5 + 128) >> 8;
+    out->pressure_q24_8 = bmp280_compensate_pressure_64(raw_p, out->t_fine, params);
+    out->pressure = (out->pressure_q24_8 + 128) >> 8;
+}
+
+void bmp280_compensate_float(int32_t raw_t, int32_t raw_p, const struct bmp280_calib_param *params,
+                             double *temperature, double *pressure) {
+    double var1, var2, p;
+    var1 = (((double)raw_t) / 16384.0 - ((double)params->dig_t1) / 1024.0) * ((double)params->dig_t2);
+    var2 = ((((double)raw_t) / 131072.0 - ((double)params->dig_t1) / 8192.0) *
+            (((double)raw_t) / 131072.0 - ((double)params->dig_t1) / 8192.0)) * ((double)params->dig_t3);
+    int32_t t_fine = (int32_t)(var1 + var2);
+    *temperature = (var1 + var2) / 5120.0;
+
+    var1 = ((double)t_fine / 2.0) - 64000.0;
+    var2 = var1 * var1 * ((double)params->dig_p6) / 32768.0;
+    var2 = var2 + var1 * ((double)params->dig_p5) * 2.0;
+    var2 = (var2 / 4.0) + (((double)params->dig_p4) * 65536.0);
+    var1 = (((double)params->dig_p3) * var1 * var1 / 524288.0 + ((double)params->dig_p2) * var1) / 524288.0;
+    var1 = (1.0 + var1 / 32768.0) * ((double)params->dig_p1);
+    if (var1 == 0.0) {
+        *pressure = 0.0;  // evita divisão por zero
+        return;
+    }
+    p = 1048576.0 - (double)raw_p;
+    p = (p - (var2 / 4096.0)) * 6250.0 / var1;
+    var1 = ((double)params->dig_p9) * p * p / 2147483648.0;
+    var2 = p * ((double)params->dig_p8) / 32768.0;
+    *pressure = p + (var1 + var2 + ((double)params->dig_p7)) / 16.0;
+}
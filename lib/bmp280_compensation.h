@@ -0,0 +1,59 @@
+#ifndef BMP280_COMPENSATION_H
+#define BMP280_COMPENSATION_H
+
+#include <stdint.h>
+
+// Compensação das leituras brutas do BMP280 (datasheet, seção 3.11). Não depende do SDK do Pico,
+// para poder ser compilada e medida no computador (ver bench/).
+
+struct bmp280_calib_param {
+    uint16_t dig_t1;
+    int16_t dig_t2;
+    int16_t dig_t3;
+
+    uint16_t dig_p1;
+    int16_t dig_p2;
+    int16_t dig_p3;
+    int16_t dig_p4;
+    int16_t dig_p5;
+    int16_t dig_p6;
+    int16_t dig_p7;
+    int16_t dig_p8;
+    int16_t dig_p9;
+};
+
+// Bytes da calibração (registradores 0x88..0x9F) e dos valores brutos (0xF7..0xFC)
+#define BMP280_CALIB_SIZE 24
+#define BMP280_RAW_SIZE 6
+
+// Resultado de uma compensação completa
+typedef struct {
+    int32_t t_fine;           // Temperatura de resolução fina, usada na compensação da pressão
+    int32_t temperature;      // Temperatura em centésimos de °C (2508 = 25,08 °C)
+    uint32_t pressure;        // Pressão em Pa
+    uint32_t pressure_q24_8;  // Pressão em Pa no formato Q24.8 (25767233 = 100653,25 Pa)
+} bmp280_reading_t;
+
+// Calcula t_fine, temperatura e pressão em uma única passada, com a fórmula de 32 bits do datasheet.
+// A pressão tem resolução de 1 Pa; pressure_q24_8 recebe o mesmo valor multiplicado por 256.
+void bmp280_compensate(int32_t raw_t, int32_t raw_p, const struct bmp280_calib_param *params, bmp280_reading_t *out);
+
+// Igual a bmp280_compensate, mas com a fórmula de 64 bits do datasheet para a pressão (resolução de 1/256 Pa)
+void bmp280_compensate_64(int32_t raw_t, int32_t raw_p, const struct bmp280_calib_param *params, bmp280_reading_t *out);
+
+// Fórmula em ponto flutuante (double) do datasheet. Usada como referência; no RP2040 não há FPU.
+void bmp280_compensate_float(int32_t raw_t, int32_t raw_p, const struct bmp280_calib_param *params,
+                             double *temperature, double *pressure);
+
+// Interpreta os bytes lidos dos registradores de calibração (little-endian, na ordem do datasheet)
+void bmp280_decode_calib(const uint8_t buf[BMP280_CALIB_SIZE], struct bmp280_calib_param *params);
+
+// Interpreta os registradores de pressão e temperatura (20 bits cada, alinhados à esquerda)
+void bmp280_decode_raw(const uint8_t buf[BMP280_RAW_SIZE], int32_t *temp, int32_t *pressure);
+
+// Partes da compensação, para quem já tem t_fine
+int32_t bmp280_compensate_t_fine(int32_t raw_t, const struct bmp280_calib_param *params);
+uint32_t bmp280_compensate_pressure_32(int32_t raw_p, int32_t t_fine, const struct bmp280_calib_param *params);
+uint32_t bmp280_compensate_pressure_64(int32_t raw_p, int32_t t_fine, const struct bmp280_calib_param *params);
+
+#endif
@@ -0,0 +1,250 @@
+#include <string.h>
+#include "config_store.h"
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "pico/flash.h"
+
+#define CONFIG_STORE_MAGIC 0x47464E43u  // "CNFG"
+#define CONFIG_STORE_ERASED_KEY 0xFFFF
+
+// Tempo máximo para pausar o outro núcleo antes de gravar
+#define CONFIG_STORE_LOCKOUT_TIMEOUT_MS 100
+
+typedef struct {
+    uint32_t magic;
+    uint32_t generation;
+} config_store_header_t;
+
+typedef struct {
+    uint16_t key;
+    uint16_t length;
+    uint32_t crc;  // CRC-32 da chave, do tamanho e do valor
+} config_store_record_t;
+
+// Registro completo, com o valor alinhado a 4 bytes
+#define CONFIG_STORE_RECORD_SIZE(length) (sizeof(config_store_record_t) + (((length) + 3u) & ~3u))
+
+// Operação executada com o outro núcleo pausado
+typedef struct {
+    uint32_t offset;
+    bool erase;             // Apaga o setor que contém offset antes de gravar
+    const uint8_t *data;    // Páginas a gravar (NULL: nenhuma)
+    uint32_t length;        // Múltiplo de FLASH_PAGE_SIZE
+} config_store_write_t;
+
+static uint32_t config_store_crc(uint32_t crc, const void *data, uint32_t length) {
+    const uint8_t *bytes = data;
+    crc = ~crc;
+    for (uint32_t i = 0; i < length; i++) {
+        crc ^= bytes[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+static uint32_t config_store_record_crc(uint16_t key, uint16_t length, const void *value) {
+    uint16_t fields[2] = {key, length};
+    return config_store_crc(config_store_crc(0, fields, sizeof(fields)), value, length);
+}
+
+static const uint8_t *config_store_sector(const config_store_t *store, uint8_t sector) {
+    return (const uint8_t *)(XIP_BASE + store->offset + sector * FLASH_SECTOR_SIZE);
+}
+
+static void config_store_apply(void *param) {
+    const config_store_write_t *write = (const config_store_write_t *)param;
+    if (write->erase) {
+        flash_range_erase(write->offset & ~(FLASH_SECTOR_SIZE - 1), FLASH_SECTOR_SIZE);
+    }
+    if (write->data != NULL) {
+        flash_range_program(write->offset, write->data, write->length);
+    }
+}
+
+static bool config_store_flash(uint32_t offset, bool erase, const uint8_t *data, uint32_t length) {
+    config_store_write_t write = {.offset = offset, .erase = erase, .data = data, .length = length};
+    return flash_safe_execute(config_store_apply, &write, CONFIG_STORE_LOCKOUT_TIMEOUT_MS) == PICO_OK;
+}
+
+// Percorre os registros de um setor: devolve o registro em *offset e avança para o próximo. Retorna
+// false no fim do log (espaço apagado) ou em um registro com tamanho impossível.
+static bool config_store_next(const uint8_t *sector, uint16_t *offset, const config_store_record_t **record) {
+    if (*offset + sizeof(config_store_record_t) > FLASH_SECTOR_SIZE) {
+        return false;
+    }
+    const config_store_record_t *current = (const config_store_record_t *)(sector + *offset);
+    if (current->key == CONFIG_STORE_ERASED_KEY || current->length > CONFIG_STORE_MAX_VALUE ||
+        *offset + CONFIG_STORE_RECORD_SIZE(current->length) > FLASH_SECTOR_SIZE) {
+        return false;
+    }
+    *record = current;
+    *offset += CONFIG_STORE_RECORD_SIZE(current->length);
+    return true;
+}
+
+static bool config_store_record_valid(const config_store_record_t *record) {
+    return record->crc == config_store_record_crc(record->key, record->length, record + 1);
+}
+
+// Último registro válido da chave no setor ativo (NULL se não houver)
+static const config_store_record_t *config_store_find(const config_store_t *store, uint16_t key) {
+    if (store->end == 0) {
+        return NULL;
+    }
+    const uint8_t *sector = config_store_sector(store, store->active);
+    const config_store_record_t *found = NULL;
+    const config_store_record_t *record;
+    uint16_t offset = sizeof(config_store_header_t);
+    while (config_store_next(sector, &offset, &record)) {
+        if (record->key == key && config_store_record_valid(record)) {
+            found = record;
+        }
+    }
+    return found;
+}
+
+// Prepara o setor como ativo e vazio, com a geração indicada
+static bool config_store_format(config_store_t *store, uint8_t sector, uint32_t generation) {
+    static uint8_t page[FLASH_PAGE_SIZE];
+    memset(page, 0xFF, sizeof(page));
+    config_store_header_t header = {.magic = CONFIG_STORE_MAGIC, .generation = generation};
+    memcpy(page, &header, sizeof(header));
+    if (!config_store_flash(store->offset + sector * FLASH_SECTOR_SIZE, true, page, sizeof(page))) {
+        return false;
+    }
+    store->active = sector;
+    store->generation = generation;
+    store->end = sizeof(config_store_header_t);
+    return true;
+}
+
+void config_store_init(config_store_t *store, uint32_t offset) {
+    store->offset = offset;
+
+    // O setor ativo é o de maior geração entre os que têm cabeçalho válido
+    bool found = false;
+    for (uint8_t sector = 0; sector < CONFIG_STORE_SECTORS; sector++) {
+        const config_store_header_t *header = (const config_store_header_t *)config_store_sector(store, sector);
+        if (header->magic == CONFIG_STORE_MAGIC && (!found || (int32_t)(header->generation - store->generation) > 0)) {
+            store->active = sector;
+            store->generation = header->generation;
+            found = true;
+        }
+    }
+    if (!found) {
+        // Nada gravado ainda; o setor 0 é preparado na primeira gravação, e não aqui, porque o
+        // outro núcleo talvez ainda não possa ser pausado
+        store->active = 0;
+        store->generation = 0;
+        store->end = 0;
+        return;
+    }
+
+    // Fim do log: primeiro espaço apagado. Um registro com tamanho impossível (gravação interrompida)
+    // também encerra o log; o restante do setor fica inutilizado até a próxima compactação.
+    const uint8_t *sector = config_store_sector(store, store->active);
+    const config_store_record_t *record;
+    uint16_t end = sizeof(config_store_header_t);
+    while (config_store_next(sector, &end, &record)) {
+    }
+    const config_store_record_t *stop = (const config_store_record_t *)(sector + end);
+    bool erased = end + sizeof(config_store_record_t) <= FLASH_SECTOR_SIZE && stop->key == CONFIG_STORE_ERASED_KEY;
+    store->end = erased || end == FLASH_SECTOR_SIZE ? end : FLASH_SECTOR_SIZE;
+}
+
+int config_store_get(const config_store_t *store, uint16_t key, void *value, uint16_t size) {
+    const config_store_record_t *record = config_store_find(store, key);
+    if (record == NULL) {
+        return -1;
+    }
+    memcpy(value, record + 1, record->length < size ? record->length : size);
+    return record->length;
+}
+
+// Codifica um registro em out (a imagem de um setor, ou das páginas que o registro ocupa)
+static void config_store_encode(uint8_t *out, uint16_t key, const void *value, uint16_t length) {
+    config_store_record_t record = {
+        .key = key,
+        .length = length,
+        .crc = config_store_record_crc(key, length, value),
+    };
+    memcpy(out, &record, sizeof(record));
+    memcpy(out + sizeof(record), value, length);
+}
+
+// Copia o último valor de cada chave (trocando o de 'key' pelo novo) para o outro setor e o torna ativo
+static bool config_store_compact(config_store_t *store, uint16_t key, const void *value, uint16_t length) {
+    static uint8_t image[FLASH_SECTOR_SIZE];
+    memset(image, 0xFF, sizeof(image));
+    uint16_t end = sizeof(config_store_header_t);
+
+    const uint8_t *sector = config_store_sector(store, store->active);
+    const config_store_record_t *record;
+    uint16_t offset = sizeof(config_store_header_t);
+    while (config_store_next(sector, &offset, &record)) {
+        if (record->key == key || !config_store_record_valid(record) || config_store_find(store, record->key) != record) {
+            continue;
+        }
+        config_store_encode(image + end, record->key, record + 1, record->length);
+        end += CONFIG_STORE_RECORD_SIZE(record->length);
+    }
+    if (end + CONFIG_STORE_RECORD_SIZE(length) > FLASH_SECTOR_SIZE) {
+        return false;
+    }
+    config_store_encode(image + end, key, value, length);
+    end += CONFIG_STORE_RECORD_SIZE(length);
+
+    // Grava os registros com o cabeçalho ainda apagado e só então o cabeçalho, que valida o setor
+    uint8_t target = store->active ^ 1;
+    uint32_t target_offset = store->offset + target * FLASH_SECTOR_SIZE;
+    uint32_t pages = ((uint32_t)end + FLASH_PAGE_SIZE - 1) & ~(FLASH_PAGE_SIZE - 1);
+    if (!config_store_flash(target_offset, true, image, pages)) {
+        return false;
+    }
+    memset(image, 0xFF, FLASH_PAGE_SIZE);
+    config_store_header_t header = {.magic = CONFIG_STORE_MAGIC, .generation = store->generation + 1};
+    memcpy(image, &header, sizeof(header));
+    if (!config_store_flash(target_offset, false, image, FLASH_PAGE_SIZE)) {
+        return false;
+    }
+
+    store->active = target;
+    store->generation = header.generation;
+    store->end = end;
+    return true;
+}
+
+bool config_store_set(config_store_t *store, uint16_t key, const void *value, uint16_t length) {
+    if (key == CONFIG_STORE_ERASED_KEY || length > CONFIG_STORE_MAX_VALUE) {
+        return false;
+    }
+
+    if (store->end == 0 && !config_store_format(store, 0, 0)) {
+        return false;
+    }
+
+    const config_store_record_t *current = config_store_find(store, key);
+    if (current != NULL && current->length == length && memcmp(current + 1, value, length) == 0) {
+        return true;
+    }
+
+    uint32_t size = CONFIG_STORE_RECORD_SIZE(length);
+    if (store->end + size > FLASH_SECTOR_SIZE) {
+        return config_store_compact(store, key, value, length);
+    }
+
+    // Grava só as páginas que o registro ocupa; o resto delas fica em 0xFF, o que não altera a flash
+    static uint8_t pages[FLASH_PAGE_SIZE + CONFIG_STORE_RECORD_SIZE(CONFIG_STORE_MAX_VALUE) + FLASH_PAGE_SIZE];
+    uint32_t first = store->end & ~(FLASH_PAGE_SIZE - 1);
+    uint32_t last = (store->end + size + FLASH_PAGE_SIZE - 1) & ~(FLASH_PAGE_SIZE - 1);
+    memset(pages, 0xFF, last - first);
+    config_store_encode(pages + (store->end - first), key, value, length);
+    if (!config_store_flash(store->offset + store->active * FLASH_SECTOR_SIZE + first, false, pages, last - first)) {
+        return false;
+    }
+
+    store->end += size;
+    return true;
+}
@@ -0,0 +1,37 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Armazenamento chave/valor em dois setores da flash, estruturado como log. Cada gravação acrescenta um
+// registro (chave, tamanho, CRC-32 e valor) ao setor ativo, sem apagar nada; a leitura usa o último
+// registro válido da chave. Quando o setor ativo enche, o último valor de cada chave é copiado para o
+// outro setor, que passa a ser o ativo (ping-pong). Assim, cada setor só é apagado depois de receber
+// dezenas de gravações. O cabeçalho do setor novo é gravado por último, então uma queda de energia
+// durante a compactação mantém o setor antigo como ativo.
+
+// Setores ocupados pelo armazenamento
+#define CONFIG_STORE_SECTORS 2
+
+// Maior valor aceito, em bytes
+#define CONFIG_STORE_MAX_VALUE 256
+
+typedef struct {
+    uint32_t offset;      // Início dos dois setores, a partir do começo da flash
+    uint8_t active;       // Setor ativo (0 ou 1)
+    uint32_t generation;  // Geração do setor ativo; cresce a cada compactação
+    uint16_t end;         // Próximo byte livre do setor ativo (0: nenhum setor preparado ainda)
+} config_store_t;
+
+// Escolhe o setor ativo e encontra o fim do log. Só lê a flash; pode ser chamada antes de o outro núcleo iniciar.
+void config_store_init(config_store_t *store, uint32_t offset);
+
+// Copia o valor da chave para value (até size bytes); retorna o tamanho guardado ou -1 se a chave não existe
+int config_store_get(const config_store_t *store, uint16_t key, void *value, uint16_t size);
+
+// Grava um novo valor para a chave, compactando se necessário. Não grava nada se o valor não mudou.
+// Pausa o outro núcleo durante a gravação (flash_safe_execute).
+bool config_store_set(config_store_t *store, uint16_t key, const void *value, uint16_t length);
+
+#endif
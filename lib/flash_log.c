@@ -0,0 +1,309 @@
+#include <string.h>
+#include "flash_log.h"
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "pico/flash.h"
+
+#define FLASH_LOG_MAGIC 0x474C5354u  // "TSLG"
+
+// Maior registro codificado: instante e valores com 5 bytes de varint cada
+#define FLASH_LOG_MAX_RECORD (5 * (1 + FLASH_LOG_QUANTITIES))
+
+// Espaço para registros em um bloco
+#define FLASH_LOG_PAYLOAD_SIZE ((uint16_t)(FLASH_LOG_BLOCK_SIZE - sizeof(flash_log_header_t)))
+
+// Tempo máximo para pausar o outro núcleo antes de gravar
+#define FLASH_LOG_LOCKOUT_TIMEOUT_MS 100
+
+_Static_assert(FLASH_LOG_BLOCK_SIZE == FLASH_SECTOR_SIZE, "cada bloco ocupa exatamente um setor");
+
+static uint32_t flash_log_crc(uint32_t crc, const uint8_t *data, uint32_t length) {
+    crc = ~crc;
+    for (uint32_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+static uint32_t flash_log_block_crc(const uint8_t *block) {
+    flash_log_header_t header;
+    memcpy(&header, block, sizeof(header));
+    header.crc = 0;
+    uint32_t crc = flash_log_crc(0, (const uint8_t *)&header, sizeof(header));
+    return flash_log_crc(crc, block + sizeof(header), header.length);
+}
+
+static bool flash_log_header_valid(const flash_log_header_t *header) {
+    return header->magic == FLASH_LOG_MAGIC && header->length <= FLASH_LOG_PAYLOAD_SIZE;
+}
+
+// Conteúdo de um setor da região, lido direto pela XIP
+static const uint8_t *flash_log_sector(const flash_log_t *log, uint32_t sequence) {
+    return (const uint8_t *)(XIP_BASE + log->offset + (sequence % log->sectors) * FLASH_LOG_BLOCK_SIZE);
+}
+
+static uint32_t flash_log_zigzag(uint32_t value) {
+    return (value << 1) ^ (0u - (value >> 31));
+}
+
+static uint32_t flash_log_unzigzag(uint32_t value) {
+    return (value >> 1) ^ (0u - (value & 1));
+}
+
+static uint8_t *flash_log_put_varint(uint8_t *out, uint32_t value) {
+    while (value >= 0x80) {
+        *out++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (uint8_t)value;
+    return out;
+}
+
+// Lê um varint de data[*offset..length); retorna false se ele estiver truncado
+static bool flash_log_get_varint(const uint8_t *data, uint16_t length, uint16_t *offset, uint32_t *value) {
+    uint32_t result = 0;
+    for (int shift = 0; shift < 35 && *offset < length; shift += 7) {
+        uint8_t byte = data[(*offset)++];
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Sequência do bloco em preenchimento na RAM
+static uint32_t flash_log_active_sequence(const flash_log_t *log) {
+    return log->next_sequence + (log->pending ? 1 : 0);
+}
+
+// Começa um bloco vazio no buffer ativo
+static void flash_log_start_block(flash_log_t *log) {
+    uint8_t *block = log->blocks[log->active];
+    memset(block, 0xFF, FLASH_LOG_BLOCK_SIZE);
+
+    flash_log_header_t header = {
+        .magic = FLASH_LOG_MAGIC,
+        .sequence = flash_log_active_sequence(log),
+        .boot = log->boot,
+        .count = 0,
+        .length = 0,
+        .reserved = 0xFFFF,
+        .crc = 0,
+    };
+    memcpy(block, &header, sizeof(header));
+
+    log->last_timestamp_ms = 0;
+    log->last_delta_ms = 0;
+    memset(log->last_values, 0, sizeof(log->last_values));
+}
+
+void flash_log_init(flash_log_t *log, uint32_t offset, uint16_t sectors) {
+    log->offset = offset;
+    log->sectors = sectors;
+    log->dropped = 0;
+    log->active = 0;
+    log->pending = false;
+
+    // O bloco mais recente é o de maior sequência que esteja no setor certo e com CRC válido
+    bool found = false;
+    uint32_t last_sequence = 0;
+    uint16_t last_boot = 0;
+    for (uint16_t i = 0; i < sectors; i++) {
+        const uint8_t *block = (const uint8_t *)(XIP_BASE + offset + i * FLASH_LOG_BLOCK_SIZE);
+        const flash_log_header_t *header = (const flash_log_header_t *)block;
+        if (!flash_log_header_valid(header) || header->sequence % sectors != i ||
+            header->crc != flash_log_block_crc(block)) {
+            continue;
+        }
+        if (!found || header->sequence > last_sequence) {
+            last_sequence = header->sequence;
+        }
+        if (!found || (int16_t)(header->boot - last_boot) > 0) {
+            last_boot = header->boot;
+        }
+        found = true;
+    }
+
+    log->next_sequence = found ? last_sequence + 1 : 0;
+    log->boot = found ? (uint16_t)(last_boot + 1) : 0;
+    flash_log_start_block(log);
+}
+
+// Fecha o bloco ativo, que passa a aguardar gravação, e começa outro
+static void flash_log_seal(flash_log_t *log) {
+    uint8_t *block = log->blocks[log->active];
+    flash_log_header_t *header = (flash_log_header_t *)block;
+    header->crc = flash_log_block_crc(block);
+
+    log->pending = true;
+    log->active ^= 1;
+    flash_log_start_block(log);
+}
+
+bool flash_log_append(flash_log_t *log, uint32_t timestamp_ms, const int32_t values[FLASH_LOG_QUANTITIES]) {
+    flash_log_header_t *header = (flash_log_header_t *)log->blocks[log->active];
+    if (header->length + FLASH_LOG_MAX_RECORD > FLASH_LOG_PAYLOAD_SIZE) {
+        if (log->pending) {
+            log->dropped++;
+            return false;
+        }
+        flash_log_seal(log);
+        header = (flash_log_header_t *)log->blocks[log->active];
+    }
+
+    // No primeiro registro do bloco, as referências são zero e os valores saem inteiros
+    uint8_t *out = log->blocks[log->active] + sizeof(flash_log_header_t) + header->length;
+    uint8_t *start = out;
+    uint32_t delta = timestamp_ms - log->last_timestamp_ms;
+    out = flash_log_put_varint(out, flash_log_zigzag(delta - (uint32_t)log->last_delta_ms));
+    for (int i = 0; i < FLASH_LOG_QUANTITIES; i++) {
+        out = flash_log_put_varint(out, flash_log_zigzag((uint32_t)values[i] - (uint32_t)log->last_values[i]));
+        log->last_values[i] = values[i];
+    }
+    log->last_timestamp_ms = timestamp_ms;
+    log->last_delta_ms = (int32_t)delta;
+
+    header->length += (uint16_t)(out - start);
+    header->count++;
+    return true;
+}
+
+bool flash_log_pending(const flash_log_t *log) {
+    return log->pending;
+}
+
+typedef struct {
+    uint32_t offset;
+    const uint8_t *data;
+} flash_log_write_t;
+
+// Executada com o outro núcleo pausado e as interrupções deste desligadas
+static void flash_log_program(void *param) {
+    const flash_log_write_t *write = (const flash_log_write_t *)param;
+    flash_range_erase(write->offset, FLASH_SECTOR_SIZE);
+    flash_range_program(write->offset, write->data, FLASH_SECTOR_SIZE);
+}
+
+bool flash_log_flush(flash_log_t *log) {
+    if (!log->pending) {
+        return true;
+    }
+
+    flash_log_write_t write = {
+        .offset = log->offset + (log->next_sequence % log->sectors) * FLASH_LOG_BLOCK_SIZE,
+        .data = log->blocks[log->active ^ 1],
+    };
+    if (flash_safe_execute(flash_log_program, &write, FLASH_LOG_LOCKOUT_TIMEOUT_MS) != PICO_OK) {
+        return false;  // fica pendente para a próxima tentativa
+    }
+
+    log->next_sequence++;
+    log->pending = false;
+    return true;
+}
+
+// Bloco de número sequence, na RAM ou na flash; NULL se ele não existe ou já foi sobrescrito
+static const uint8_t *flash_log_block(const flash_log_t *log, uint32_t sequence, bool *in_flash) {
+    *in_flash = false;
+    if (sequence == flash_log_active_sequence(log)) {
+        return log->blocks[log->active];
+    }
+    if (log->pending && sequence == log->next_sequence) {
+        return log->blocks[log->active ^ 1];
+    }
+    if (sequence >= log->next_sequence || log->next_sequence - sequence > log->sectors) {
+        return NULL;
+    }
+
+    const uint8_t *block = flash_log_sector(log, sequence);
+    const flash_log_header_t *header = (const flash_log_header_t *)block;
+    if (!flash_log_header_valid(header) || header->sequence != sequence) {
+        return NULL;
+    }
+    *in_flash = true;
+    return block;
+}
+
+static void flash_log_reader_start(flash_log_reader_t *reader, uint32_t sequence) {
+    reader->sequence = sequence;
+    reader->offset = 0;
+    reader->index = 0;
+    reader->timestamp_ms = 0;
+    reader->delta_ms = 0;
+    memset(reader->values, 0, sizeof(reader->values));
+}
+
+void flash_log_reader_init(const flash_log_t *log, flash_log_reader_t *reader, uint32_t last) {
+    // Volta a partir do bloco ativo somando os registros até cobrir 'last'
+    uint32_t oldest = log->next_sequence > log->sectors ? log->next_sequence - log->sectors : 0;
+    uint32_t sequence = flash_log_active_sequence(log);
+    uint32_t total = 0;
+    bool in_flash;
+    while (true) {
+        const uint8_t *block = flash_log_block(log, sequence, &in_flash);
+        if (block == NULL) {
+            sequence++;
+            break;
+        }
+        total += ((const flash_log_header_t *)block)->count;
+        if (total >= last || sequence == oldest) {
+            break;
+        }
+        sequence--;
+    }
+
+    flash_log_reader_start(reader, sequence);
+
+    flash_log_record_t skipped;
+    for (uint32_t skip = total > last ? total - last : 0; skip > 0; skip--) {
+        if (!flash_log_read(log, reader, &skipped)) {
+            break;
+        }
+    }
+}
+
+bool flash_log_read(const flash_log_t *log, flash_log_reader_t *reader, flash_log_record_t *record) {
+    uint32_t active = flash_log_active_sequence(log);
+    while (true) {
+        bool in_flash;
+        const uint8_t *block = flash_log_block(log, reader->sequence, &in_flash);
+        const flash_log_header_t *header = (const flash_log_header_t *)block;
+
+        // Ao entrar em um bloco da flash, confere o CRC: um setor pode ter ficado pela metade
+        // se a energia caiu durante a gravação
+        bool valid = block != NULL && !(in_flash && reader->index == 0 && header->crc != flash_log_block_crc(block));
+
+        if (valid && reader->index < header->count) {
+            const uint8_t *payload = block + sizeof(flash_log_header_t);
+            uint32_t value;
+            bool ok = flash_log_get_varint(payload, header->length, &reader->offset, &value);
+            if (ok) {
+                reader->delta_ms += (int32_t)flash_log_unzigzag(value);
+                reader->timestamp_ms += (uint32_t)reader->delta_ms;
+            }
+            for (int i = 0; ok && i < FLASH_LOG_QUANTITIES; i++) {
+                ok = flash_log_get_varint(payload, header->length, &reader->offset, &value);
+                reader->values[i] = (int32_t)((uint32_t)reader->values[i] + flash_log_unzigzag(value));
+            }
+
+            if (ok) {
+                reader->index++;
+                record->boot = header->boot;
+                record->timestamp_ms = reader->timestamp_ms;
+                memcpy(record->values, reader->values, sizeof(record->values));
+                return true;
+            }
+        }
+
+        // Fim (ou defeito) do bloco: o ativo ainda pode receber registros, os outros não
+        if (reader->sequence >= active) {
+            return false;
+        }
+        flash_log_reader_start(reader, reader->sequence + 1);
+    }
+}
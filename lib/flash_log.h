@@ -0,0 +1,91 @@
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Série temporal compactada em uma região reservada da flash, que sobrevive a reinicializações.
+//
+// Os registros são acumulados em RAM em blocos do tamanho de um setor (4 KB) e cada bloco cheio é
+// gravado de uma vez por flash_log_flush, que o chamador agenda fora do caminho crítico: apagar e
+// gravar a flash para a execução (XIP) nos dois núcleos. O bloco de sequência n vai sempre para o
+// setor n % sectors, então a região é percorrida em círculo e todos os setores se desgastam igual.
+//
+// Dentro de um bloco, o instante de cada registro é guardado como delta-of-delta e os valores como
+// deltas em relação ao registro anterior, todos em varint com zigzag; registros espaçados de forma
+// regular e com valores que mudam pouco ocupam cerca de 6 bytes. Cada bloco começa do zero, então
+// pode ser lido sozinho, e traz o número do boot em que foi gravado, porque os instantes são
+// contados a partir do boot.
+
+// Grandezas por registro (temperatura, umidade, pressão e altitude, em ponto fixo)
+#define FLASH_LOG_QUANTITIES 4
+
+// Tamanho de um bloco (um setor da flash)
+#define FLASH_LOG_BLOCK_SIZE 4096
+
+// Cabeçalho no início de cada bloco
+typedef struct {
+    uint32_t magic;
+    uint32_t sequence;  // Número do bloco, crescente
+    uint16_t boot;      // Boot em que o bloco foi gravado
+    uint16_t count;     // Registros no bloco
+    uint16_t length;    // Bytes ocupados pelos registros, depois do cabeçalho
+    uint16_t reserved;
+    uint32_t crc;       // CRC-32 do bloco (cabeçalho com crc = 0 e registros), preenchido ao fechar
+} flash_log_header_t;
+
+typedef struct {
+    uint16_t boot;
+    uint32_t timestamp_ms;  // Instante, em ms desde o boot indicado
+    int32_t values[FLASH_LOG_QUANTITIES];
+} flash_log_record_t;
+
+typedef struct {
+    uint32_t offset;            // Início da região, a partir do começo da flash (múltiplo de 4 KB)
+    uint16_t sectors;           // Setores da região
+    uint16_t boot;              // Número do boot atual
+    uint32_t next_sequence;     // Sequência do próximo bloco a gravar na flash
+    uint32_t dropped;           // Registros perdidos porque o bloco anterior ainda não tinha sido gravado
+
+    uint8_t blocks[2][FLASH_LOG_BLOCK_SIZE] __attribute__((aligned(4)));
+    uint8_t active;             // Bloco em preenchimento; o outro é o fechado, se pending
+    bool pending;               // Há um bloco fechado aguardando flash_log_flush
+
+    // Estado do codificador do bloco ativo
+    uint32_t last_timestamp_ms;
+    int32_t last_delta_ms;
+    int32_t last_values[FLASH_LOG_QUANTITIES];
+} flash_log_t;
+
+// Posição de leitura; permite ler os registros aos poucos
+typedef struct {
+    uint32_t sequence;  // Bloco sendo lido
+    uint16_t offset;    // Próximo byte dos registros do bloco
+    uint16_t index;     // Próximo registro do bloco
+    uint32_t timestamp_ms;
+    int32_t delta_ms;
+    int32_t values[FLASH_LOG_QUANTITIES];
+} flash_log_reader_t;
+
+// Procura na região o último bloco gravado, para continuar a partir dele, e define o número deste boot.
+// Os setores com cabeçalho ou CRC inválido são ignorados (e serão sobrescritos na sua vez).
+void flash_log_init(flash_log_t *log, uint32_t offset, uint16_t sectors);
+
+// Acrescenta um registro ao bloco em RAM. Retorna false se ele foi perdido (bloco anterior ainda não gravado).
+bool flash_log_append(flash_log_t *log, uint32_t timestamp_ms, const int32_t values[FLASH_LOG_QUANTITIES]);
+
+// Indica se há um bloco fechado aguardando gravação
+bool flash_log_pending(const flash_log_t *log);
+
+// Grava o bloco fechado, se houver, apagando o setor de destino. Pausa o outro núcleo durante a
+// operação (flash_safe_execute); o outro núcleo precisa ter chamado flash_safe_execute_core_init.
+bool flash_log_flush(flash_log_t *log);
+
+// Posiciona o leitor para que os próximos registros lidos sejam os 'last' mais recentes (ou todos,
+// se houver menos), incluindo os que ainda estão em RAM
+void flash_log_reader_init(const flash_log_t *log, flash_log_reader_t *reader, uint32_t last);
+
+// Lê o próximo registro, em ordem cronológica; retorna false quando não há mais
+bool flash_log_read(const flash_log_t *log, flash_log_reader_t *reader, flash_log_record_t *record);
+
+#endif
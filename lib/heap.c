@@ -0,0 +1,16 @@
+#include <malloc.h>
+#include "heap.h"
+
+// Limites do heap, definidos pelo linker script do SDK (memmap_default.ld)
+extern char __bss_end__;
+extern char __StackLimit;
+
+uint32_t heap_total_bytes(void) {
+    return (uint32_t)(&__StackLimit - &__bss_end__);
+}
+
+uint32_t heap_free_bytes(void) {
+    // uordblks conta tudo o que está alocado, inclusive os cabeçalhos dos blocos
+    struct mallinfo info = mallinfo();
+    return heap_total_bytes() - (uint32_t)info.uordblks;
+}
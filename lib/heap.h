@@ -0,0 +1,15 @@
+#ifndef HEAP_H
+#define HEAP_H
+
+#include <stdint.h>
+
+// Uso do heap do malloc. Na placa, o heap vai do fim do .bss até o início da pilha (símbolos do
+// linker script do SDK); a compilação para Linux (host/) substitui este módulo.
+
+// Tamanho total do heap, em bytes
+uint32_t heap_total_bytes(void);
+
+// Bytes do heap ainda não alocados pelo malloc
+uint32_t heap_free_bytes(void);
+
+#endif
@@ -0,0 +1,30 @@
+#include "histogram.h"
+
+void histogram_observe(histogram_t *histogram, uint32_t value_us) {
+    unsigned bucket = 0;
+    if (value_us > (1u << HISTOGRAM_FIRST_SHIFT)) {
+        // Menor potência de 2 maior ou igual ao valor: 32 - clz(valor - 1)
+        bucket = 32 - __builtin_clz(value_us - 1) - HISTOGRAM_FIRST_SHIFT;
+        if (bucket > HISTOGRAM_BUCKETS - 1) {
+            bucket = HISTOGRAM_BUCKETS - 1;
+        }
+    }
+    histogram->counts[bucket]++;
+    histogram->count++;
+    histogram->sum_us += value_us;
+}
+
+uint32_t histogram_bound_us(unsigned bucket) {
+    if (bucket >= HISTOGRAM_BUCKETS - 1) {
+        return UINT32_MAX;
+    }
+    return 1u << (HISTOGRAM_FIRST_SHIFT + bucket);
+}
+
+uint32_t histogram_cumulative(const histogram_t *histogram, unsigned bucket) {
+    uint32_t total = 0;
+    for (unsigned i = 0; i <= bucket && i < HISTOGRAM_BUCKETS; i++) {
+        total += histogram->counts[i];
+    }
+    return total;
+}
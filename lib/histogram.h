@@ -0,0 +1,32 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+
+// Histograma de durações com baldes fixos em potências de 2: o balde i conta os valores até
+// 2^(HISTOGRAM_FIRST_SHIFT + i) µs, de 64 µs a pouco mais de 1 s, e o último conta o que passar
+// disso. O balde sai direto da posição do bit mais alto do valor, então registrar é O(1), sem
+// alocação e sem percorrer os limites.
+
+// Baldes, incluindo o último, sem limite (+Inf no Prometheus)
+#define HISTOGRAM_BUCKETS 16
+
+// Limite do primeiro balde: 2^6 = 64 µs
+#define HISTOGRAM_FIRST_SHIFT 6
+
+typedef struct {
+    uint32_t counts[HISTOGRAM_BUCKETS];  // Valores em cada balde (não acumulados)
+    uint32_t count;                      // Total de valores
+    uint64_t sum_us;                     // Soma dos valores, em µs
+} histogram_t;
+
+// Registra um valor, em µs
+void histogram_observe(histogram_t *histogram, uint32_t value_us);
+
+// Limite superior, inclusive, do balde (em µs); o último balde não tem limite e retorna UINT32_MAX
+uint32_t histogram_bound_us(unsigned bucket);
+
+// Valores até o limite do balde, somando os baldes anteriores (o "le" do Prometheus)
+uint32_t histogram_cumulative(const histogram_t *histogram, unsigned bucket);
+
+#endif
@@ -0,0 +1,44 @@
+#include <math.h>
+#include "history.h"
+
+// Arredonda para o inteiro mais próximo, saturando na faixa [min, max]
+static int32_t history_fixed(float value, float scale, int32_t min, int32_t max) {
+    float scaled = roundf(value * scale);
+    if (!(scaled >= (float)min)) {
+        return min;  // também cobre NaN
+    }
+    if (scaled >= (float)max) {
+        return max;
+    }
+    return (int32_t)scaled;
+}
+
+void history_push(history_t *history, const sensor_sample_t *sample) {
+    history_entry_t *entry = &history->entries[history->last % HISTORY_CAPACITY];
+
+    entry->timestamp_ms = sample->timestamp_ms;
+    entry->temperatura = (int16_t)history_fixed(sample->temperatura, 100.0f, INT16_MIN, INT16_MAX);
+    entry->umidade = (uint16_t)history_fixed(sample->umidade, 100.0f, 0, UINT16_MAX);
+    entry->pressao = history_fixed(sample->pressao, 1000.0f, INT32_MIN, INT32_MAX);
+    entry->altitude = history_fixed(sample->altitude, 100.0f, INT32_MIN, INT32_MAX);
+    history->last++;
+}
+
+uint32_t history_first(const history_t *history) {
+    if (history->last == 0) {
+        return 0;
+    }
+    return history->last > HISTORY_CAPACITY ? history->last - HISTORY_CAPACITY + 1 : 1;
+}
+
+uint32_t history_last(const history_t *history) {
+    return history->last;
+}
+
+bool history_get(const history_t *history, uint32_t sequence, history_entry_t *entry) {
+    if (sequence == 0 || sequence < history_first(history) || sequence > history->last) {
+        return false;
+    }
+    *entry = history->entries[(sequence - 1) % HISTORY_CAPACITY];
+    return true;
+}
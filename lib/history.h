@@ -0,0 +1,41 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sensor_ring.h"
+
+// Histórico das últimas amostras em RAM, em ponto fixo (16 bytes por amostra). Cada amostra
+// recebe um número de sequência crescente, a partir de 1, que permite a um cliente buscar só o
+// que chegou desde a última consulta. Quando a fila enche, as amostras mais antigas são descartadas.
+
+// Número de amostras guardadas (32 KB); com uma leitura por segundo, cerca de 34 minutos
+#define HISTORY_CAPACITY 2048
+
+// Amostra guardada, nas mesmas unidades dos frames do WebSocket
+typedef struct {
+    uint32_t timestamp_ms;  // Instante da leitura, em ms desde o boot
+    int16_t temperatura;    // Centésimos de °C
+    uint16_t umidade;       // Centésimos de ponto percentual
+    int32_t pressao;        // Pa
+    int32_t altitude;       // Centímetros
+} history_entry_t;
+
+typedef struct {
+    history_entry_t entries[HISTORY_CAPACITY];
+    uint32_t last;  // Sequência da amostra mais recente (0: histórico vazio)
+} history_t;
+
+// Converte a amostra para ponto fixo e a acrescenta ao histórico
+void history_push(history_t *history, const sensor_sample_t *sample);
+
+// Sequência da amostra mais antiga ainda guardada (0 com o histórico vazio)
+uint32_t history_first(const history_t *history);
+
+// Sequência da amostra mais recente (0 com o histórico vazio)
+uint32_t history_last(const history_t *history);
+
+// Copia a amostra de número sequence; retorna false se ela já foi descartada ou ainda não existe
+bool history_get(const history_t *history, uint32_t sequence, history_entry_t *entry);
+
+#endif
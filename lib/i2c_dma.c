@@ -0,0 +1,176 @@
+#include "i2c_dma.h"
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+// Estado de um barramento
+typedef struct {
+    bool initialized;
+    int tx_channel;     // Canal que escreve os comandos em IC_DATA_CMD
+    int rx_channel;     // Canal que copia os bytes lidos de IC_DATA_CMD para o destino
+    uint16_t commands[I2C_DMA_MAX_TRANSFER];  // Um comando de 16 bits por byte escrito ou lido
+    bool aborted;
+    volatile i2c_dma_status_t status;
+    i2c_dma_callback_t callback;
+    void *arg;
+} i2c_dma_bus_t;
+
+static i2c_dma_bus_t buses[NUM_I2CS];
+
+static void i2c_dma_irq(uint index) {
+    i2c_inst_t *i2c = I2C_INSTANCE(index);
+    i2c_hw_t *hw = i2c_get_hw(i2c);
+    i2c_dma_bus_t *bus = &buses[index];
+    uint32_t status = hw->intr_stat;
+
+    // Em um NACK o controlador descarta a FIFO de transmissão e envia STOP; os canais DMA são
+    // abortados aqui e o término é tratado no STOP_DET que vem em seguida
+    if (status & I2C_IC_INTR_STAT_R_TX_ABRT_BITS) {
+        bus->aborted = true;
+        dma_channel_abort(bus->tx_channel);
+        dma_channel_abort(bus->rx_channel);
+        (void)hw->clr_tx_abrt;
+    }
+
+    if (status & I2C_IC_INTR_STAT_R_STOP_DET_BITS) {
+        (void)hw->clr_stop_det;
+        if (bus->status != I2C_DMA_BUSY) {
+            return;
+        }
+
+        // O último byte lido pode ainda estar a caminho da memória
+        while (!bus->aborted && dma_channel_is_busy(bus->rx_channel)) {
+            tight_loop_contents();
+        }
+
+        bus->status = bus->aborted ? I2C_DMA_ERROR : I2C_DMA_DONE;
+        if (bus->callback) {
+            bus->callback(i2c, bus->status, bus->arg);
+        }
+    }
+}
+
+static void i2c0_dma_irq(void) {
+    i2c_dma_irq(0);
+}
+
+static void i2c1_dma_irq(void) {
+    i2c_dma_irq(1);
+}
+
+bool i2c_dma_init(i2c_inst_t *i2c) {
+    uint index = i2c_hw_index(i2c);
+    i2c_dma_bus_t *bus = &buses[index];
+    i2c_hw_t *hw = i2c_get_hw(i2c);
+
+    if (bus->initialized) {
+        return true;
+    }
+
+    bus->tx_channel = dma_claim_unused_channel(false);
+    bus->rx_channel = dma_claim_unused_channel(false);
+    if (bus->tx_channel < 0 || bus->rx_channel < 0) {
+        if (bus->tx_channel >= 0) {
+            dma_channel_unclaim(bus->tx_channel);
+        }
+        if (bus->rx_channel >= 0) {
+            dma_channel_unclaim(bus->rx_channel);
+        }
+        return false;
+    }
+
+    // Comandos de 16 bits (byte + flags de leitura, RESTART e STOP), no ritmo da FIFO de transmissão
+    dma_channel_config config = dma_channel_get_default_config(bus->tx_channel);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+    channel_config_set_read_increment(&config, true);
+    channel_config_set_write_increment(&config, false);
+    channel_config_set_dreq(&config, i2c_get_dreq(i2c, true));
+    dma_channel_configure(bus->tx_channel, &config, &hw->data_cmd, bus->commands, 0, false);
+
+    // Bytes lidos, no ritmo da FIFO de recepção
+    config = dma_channel_get_default_config(bus->rx_channel);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+    channel_config_set_read_increment(&config, false);
+    channel_config_set_write_increment(&config, true);
+    channel_config_set_dreq(&config, i2c_get_dreq(i2c, false));
+    dma_channel_configure(bus->rx_channel, &config, NULL, &hw->data_cmd, 0, false);
+
+    // DREQ de transmissão com até 4 comandos na FIFO (o DMA a mantém cheia sem esvaziá-la) e de
+    // recepção a cada byte recebido
+    hw->dma_tdlr = 4;
+    hw->dma_rdlr = 0;
+    hw->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS | I2C_IC_DMA_CR_RDMAE_BITS;
+
+    hw->intr_mask = I2C_IC_INTR_MASK_M_STOP_DET_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+    uint irq = index == 0 ? I2C0_IRQ : I2C1_IRQ;
+    irq_set_exclusive_handler(irq, index == 0 ? i2c0_dma_irq : i2c1_dma_irq);
+    irq_set_enabled(irq, true);
+
+    bus->status = I2C_DMA_IDLE;
+    bus->initialized = true;
+    return true;
+}
+
+bool i2c_dma_write_read(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t src_len,
+                        uint8_t *dst, size_t dst_len, i2c_dma_callback_t callback, void *arg) {
+    i2c_dma_bus_t *bus = &buses[i2c_hw_index(i2c)];
+    i2c_hw_t *hw = i2c_get_hw(i2c);
+    size_t total = src_len + dst_len;
+
+    if (!bus->initialized || bus->status == I2C_DMA_BUSY || total == 0 || total > I2C_DMA_MAX_TRANSFER) {
+        return false;
+    }
+
+    // Escritas primeiro; a primeira leitura leva RESTART (se houve escrita) e o último comando, STOP
+    for (size_t i = 0; i < src_len; i++) {
+        bus->commands[i] = src[i];
+    }
+    for (size_t i = 0; i < dst_len; i++) {
+        bus->commands[src_len + i] = I2C_IC_DATA_CMD_CMD_BITS;
+    }
+    if (src_len > 0 && dst_len > 0) {
+        bus->commands[src_len] |= I2C_IC_DATA_CMD_RESTART_BITS;
+    }
+    bus->commands[total - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+    // O endereço do dispositivo só pode ser trocado com o controlador desabilitado
+    hw->enable = 0;
+    hw->tar = addr;
+    hw->enable = 1;
+    (void)hw->clr_tx_abrt;
+    (void)hw->clr_stop_det;
+
+    bus->aborted = false;
+    bus->callback = callback;
+    bus->arg = arg;
+    bus->status = I2C_DMA_BUSY;
+
+    if (dst_len > 0) {
+        dma_channel_transfer_to_buffer_now(bus->rx_channel, dst, dst_len);
+    }
+    dma_channel_transfer_from_buffer_now(bus->tx_channel, bus->commands, total);
+    return true;
+}
+
+i2c_dma_status_t i2c_dma_status(i2c_inst_t *i2c) {
+    return buses[i2c_hw_index(i2c)].status;
+}
+
+bool i2c_dma_busy(i2c_inst_t *i2c) {
+    return buses[i2c_hw_index(i2c)].status == I2C_DMA_BUSY;
+}
+
+i2c_dma_status_t i2c_dma_wait(i2c_inst_t *i2c) {
+    while (i2c_dma_busy(i2c)) {
+        tight_loop_contents();
+    }
+    return i2c_dma_status(i2c);
+}
+
+bool i2c_dma_write_read_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t src_len,
+                                 uint8_t *dst, size_t dst_len) {
+    if (!i2c_dma_write_read(i2c, addr, src, src_len, dst, dst_len, NULL, NULL)) {
+        return false;
+    }
+    return i2c_dma_wait(i2c) == I2C_DMA_DONE;
+}
@@ -0,0 +1,50 @@
+#ifndef I2C_DMA_H
+#define I2C_DMA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "hardware/i2c.h"
+
+// Transações I2C assíncronas: os bytes são levados à FIFO do controlador por DMA e o fim da
+// transação é sinalizado pela interrupção do próprio I2C (STOP ou NACK). Cada barramento tem seu
+// par de canais DMA, então i2c0 e i2c1 podem transferir ao mesmo tempo.
+
+// Maior transação suportada, somando os bytes escritos e lidos
+#define I2C_DMA_MAX_TRANSFER 32
+
+// Estado da última transação de um barramento
+typedef enum {
+    I2C_DMA_IDLE,   // Nenhuma transação iniciada
+    I2C_DMA_BUSY,   // Transação em andamento
+    I2C_DMA_DONE,   // Concluída com sucesso
+    I2C_DMA_ERROR   // Abortada pelo controlador (NACK do dispositivo ou perda de arbitragem)
+} i2c_dma_status_t;
+
+// Chamada no contexto da interrupção quando a transação termina; pode iniciar a próxima
+typedef void (*i2c_dma_callback_t)(i2c_inst_t *i2c, i2c_dma_status_t status, void *arg);
+
+// Reserva os canais DMA e habilita a interrupção do barramento. Pode ser chamada mais de uma vez.
+// O barramento já deve ter sido configurado com i2c_init.
+bool i2c_dma_init(i2c_inst_t *i2c);
+
+// Inicia uma transação: escreve src_len bytes de src e, com um RESTART, lê dst_len bytes em dst.
+// Qualquer um dos dois tamanhos pode ser zero. Retorna false se o barramento estiver ocupado.
+// src é copiado antes do retorno; dst deve continuar válido até o fim da transação.
+bool i2c_dma_write_read(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t src_len,
+                        uint8_t *dst, size_t dst_len, i2c_dma_callback_t callback, void *arg);
+
+// Estado da última transação do barramento
+i2c_dma_status_t i2c_dma_status(i2c_inst_t *i2c);
+
+// Indica se há uma transação em andamento no barramento
+bool i2c_dma_busy(i2c_inst_t *i2c);
+
+// Aguarda o fim da transação em andamento e retorna seu estado
+i2c_dma_status_t i2c_dma_wait(i2c_inst_t *i2c);
+
+// Inicia uma transação e aguarda o seu fim; retorna true se ela foi concluída com sucesso
+bool i2c_dma_write_read_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t src_len,
+                                 uint8_t *dst, size_t dst_len);
+
+#endif
@@ -22,6 +22,7 @@
 
 #define MEM_SIZE                    16384
 #define MEMP_NUM_TCP_SEG            32
+#define MEMP_NUM_TCP_PCB            12
 #define MEMP_NUM_ARP_QUEUE          10
 
 #define PBUF_POOL_SIZE              32
@@ -38,9 +39,11 @@
 #define LWIP_NETIF_LINK_CALLBACK    1
 #define LWIP_NETIF_HOSTNAME         1
 #define LWIP_NETCONN                0
-#define MEM_STATS                   0
+// Contadores de uso do heap e dos pools do lwIP (atual, maximo e falhas), expostos em /metrics
+#define LWIP_STATS                  1
+#define MEM_STATS                   1
 #define SYS_STATS                   0
-#define MEMP_STATS                  0
+#define MEMP_STATS                  1
 #define LINK_STATS                  0
 // #define ETH_PAD_SIZE                2
 #define LWIP_CHKSUM_ALGORITHM       3
@@ -56,7 +59,6 @@
 
 #ifndef NDEBUG
 #define LWIP_DEBUG                  0 
-#define LWIP_STATS                  0
 #define LWIP_STATS_DISPLAY          0
 #endif
 
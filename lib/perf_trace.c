@@ -0,0 +1,69 @@
+#include "perf_trace.h"
+#include "hardware/sync.h"
+
+// Bits do registrador de controle do SysTick (SYST_CSR)
+#define SYSTICK_CSR_ENABLE 0x1u
+#define SYSTICK_CSR_CLKSOURCE 0x4u  // Clock do processador, em vez da referência externa
+
+void perf_trace_init_core(void) {
+    systick_hw->csr = 0;
+    systick_hw->rvr = PERF_TRACE_SYSTICK_MASK;
+    systick_hw->cvr = 0;  // Qualquer escrita zera a contagem e recarrega com rvr
+    systick_hw->csr = SYSTICK_CSR_ENABLE | SYSTICK_CSR_CLKSOURCE;
+}
+
+void perf_trace_end(perf_trace_t *trace, perf_span_t span, uint8_t id, uint16_t arg) {
+    uint32_t end_cycles = systick_hw->cvr;
+    uint32_t duration_us = time_us_32() - span.start_us;
+    uint32_t cycles = (span.start_cycles - end_cycles) & PERF_TRACE_SYSTICK_MASK;
+    perf_trace_event_t event = {
+        .start_us = span.start_us,
+        .duration_us = duration_us,
+        .cycles = duration_us < PERF_TRACE_CYCLES_MAX_US ? cycles : 0,  // O contador pode ter dado a volta
+        .arg = arg,
+        .id = id,
+    };
+    perf_trace_ring_t *ring = &trace->cores[get_core_num()];
+
+    // A interrupção do lwIP, neste mesmo núcleo, também registra spans
+    uint32_t interrupts = save_and_disable_interrupts();
+    uint32_t last = ring->last;
+    // O last anterior precisa aparecer antes de a posição ser sobrescrita (ver perf_trace_get)
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    ring->events[last % PERF_TRACE_CAPACITY] = event;
+    __atomic_store_n(&ring->last, last + 1, __ATOMIC_RELEASE);
+    restore_interrupts(interrupts);
+}
+
+void perf_trace_end_min(perf_trace_t *trace, perf_span_t span, uint8_t id, uint16_t arg, uint32_t min_us) {
+    if (time_us_32() - span.start_us >= min_us) {
+        perf_trace_end(trace, span, id, arg);
+    }
+}
+
+uint32_t perf_trace_first(const perf_trace_t *trace, uint8_t core) {
+    uint32_t last = __atomic_load_n(&trace->cores[core].last, __ATOMIC_ACQUIRE);
+    if (last == 0) {
+        return 0;
+    }
+    return last > PERF_TRACE_CAPACITY - 1 ? last - (PERF_TRACE_CAPACITY - 1) + 1 : 1;
+}
+
+uint32_t perf_trace_last(const perf_trace_t *trace, uint8_t core) {
+    return __atomic_load_n(&trace->cores[core].last, __ATOMIC_ACQUIRE);
+}
+
+bool perf_trace_get(const perf_trace_t *trace, uint8_t core, uint32_t sequence, perf_trace_event_t *event) {
+    const perf_trace_ring_t *ring = &trace->cores[core];
+
+    // O span de sequência last + 1 é escrito na posição de last + 1 - CAPACITY antes de last mudar,
+    // então só as CAPACITY - 1 sequências mais recentes são estáveis
+    uint32_t last = __atomic_load_n(&ring->last, __ATOMIC_ACQUIRE);
+    if (sequence == 0 || sequence > last || last - sequence >= PERF_TRACE_CAPACITY - 1) {
+        return false;
+    }
+    *event = ring->events[(sequence - 1) % PERF_TRACE_CAPACITY];
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);  // A cópia precisa terminar antes de conferir last de novo
+    last = __atomic_load_n(&ring->last, __ATOMIC_RELAXED);
+    return last - sequence < PERF_TRACE_CAPACITY - 1;
+}
@@ -0,0 +1,90 @@
+#ifndef PERF_TRACE_H
+#define PERF_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pico/stdlib.h"
+#include "hardware/structs/systick.h"
+
+// Registro de spans (início e duração de um trecho de código) para ver onde o tempo de cada núcleo
+// vai. O instante vem do timer de 64 bits do RP2040 (só a parte baixa, que é um único registrador;
+// os 64 bits são reconstruídos na exportação) e a contagem de ciclos vem do SysTick do próprio
+// núcleo. Cada núcleo escreve apenas no seu anel, então não há trava entre os núcleos; dentro do
+// núcleo, as interrupções ficam desligadas só durante a cópia de 16 bytes, porque o lwIP também
+// registra spans a partir da interrupção da pilha de rede. Um span são duas leituras de
+// registrador ao abrir e ao fechar mais a cópia, e os anéis ocupam 16 KB fixos: dá para deixar
+// ligado sempre.
+//
+// Quando o anel enche, os spans mais antigos são sobrescritos. Cada span recebe um número de
+// sequência crescente, a partir de 1, por núcleo, como no histórico (lib/history.h).
+
+// Spans guardados por núcleo (8 KB cada); uma posição fica reservada para a escrita em andamento
+#define PERF_TRACE_CAPACITY 512
+
+// Núcleos do RP2040, um anel para cada
+#define PERF_TRACE_CORES 2
+
+// O SysTick conta para baixo em 24 bits e dá a volta a cada 134 ms a 125 MHz; spans mais longos
+// que isso ficam sem contagem de ciclos
+#define PERF_TRACE_SYSTICK_MASK 0x00FFFFFFu
+#define PERF_TRACE_CYCLES_MAX_US 100000
+
+// Span aberto por perf_span_begin e ainda não registrado
+typedef struct {
+    uint32_t start_us;      // Parte baixa do timer de 64 bits
+    uint32_t start_cycles;  // Valor do SysTick (decrescente)
+} perf_span_t;
+
+// Span registrado (16 bytes)
+typedef struct {
+    uint32_t start_us;      // Parte baixa do timer no início do span
+    uint32_t duration_us;   // Duração, em µs
+    uint32_t cycles;        // Duração, em ciclos do núcleo; 0 acima de PERF_TRACE_CYCLES_MAX_US
+    uint16_t arg;           // Valor livre do chamador (rota, tamanho, tentativa...)
+    uint8_t id;             // Identificador do trecho, definido pelo chamador
+    uint8_t reserved;
+} perf_trace_event_t;
+
+typedef struct {
+    perf_trace_event_t events[PERF_TRACE_CAPACITY];
+    uint32_t last;  // Sequência do span mais recente (0: anel vazio); só o núcleo dono altera
+} perf_trace_ring_t;
+
+typedef struct {
+    perf_trace_ring_t cores[PERF_TRACE_CORES];
+} perf_trace_t;
+
+// Liga o SysTick do núcleo que chama, contando ciclos do processador; cada núcleo chama uma vez
+void perf_trace_init_core(void);
+
+// Abre um span no núcleo atual
+static inline perf_span_t perf_span_begin(void) {
+    perf_span_t span;
+    span.start_us = time_us_32();
+    span.start_cycles = systick_hw->cvr;
+    return span;
+}
+
+// Fecha o span e o registra no anel do núcleo atual
+void perf_trace_end(perf_trace_t *trace, perf_span_t span, uint8_t id, uint16_t arg);
+
+// Como perf_trace_end, mas só registra spans de pelo menos min_us, para trechos que se repetem a
+// todo momento e quase sempre não fazem nada (ex.: cada volta do loop principal)
+void perf_trace_end_min(perf_trace_t *trace, perf_span_t span, uint8_t id, uint16_t arg, uint32_t min_us);
+
+// Sequência do span mais antigo ainda guardado no anel do núcleo (0 com o anel vazio)
+uint32_t perf_trace_first(const perf_trace_t *trace, uint8_t core);
+
+// Sequência do span mais recente do núcleo (0 com o anel vazio)
+uint32_t perf_trace_last(const perf_trace_t *trace, uint8_t core);
+
+// Copia o span de número sequence; retorna false se ele já foi (ou está sendo) sobrescrito ou
+// ainda não existe. Pode ser chamada de qualquer núcleo enquanto os spans são registrados.
+bool perf_trace_get(const perf_trace_t *trace, uint8_t core, uint32_t sequence, perf_trace_event_t *event);
+
+// Instante completo, em µs desde o boot, de um start_us registrado há menos de 71 minutos de now_us
+static inline uint64_t perf_trace_time_us(uint64_t now_us, uint32_t start_us) {
+    return now_us - (uint32_t)((uint32_t)now_us - start_us);
+}
+
+#endif
@@ -0,0 +1,83 @@
+#include "rollup.h"
+
+void rollup_init(rollup_t *rollup, uint32_t period_ms, rollup_bucket_t *buckets, uint16_t capacity) {
+    rollup->period_ms = period_ms;
+    rollup->buckets = buckets;
+    rollup->capacity = capacity;
+    rollup->last = 0;
+    rollup->open_count = 0;
+}
+
+// Divisão com arredondamento para o inteiro mais próximo (count > 0)
+static int32_t rollup_mean(int64_t sum, uint32_t count) {
+    int64_t half = count / 2;
+    return (int32_t)(sum >= 0 ? (sum + half) / count : (sum - half) / count);
+}
+
+bool rollup_get_open(const rollup_t *rollup, rollup_bucket_t *bucket) {
+    if (rollup->open_count == 0) {
+        return false;
+    }
+
+    bucket->start_ms = rollup->open_start_ms;
+    bucket->count = rollup->open_count;
+    for (int i = 0; i < ROLLUP_QUANTITIES; i++) {
+        bucket->stats[i].min = rollup->open_min[i];
+        bucket->stats[i].max = rollup->open_max[i];
+        bucket->stats[i].mean = rollup_mean(rollup->open_sum[i], rollup->open_count);
+    }
+    return true;
+}
+
+bool rollup_add(rollup_t *rollup, uint32_t timestamp_ms, const int32_t values[ROLLUP_QUANTITIES]) {
+    uint32_t start_ms = timestamp_ms - timestamp_ms % rollup->period_ms;
+
+    // Amostra de outro intervalo: fecha o aberto
+    bool closed = false;
+    if (rollup->open_count > 0 && start_ms != rollup->open_start_ms) {
+        rollup_get_open(rollup, &rollup->buckets[rollup->last % rollup->capacity]);
+        rollup->last++;
+        rollup->open_count = 0;
+        closed = true;
+    }
+
+    if (rollup->open_count == 0) {
+        rollup->open_start_ms = start_ms;
+        for (int i = 0; i < ROLLUP_QUANTITIES; i++) {
+            rollup->open_min[i] = values[i];
+            rollup->open_max[i] = values[i];
+            rollup->open_sum[i] = 0;
+        }
+    }
+
+    rollup->open_count++;
+    for (int i = 0; i < ROLLUP_QUANTITIES; i++) {
+        if (values[i] < rollup->open_min[i]) {
+            rollup->open_min[i] = values[i];
+        }
+        if (values[i] > rollup->open_max[i]) {
+            rollup->open_max[i] = values[i];
+        }
+        rollup->open_sum[i] += values[i];
+    }
+    return closed;
+}
+
+uint32_t rollup_first(const rollup_t *rollup) {
+    if (rollup->last == 0) {
+        return 0;
+    }
+    return rollup->last > rollup->capacity ? rollup->last - rollup->capacity + 1 : 1;
+}
+
+uint32_t rollup_last(const rollup_t *rollup) {
+    return rollup->last;
+}
+
+bool rollup_get(const rollup_t *rollup, uint32_t sequence, rollup_bucket_t *bucket) {
+    if (sequence == 0 || sequence < rollup_first(rollup) || sequence > rollup->last) {
+        return false;
+    }
+    *bucket = rollup->buckets[(sequence - 1) % rollup->capacity];
+    return true;
+}
@@ -0,0 +1,62 @@
+#ifndef ROLLUP_H
+#define ROLLUP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Agregados (mínimo, máximo, média e contagem) de várias grandezas em intervalos fixos de tempo
+// (1 minuto, 1 hora...). Cada amostra atualiza só o intervalo aberto, em tempo constante; quando
+// chega uma amostra de outro intervalo, o aberto é fechado e guardado em uma fila circular de
+// tamanho fixo, descartando o mais antigo. Como no histórico, cada intervalo fechado recebe um
+// número de sequência crescente, a partir de 1.
+
+// Grandezas agregadas por amostra (temperatura, umidade, pressão e altitude)
+#define ROLLUP_QUANTITIES 4
+
+typedef struct {
+    int32_t min;
+    int32_t max;
+    int32_t mean;  // Arredondada para o inteiro mais próximo
+} rollup_stat_t;
+
+// Um intervalo agregado, nas mesmas unidades de ponto fixo das amostras recebidas
+typedef struct {
+    uint32_t start_ms;  // Início do intervalo, em ms desde o boot (múltiplo de period_ms)
+    uint32_t count;     // Amostras agregadas
+    rollup_stat_t stats[ROLLUP_QUANTITIES];
+} rollup_bucket_t;
+
+typedef struct {
+    uint32_t period_ms;
+    rollup_bucket_t *buckets;   // Intervalos fechados (fila circular)
+    uint16_t capacity;
+    uint32_t last;              // Sequência do último intervalo fechado (0: nenhum)
+
+    // Intervalo aberto
+    uint32_t open_start_ms;
+    uint32_t open_count;        // 0: nenhum intervalo aberto
+    int32_t open_min[ROLLUP_QUANTITIES];
+    int32_t open_max[ROLLUP_QUANTITIES];
+    int64_t open_sum[ROLLUP_QUANTITIES];
+} rollup_t;
+
+// Prepara um agregador de intervalos de period_ms, guardando até capacity intervalos em buckets
+void rollup_init(rollup_t *rollup, uint32_t period_ms, rollup_bucket_t *buckets, uint16_t capacity);
+
+// Acrescenta uma amostra ao intervalo que contém timestamp_ms. Retorna true se, para isso, o intervalo
+// aberto foi fechado (ele passa a ser o de sequência rollup_last)
+bool rollup_add(rollup_t *rollup, uint32_t timestamp_ms, const int32_t values[ROLLUP_QUANTITIES]);
+
+// Sequência do intervalo fechado mais antigo ainda guardado (0 se não houver)
+uint32_t rollup_first(const rollup_t *rollup);
+
+// Sequência do último intervalo fechado (0 se não houver)
+uint32_t rollup_last(const rollup_t *rollup);
+
+// Copia o intervalo fechado de número sequence; retorna false se ele já foi descartado ou não existe
+bool rollup_get(const rollup_t *rollup, uint32_t sequence, rollup_bucket_t *bucket);
+
+// Copia o intervalo ainda aberto, com o que foi agregado até agora; retorna false se não houver
+bool rollup_get_open(const rollup_t *rollup, rollup_bucket_t *bucket);
+
+#endif
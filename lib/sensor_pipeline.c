@@ -0,0 +1,46 @@
+#include <math.h>
+#include <string.h>
+#include "sensor_pipeline.h"
+
+void sensor_pipeline_init(sensor_pipeline_t *pipeline, const struct bmp280_calib_param *params) {
+    memset(pipeline, 0, sizeof(*pipeline));
+    pipeline->params = *params;
+    pipeline->aht20_result = AHT20_RESULT_ERROR;
+}
+
+aht20_result_t sensor_pipeline_read(sensor_pipeline_t *pipeline, bool aht20_done, const uint8_t *aht20_raw,
+                                    bool bmp280_done, const uint8_t *bmp280_raw) {
+    pipeline->aht20_result = aht20_done ? aht20_decode(aht20_raw, 7, &pipeline->aht20_attempt) : AHT20_RESULT_ERROR;
+
+    // O BMP280 já terminou de converter: cada tentativa bem-sucedida substitui a leitura anterior
+    pipeline->bmp280_ok = bmp280_done;
+    if (bmp280_done) {
+        int32_t raw_temp, raw_pressure;
+        bmp280_decode_raw(bmp280_raw, &raw_temp, &raw_pressure);
+        bmp280_compensate_64(raw_temp, raw_pressure, &pipeline->params, &pipeline->bmp280);
+    }
+    return pipeline->aht20_result;
+}
+
+bool sensor_pipeline_sample(sensor_pipeline_t *pipeline, uint32_t timestamp_ms, const estacao_config_t *config,
+                            sensor_sample_t *sample) {
+    // Se o AHT20 falhou, mantém a leitura anterior
+    if (pipeline->aht20_result == AHT20_RESULT_READY) {
+        pipeline->aht20 = pipeline->aht20_attempt;
+    }
+
+    float pressure_pa = pipeline->bmp280.pressure_q24_8 / 256.0f;
+    sample->sequence = ++pipeline->sequence;
+    sample->timestamp_ms = timestamp_ms;
+    sample->temperatura = pipeline->aht20.temperature + config->temp_offset;
+    sample->umidade = pipeline->aht20.humidity + config->umid_offset;
+    sample->pressao = (pressure_pa / 1000.0) + config->press_offset;
+    sample->altitude = calculate_altitude(pressure_pa) + config->alt_offset;
+
+    return sample->temperatura > config->temp_max || sample->temperatura < config->temp_min ||
+           sample->umidade > config->umid_max || sample->umidade < config->umid_min;
+}
+
+float calculate_altitude(float pressure_pa) {
+    return 44330.0 * (1.0 - pow(pressure_pa / SEA_LEVEL_PRESSURE, 0.1903));
+}
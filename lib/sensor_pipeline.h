@@ -0,0 +1,52 @@
+#ifndef SENSOR_PIPELINE_H
+#define SENSOR_PIPELINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "hardware/i2c.h"
+#include "aht20.h"
+#include "bmp280_compensation.h"
+#include "sensor_ring.h"
+
+// Processamento das leituras no núcleo 1: interpreta os bytes recebidos dos sensores, compensa a
+// pressão, aplica os offsets, calcula a altitude e avalia os alertas. Não faz I2C, para que o mesmo
+// código rode sobre leituras gravadas (host/replay.c) e produza exatamente os mesmos valores.
+
+// Pressão ao nível do mar em Pascal, para o cálculo da altitude
+#define SEA_LEVEL_PRESSURE 101325.0
+
+// Offsets e limites ajustados na página de configuração
+typedef struct {
+    float temp_offset, temp_min, temp_max;    // Temperatura, em graus Celsius
+    float umid_offset, umid_min, umid_max;    // Umidade, em pontos percentuais
+    float press_offset, press_min, press_max; // Pressão, em kPa
+    float alt_offset, alt_min, alt_max;       // Altitude, em metros
+} estacao_config_t;
+
+typedef struct {
+    struct bmp280_calib_param params;
+    AHT20_Data aht20;              // Última leitura válida do AHT20
+    bmp280_reading_t bmp280;       // Última leitura válida do BMP280
+    AHT20_Data aht20_attempt;      // Medida da tentativa mais recente, válida se aht20_result for READY
+    aht20_result_t aht20_result;   // Resultado da tentativa mais recente do AHT20
+    bool bmp280_ok;                // A tentativa mais recente do BMP280 deu certo
+    uint32_t sequence;             // Número da última amostra produzida
+} sensor_pipeline_t;
+
+void sensor_pipeline_init(sensor_pipeline_t *pipeline, const struct bmp280_calib_param *params);
+
+// Registra uma tentativa de leitura dos dois sensores: aht20_raw são os 7 bytes do AHT20 (com CRC) e
+// bmp280_raw os 6 registradores de pressão e temperatura; *_done indica se a transferência I2C de
+// cada um terminou sem erro. Retorna o resultado do AHT20 (BUSY: o sensor ainda está convertendo).
+aht20_result_t sensor_pipeline_read(sensor_pipeline_t *pipeline, bool aht20_done, const uint8_t *aht20_raw,
+                                    bool bmp280_done, const uint8_t *bmp280_raw);
+
+// Fecha o ciclo de leitura: monta a amostra com a última leitura válida de cada sensor e os offsets de
+// config. Retorna true se temperatura ou umidade estiverem fora dos limites.
+bool sensor_pipeline_sample(sensor_pipeline_t *pipeline, uint32_t timestamp_ms, const estacao_config_t *config,
+                            sensor_sample_t *sample);
+
+// Altitude em metros a partir da pressão, pela fórmula barométrica
+float calculate_altitude(float pressure_pa);
+
+#endif
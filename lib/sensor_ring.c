@@ -0,0 +1,32 @@
+#include "sensor_ring.h"
+
+_Static_assert((SENSOR_RING_SIZE & (SENSOR_RING_SIZE - 1)) == 0, "SENSOR_RING_SIZE precisa ser potência de 2");
+
+bool sensor_ring_push(sensor_ring_t *ring, const sensor_sample_t *sample) {
+    uint32_t head = ring->head;
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+    if (head - tail == SENSOR_RING_SIZE) {
+        ring->dropped++;
+        return false;
+    }
+
+    ring->slots[head & (SENSOR_RING_SIZE - 1)] = *sample;
+    // A amostra precisa estar na memória antes de o consumidor enxergar o novo head
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool sensor_ring_pop(sensor_ring_t *ring, sensor_sample_t *sample) {
+    uint32_t tail = ring->tail;
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+    if (head == tail) {
+        return false;
+    }
+
+    *sample = ring->slots[tail & (SENSOR_RING_SIZE - 1)];
+    // Só libera a posição para o produtor depois de copiá-la
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
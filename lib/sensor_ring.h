@@ -0,0 +1,38 @@
+#ifndef SENSOR_RING_H
+#define SENSOR_RING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Fila circular sem trava entre um único produtor (núcleo 1, que lê os sensores) e um único
+// consumidor (núcleo 0, que atende a rede). Cada índice é escrito por apenas um dos lados, então
+// basta a ordem de memória das operações atômicas para que o consumidor nunca veja uma amostra
+// pela metade.
+
+// Número de posições da fila; precisa ser potência de 2
+#define SENSOR_RING_SIZE 8
+
+// Amostra já compensada e com os offsets do usuário aplicados
+typedef struct {
+    uint32_t sequence;      // Número da amostra, crescente a partir de 1
+    uint32_t timestamp_ms;  // Instante da leitura, em ms desde o boot
+    float temperatura;      // °C
+    float umidade;          // %
+    float pressao;          // kPa
+    float altitude;         // m
+} sensor_sample_t;
+
+typedef struct {
+    sensor_sample_t slots[SENSOR_RING_SIZE];
+    uint32_t head;      // Próxima posição a escrever; só o produtor altera
+    uint32_t tail;      // Próxima posição a ler; só o consumidor altera
+    uint32_t dropped;   // Amostras descartadas por fila cheia; só o produtor altera
+} sensor_ring_t;
+
+// Enfileira uma amostra (produtor). Com a fila cheia a amostra é descartada e a função retorna false.
+bool sensor_ring_push(sensor_ring_t *ring, const sensor_sample_t *sample);
+
+// Retira a amostra mais antiga (consumidor). Retorna false se a fila estiver vazia.
+bool sensor_ring_pop(sensor_ring_t *ring, sensor_sample_t *sample);
+
+#endif
@@ -0,0 +1,108 @@
+#include <string.h>
+#include "sensor_trace.h"
+
+_Static_assert(sizeof(sensor_trace_read_t) == 18, "sensor_trace_read_t mudou de tamanho");
+_Static_assert(sizeof(sensor_trace_sample_t) == 21, "sensor_trace_sample_t mudou de tamanho");
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+size_t sensor_trace_encode(uint8_t *buffer, size_t size, uint8_t type, const void *payload, uint8_t length) {
+    if (length > SENSOR_TRACE_MAX_PAYLOAD || size < 2u + length) {
+        return 0;
+    }
+    buffer[0] = type;
+    buffer[1] = length;
+    memcpy(buffer + 2, payload, length);
+    return 2u + length;
+}
+
+size_t sensor_trace_format_line(char *line, size_t size, uint8_t type, const void *payload, uint8_t length) {
+    uint8_t record[SENSOR_TRACE_RECORD_SIZE];
+    size_t record_length = sensor_trace_encode(record, sizeof(record), type, payload, length);
+    size_t prefix = sizeof(SENSOR_TRACE_LINE_PREFIX) - 1;
+    size_t line_length = prefix + 2 * record_length + 1;
+    if (record_length == 0 || size < line_length + 1) {
+        return 0;
+    }
+
+    memcpy(line, SENSOR_TRACE_LINE_PREFIX, prefix);
+    char *out = line + prefix;
+    for (size_t i = 0; i < record_length; i++) {
+        *out++ = HEX_DIGITS[record[i] >> 4];
+        *out++ = HEX_DIGITS[record[i] & 0x0F];
+    }
+    *out++ = '\n';
+    *out = '\0';
+    return line_length;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+size_t sensor_trace_parse_line(const char *line, uint8_t *record, size_t size) {
+    size_t prefix = sizeof(SENSOR_TRACE_LINE_PREFIX) - 1;
+    if (strncmp(line, SENSOR_TRACE_LINE_PREFIX, prefix) != 0) {
+        return 0;
+    }
+
+    const char *in = line + prefix;
+    size_t length = 0;
+    while (length < size) {
+        int high = hex_value(in[0]);
+        if (high < 0) {
+            break;
+        }
+        int low = hex_value(in[1]);
+        if (low < 0) {
+            return 0;
+        }
+        record[length++] = (uint8_t)(high << 4 | low);
+        in += 2;
+    }
+
+    // O tamanho declarado precisa bater com o que chegou: descarta linhas cortadas ou emendadas
+    if (length < 2 || length != 2u + record[1]) {
+        return 0;
+    }
+    return length;
+}
+
+bool sensor_trace_reader_init(sensor_trace_reader_t *reader, const uint8_t *data, size_t length) {
+    sensor_trace_header_t header;
+    if (length < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != SENSOR_TRACE_MAGIC || header.version != SENSOR_TRACE_VERSION) {
+        return false;
+    }
+    reader->data = data;
+    reader->length = length;
+    reader->offset = sizeof(header);
+    return true;
+}
+
+bool sensor_trace_next(sensor_trace_reader_t *reader, sensor_trace_record_t *record) {
+    if (reader->length - reader->offset < 2) {
+        return false;
+    }
+    const uint8_t *p = reader->data + reader->offset;
+    if (reader->length - reader->offset < 2u + p[1]) {
+        return false;
+    }
+    record->type = p[0];
+    record->length = p[1];
+    record->payload = p + 2;
+    reader->offset += 2u + p[1];
+    return true;
+}
@@ -0,0 +1,83 @@
+#ifndef SENSOR_TRACE_H
+#define SENSOR_TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Trace das leituras brutas dos sensores, para repetir no computador o processamento do núcleo 1
+// (lib/sensor_pipeline.c) sobre dados reais (ver host/replay.c).
+//
+// Arquivo: sensor_trace_header_t seguido de registros {tipo, tamanho, dados}, de 1 byte cada no
+// cabeçalho do registro; inteiros e floats em little-endian, como no RP2040. Na placa, cada registro
+// sai pela USB como uma linha de texto "TRC <hex>", misturada ao restante do log; o replay aceita
+// tanto o arquivo binário quanto o log com essas linhas.
+
+#define SENSOR_TRACE_MAGIC 0x43525445u  // "ETRC"
+#define SENSOR_TRACE_VERSION 1
+#define SENSOR_TRACE_LINE_PREFIX "TRC "
+#define SENSOR_TRACE_MAX_PAYLOAD 64
+#define SENSOR_TRACE_RECORD_SIZE (2 + SENSOR_TRACE_MAX_PAYLOAD)
+#define SENSOR_TRACE_LINE_SIZE (sizeof(SENSOR_TRACE_LINE_PREFIX) + 2 * SENSOR_TRACE_RECORD_SIZE + 1)
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+} sensor_trace_header_t;
+
+typedef enum {
+    SENSOR_TRACE_CALIB = 1,   // Calibração do BMP280: os 24 bytes dos registradores 0x88..0x9F
+    SENSOR_TRACE_CONFIG = 2,  // Offsets e limites (estacao_config_t) em vigor a partir daqui
+    SENSOR_TRACE_READ = 3,    // Uma tentativa de leitura dos dois sensores (sensor_trace_read_t)
+    SENSOR_TRACE_SAMPLE = 4,  // Fim do ciclo e a amostra que a placa produziu (sensor_trace_sample_t)
+} sensor_trace_type_t;
+
+#define SENSOR_TRACE_AHT20_DONE 0x01   // A transferência I2C do AHT20 terminou sem erro
+#define SENSOR_TRACE_BMP280_DONE 0x02  // A transferência I2C do BMP280 terminou sem erro
+
+typedef struct __attribute__((packed)) {
+    uint32_t time_us;   // time_us_32() no fim da leitura
+    uint8_t flags;      // SENSOR_TRACE_AHT20_DONE | SENSOR_TRACE_BMP280_DONE
+    uint8_t aht20[7];   // Status, umidade e temperatura (20 bits cada) e CRC-8
+    uint8_t bmp280[6];  // Registradores 0xF7..0xFC: pressão e temperatura brutas
+} sensor_trace_read_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t timestamp_ms;  // Instante da amostra, em ms desde o boot
+    float temperatura;
+    float umidade;
+    float pressao;
+    float altitude;
+    uint8_t alerta;         // 1 se a amostra acendeu o alerta na matriz
+} sensor_trace_sample_t;
+
+typedef struct {
+    uint8_t type;
+    uint8_t length;
+    const uint8_t *payload;
+} sensor_trace_record_t;
+
+typedef struct {
+    const uint8_t *data;
+    size_t length;
+    size_t offset;
+} sensor_trace_reader_t;
+
+// Escreve o registro em buffer (2 + length bytes); retorna o tamanho escrito, ou 0 se não couber
+size_t sensor_trace_encode(uint8_t *buffer, size_t size, uint8_t type, const void *payload, uint8_t length);
+
+// Formata o registro como linha "TRC <hex>\n"; retorna o tamanho da linha, ou 0 se não couber
+size_t sensor_trace_format_line(char *line, size_t size, uint8_t type, const void *payload, uint8_t length);
+
+// Recupera os bytes de um registro de uma linha "TRC <hex>" (o fim de linha é opcional). Retorna o
+// tamanho do registro, ou 0 se a linha não for de trace ou estiver truncada.
+size_t sensor_trace_parse_line(const char *line, uint8_t *record, size_t size);
+
+// Prepara a leitura de um arquivo de trace na memória; false se o cabeçalho não confere
+bool sensor_trace_reader_init(sensor_trace_reader_t *reader, const uint8_t *data, size_t length);
+
+// Próximo registro; false no fim do arquivo ou se o último registro estiver incompleto
+bool sensor_trace_next(sensor_trace_reader_t *reader, sensor_trace_record_t *record);
+
+#endif
@@ -0,0 +1,26 @@
+#include <string.h>
+#include "seqlock.h"
+
+void seqlock_write(seqlock_t *lock, void *data, const void *value, size_t size) {
+    uint32_t sequence = lock->sequence;
+
+    __atomic_store_n(&lock->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);  // O contador ímpar precisa aparecer antes dos dados
+    memcpy(data, value, size);
+    __atomic_store_n(&lock->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+uint32_t seqlock_read(seqlock_t *lock, const void *data, void *value, size_t size) {
+    uint32_t sequence;
+
+    do {
+        sequence = __atomic_load_n(&lock->sequence, __ATOMIC_ACQUIRE);
+        if (sequence & 1) {
+            continue;  // Escrita em andamento no outro núcleo
+        }
+        memcpy(value, data, size);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);  // A cópia precisa terminar antes de conferir o contador
+    } while ((sequence & 1) || __atomic_load_n(&lock->sequence, __ATOMIC_RELAXED) != sequence);
+
+    return sequence;
+}
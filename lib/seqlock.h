@@ -0,0 +1,24 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Seqlock: um escritor publica uma estrutura inteira e os leitores obtêm sempre uma cópia
+// consistente, sem desabilitar interrupções. O contador fica ímpar durante a escrita; o leitor
+// copia os dados e repete a cópia se o contador mudou no meio dela.
+//
+// Só pode haver um escritor por seqlock, e ele não pode ser interrompido por um leitor do mesmo
+// núcleo (o leitor esperaria para sempre por uma escrita que não consegue terminar).
+
+typedef struct {
+    uint32_t sequence;  // Par: dados estáveis. Ímpar: escrita em andamento
+} seqlock_t;
+
+// Copia size bytes de value para data, protegidos por lock
+void seqlock_write(seqlock_t *lock, void *data, const void *value, size_t size);
+
+// Copia size bytes de data para value; retorna o número de sequência da versão lida
+uint32_t seqlock_read(seqlock_t *lock, const void *data, void *value, size_t size);
+
+#endif
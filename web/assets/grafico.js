@@ -0,0 +1,50 @@
+// Grafico de linha minimo em canvas, usado no lugar do Chart.js. Desenha a serie, a legenda e as
+// linhas tracejadas dos limites minimo e maximo.
+function Grafico(canvas,opcoes){
+  this.canvas=canvas;this.opcoes=opcoes;this.labels=[];this.valores=[];
+  window.addEventListener('resize',()=>this.update());
+  this.update();
+}
+Grafico.prototype.update=function(){
+  const c=this.canvas,o=this.opcoes,r=window.devicePixelRatio||1;
+  const w=c.clientWidth,h=c.clientHeight;c.width=w*r;c.height=h*r;
+  const g=c.getContext('2d');g.setTransform(r,0,0,r,0,0);g.clearRect(0,0,w,h);
+  g.font='12px system-ui,sans-serif';
+  const esq=56,dir=12,topo=28,base=40,larg=w-esq-dir,alt=h-topo-base;
+  const limites=[o.min,o.max].filter(v=>typeof v==='number');
+  let lo=Math.min(...this.valores,...limites),hi=Math.max(...this.valores,...limites);
+  if(!isFinite(lo)){lo=0;hi=1;}
+  if(hi===lo){hi+=1;lo-=1;}
+  const folga=(hi-lo)*0.1;lo-=folga;hi+=folga;
+  const y=v=>topo+alt-(v-lo)/(hi-lo)*alt;
+  const n=Math.max(this.valores.length-1,1),x=i=>esq+i/n*larg;
+  // Eixo Y e grade.
+  g.strokeStyle='#e5e5e5';g.fillStyle='#666';g.lineWidth=1;g.textAlign='right';g.textBaseline='middle';
+  for(let i=0;i<=5;i++){const v=lo+(hi-lo)*i/5,py=y(v);
+    g.beginPath();g.moveTo(esq,py);g.lineTo(esq+larg,py);g.stroke();g.fillText(v.toFixed(1),esq-6,py);}
+  // Rotulos do eixo X.
+  g.textAlign='center';g.textBaseline='top';
+  const passo=Math.ceil(this.labels.length/6)||1;
+  this.labels.forEach((t,i)=>{if(i%passo===0)g.fillText(t,x(i),topo+alt+8);});
+  // Serie.
+  if(this.valores.length){
+    g.beginPath();this.valores.forEach((v,i)=>i?g.lineTo(x(i),y(v)):g.moveTo(x(i),y(v)));
+    g.strokeStyle=o.cor;g.lineWidth=2;g.stroke();
+    g.lineTo(x(this.valores.length-1),topo+alt);g.lineTo(x(0),topo+alt);g.closePath();
+    g.fillStyle=o.preenchimento;g.fill();
+  }
+  // Limites.
+  g.setLineDash([6,6]);g.textAlign='left';g.textBaseline='bottom';
+  [[o.min,'red','Mín: '],[o.max,'green','Máx: ']].forEach(([v,cor,nome])=>{
+    if(typeof v!=='number')return;
+    g.beginPath();g.moveTo(esq,y(v));g.lineTo(esq+larg,y(v));g.strokeStyle=cor;g.stroke();
+    g.fillStyle=cor;g.fillText(nome+v,esq+4,y(v)-2);});
+  g.setLineDash([]);
+  // Legenda.
+  g.fillStyle=o.cor;g.fillRect(w/2-70,8,28,10);g.fillStyle='#666';g.textBaseline='top';g.fillText(o.label,w/2-36,6);
+};
+Grafico.prototype.adicionar=function(label,valor,maximo){
+  this.labels.push(label);this.valores.push(valor);
+  if(this.labels.length>maximo){this.labels.shift();this.valores.shift();}
+  this.update();
+};
@@ -0,0 +1,123 @@
+# Monta as paginas do Web Display em tempo de compilacao.
+#
+# Os arquivos de web/assets recebem no nome um hash do conteudo (ex.: /assets/app.1a2b3c4d.css), para
+# que o navegador possa guarda-los indefinidamente. Cada pagina eh a concatenacao de header.html,
+# nav.html, o conteudo da pagina e footer.html, com as referencias @ASSET_...@ e @MAX_CHART_POINTS@
+# substituidas. Tudo eh comprimido com gzip e gravado em OUTPUT como arrays C, para ser enviado direto
+# da flash com Content-Encoding: gzip.
+#
+# Uso: cmake -DWEB_DIR=<web> -DWORK_DIR=<dir> -DOUTPUT=<web_pages.h> -DMAX_CHART_POINTS=<n> -P web_pages.cmake
+
+cmake_minimum_required(VERSION 3.19)
+
+# Paginas geradas: <arquivo de conteudo> <nome do array>
+set(WEB_PAGES
+    inicio  WEB_PAGE_INICIO
+    config  WEB_PAGE_CONFIG
+    grafico WEB_PAGE_GRAFICO
+)
+
+# Arquivos de web/assets: <arquivo> <Content-Type>
+set(WEB_ASSETS
+    app.css     text/css
+    grafico.js  application/javascript
+)
+
+# Expressao que casa 16 bytes ja formatados, para quebrar as linhas do array.
+string(REPEAT "0x..," 16 BYTES_PER_LINE)
+
+# Comprime FILE com gzip e acrescenta a HEADER_TEXT o array ARRAY_NAME com o resultado, alem de
+# ARRAY_NAME_ETAG: uma ETag forte derivada do conteudo, que so muda quando o arquivo muda.
+function(web_embed FILE ARRAY_NAME)
+    file(REMOVE ${FILE}.gz)
+    file(ARCHIVE_CREATE OUTPUT ${FILE}.gz PATHS ${FILE} FORMAT raw COMPRESSION GZip COMPRESSION_LEVEL 9)
+
+    file(SIZE ${FILE} FILE_SIZE)
+    file(SIZE ${FILE}.gz GZIP_SIZE)
+    file(READ ${FILE}.gz GZIP_HEX HEX)
+
+    # Zera o MTIME do cabecalho gzip (bytes 4 a 7) para que o firmware nao mude a cada compilacao.
+    string(SUBSTRING "${GZIP_HEX}" 0 8 GZIP_MAGIC)
+    string(SUBSTRING "${GZIP_HEX}" 16 -1 GZIP_REST)
+    set(GZIP_HEX "${GZIP_MAGIC}00000000${GZIP_REST}")
+
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," GZIP_BYTES "${GZIP_HEX}")
+    string(REGEX REPLACE "(${BYTES_PER_LINE})" "\\1\n    " GZIP_BYTES "${GZIP_BYTES}")
+    string(REGEX REPLACE "\n    $" "" GZIP_BYTES "${GZIP_BYTES}")
+
+    get_filename_component(FILE_NAME ${FILE} NAME)
+    string(APPEND HEADER_TEXT "// ${FILE_NAME}: ${FILE_SIZE} bytes, ${GZIP_SIZE} bytes com gzip.\n")
+    string(APPEND HEADER_TEXT "static const uint8_t ${ARRAY_NAME}[] = {\n    ${GZIP_BYTES}\n};\n")
+
+    file(SHA256 ${FILE} FILE_HASH)
+    string(SUBSTRING ${FILE_HASH} 0 16 FILE_HASH)
+    string(APPEND HEADER_TEXT "#define ${ARRAY_NAME}_ETAG \"\\\"${FILE_HASH}\\\"\"\n\n")
+    set(HEADER_TEXT "${HEADER_TEXT}" PARENT_SCOPE)
+endfunction()
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+set(HEADER_TEXT "// Gerado por web/web_pages.cmake a partir de web/. Nao edite.\n\n")
+string(APPEND HEADER_TEXT "#ifndef WEB_PAGES_H\n#define WEB_PAGES_H\n\n#include <stdint.h>\n\n")
+string(APPEND HEADER_TEXT "// Arquivo estatico servido em /assets, com o hash do conteudo no nome.\n")
+string(APPEND HEADER_TEXT "typedef struct\n{\n")
+string(APPEND HEADER_TEXT "    const char *path;         // Caminho publico, ex.: /assets/app.1a2b3c4d.css.\n")
+string(APPEND HEADER_TEXT "    const char *content_type; // Valor do cabecalho Content-Type.\n")
+string(APPEND HEADER_TEXT "    const uint8_t *data;      // Conteudo comprimido com gzip.\n")
+string(APPEND HEADER_TEXT "    uint16_t length;          // Tamanho de data, em bytes.\n")
+string(APPEND HEADER_TEXT "    const char *etag;         // ETag forte do conteudo, ja entre aspas.\n")
+string(APPEND HEADER_TEXT "} web_asset_t;\n\n")
+
+set(ASSET_TABLE "")
+list(LENGTH WEB_ASSETS WEB_ASSETS_LENGTH)
+math(EXPR LAST_INDEX "${WEB_ASSETS_LENGTH} - 1")
+foreach(INDEX RANGE 0 ${LAST_INDEX} 2)
+    math(EXPR TYPE_INDEX "${INDEX} + 1")
+    list(GET WEB_ASSETS ${INDEX} ASSET)
+    list(GET WEB_ASSETS ${TYPE_INDEX} CONTENT_TYPE)
+
+    file(READ ${WEB_DIR}/assets/${ASSET} ASSET_CONTENT)
+    string(SHA256 ASSET_HASH "${ASSET_CONTENT}")
+    string(SUBSTRING ${ASSET_HASH} 0 8 ASSET_HASH)
+    get_filename_component(ASSET_BASE ${ASSET} NAME_WE)
+    get_filename_component(ASSET_EXT ${ASSET} LAST_EXT)
+    set(ASSET_PATH "/assets/${ASSET_BASE}.${ASSET_HASH}${ASSET_EXT}")
+
+    # Referencia usada pelas paginas, ex.: app.css -> @ASSET_APP_CSS@.
+    string(MAKE_C_IDENTIFIER ${ASSET} ASSET_ID)
+    string(TOUPPER ${ASSET_ID} ASSET_ID)
+    set(ASSET_${ASSET_ID} ${ASSET_PATH})
+    list(APPEND ASSET_IDS ${ASSET_ID})
+
+    file(WRITE ${WORK_DIR}/${ASSET} "${ASSET_CONTENT}")
+    web_embed(${WORK_DIR}/${ASSET} WEB_ASSET_${ASSET_ID})
+    string(APPEND ASSET_TABLE "    {\"${ASSET_PATH}\", \"${CONTENT_TYPE}\", WEB_ASSET_${ASSET_ID}, sizeof(WEB_ASSET_${ASSET_ID}), WEB_ASSET_${ASSET_ID}_ETAG},\n")
+endforeach()
+
+string(APPEND HEADER_TEXT "static const web_asset_t WEB_ASSETS[] = {\n${ASSET_TABLE}};\n")
+string(APPEND HEADER_TEXT "#define WEB_ASSET_COUNT (sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]))\n\n")
+
+file(READ ${WEB_DIR}/header.html PAGE_HEADER)
+file(READ ${WEB_DIR}/nav.html PAGE_NAV)
+file(READ ${WEB_DIR}/footer.html PAGE_FOOTER)
+
+list(LENGTH WEB_PAGES WEB_PAGES_LENGTH)
+math(EXPR LAST_INDEX "${WEB_PAGES_LENGTH} - 1")
+foreach(INDEX RANGE 0 ${LAST_INDEX} 2)
+    math(EXPR NAME_INDEX "${INDEX} + 1")
+    list(GET WEB_PAGES ${INDEX} PAGE)
+    list(GET WEB_PAGES ${NAME_INDEX} ARRAY_NAME)
+
+    file(READ ${WEB_DIR}/${PAGE}.html PAGE_CONTENT)
+    set(PAGE_TEXT "${PAGE_HEADER}${PAGE_NAV}${PAGE_CONTENT}${PAGE_FOOTER}")
+    string(REPLACE "@MAX_CHART_POINTS@" "${MAX_CHART_POINTS}" PAGE_TEXT "${PAGE_TEXT}")
+    foreach(ASSET_ID ${ASSET_IDS})
+        string(REPLACE "@ASSET_${ASSET_ID}@" "${ASSET_${ASSET_ID}}" PAGE_TEXT "${PAGE_TEXT}")
+    endforeach()
+    file(WRITE ${WORK_DIR}/${PAGE}.html "${PAGE_TEXT}")
+
+    web_embed(${WORK_DIR}/${PAGE}.html ${ARRAY_NAME})
+endforeach()
+
+string(APPEND HEADER_TEXT "#endif\n")
+file(WRITE ${OUTPUT} "${HEADER_TEXT}")